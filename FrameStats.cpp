@@ -0,0 +1,59 @@
+#include "FrameStats.h"
+#include <algorithm>
+
+#define FRAME_STATS_BUCKET_MS   0.05
+#define FRAME_STATS_RANGE_MS    250.0
+
+FrameStats::FrameStats()
+    : buckets((size_t) (FRAME_STATS_RANGE_MS / FRAME_STATS_BUCKET_MS) + 1, 0), frames(0), total(0), slowest(0)
+{
+}
+
+void FrameStats::add(double ms)
+{
+    size_t bucket = std::min(buckets.size() - 1, (size_t) (std::max(ms, 0.0) / FRAME_STATS_BUCKET_MS));
+    buckets[bucket]++;
+    frames++;
+    total += ms;
+    slowest = std::max(slowest, ms);
+}
+
+void FrameStats::reset()
+{
+    std::fill(buckets.begin(), buckets.end(), 0);
+    frames = 0;
+    total = 0;
+    slowest = 0;
+}
+
+long FrameStats::count() const
+{
+    return frames;
+}
+
+double FrameStats::mean() const
+{
+    return frames > 0 ? total / frames : 0;
+}
+
+double FrameStats::longest() const
+{
+    return slowest;
+}
+
+double FrameStats::percentile(double p) const
+{
+    if (frames == 0)
+        return 0;
+
+    // Smallest bucket with at least p of the frames at or below it
+    long rank = std::max(1L, (long) (p * frames + 0.5));
+    long seen = 0;
+    for (size_t i = 0; i < buckets.size(); i++)
+    {
+        seen += buckets[i];
+        if (seen >= rank && i + 1 < buckets.size())
+            return std::min((i + 1) * FRAME_STATS_BUCKET_MS, slowest);
+    }
+    return slowest;
+}
@@ -0,0 +1,29 @@
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include <vector>
+
+// Frame times in a fixed histogram of FRAME_STATS_BUCKET_MS buckets, so
+// runs of any length give percentiles without allocating per frame.
+// Frames longer than FRAME_STATS_RANGE_MS share the last bucket.
+class FrameStats
+{
+public:
+    FrameStats();
+
+    void add(double ms);
+    void reset();
+
+    long count() const;
+    double mean() const;
+    double longest() const;
+    double percentile(double p) const;  // upper edge of the bucket, p in [0, 1]
+
+private:
+    std::vector<long> buckets;
+    long frames;
+    double total;
+    double slowest;
+};
+
+#endif // FRAMESTATS_H
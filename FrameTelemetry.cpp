@@ -0,0 +1,149 @@
+#include "FrameTelemetry.h"
+#include <algorithm>
+
+#define TELEMETRY_QUEUE_SIZE    4096        // records, a power of two
+#define TELEMETRY_POLL_MS       20          // writer sleep when the queue is empty
+
+FrameTelemetry::FrameTelemetry()
+    : file(nullptr), format(eFormatCsv), windowSize(1), window(), droppedRecords(0), startTime(0),
+      queue(TELEMETRY_QUEUE_SIZE), head(0), tail(0), stopping(false)
+{
+}
+
+FrameTelemetry::~FrameTelemetry()
+{
+    close();
+}
+
+bool FrameTelemetry::open(const char *fileName, Format fileFormat, int frames)
+{
+    close();
+    file = std::fopen(fileName, "w");
+    if (!file)
+        return false;
+
+    format = fileFormat;
+    windowSize = std::max(1, frames);
+    window = Record();
+    droppedRecords = 0;
+    head = 0;
+    tail = 0;
+    stopping = false;
+
+    start = std::chrono::steady_clock::now();
+    startTime = std::chrono::duration<double, std::milli>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    if (format == eFormatCsv)
+        std::fputs("timestamp,frames,interval_ms,interval_max_ms,update_ms,upload_ms,draw_ms,ripples,retired,dirty_bytes,missed_frames,missed_budgets\n", file);
+
+    writer = std::thread(&FrameTelemetry::run, this);
+    return true;
+}
+
+void FrameTelemetry::close()
+{
+    if (!file)
+        return;
+
+    // The last window, even when short; it holds its real frame count
+    if (window.frames > 0)
+        push();
+
+    stopping = true;
+    writer.join();
+    std::fclose(file);
+    file = nullptr;
+}
+
+bool FrameTelemetry::isOpen() const
+{
+    return file != nullptr;
+}
+
+long FrameTelemetry::dropped() const
+{
+    return droppedRecords;
+}
+
+void FrameTelemetry::add(const Frame& frame)
+{
+    if (!file)
+        return;
+
+    window.frames++;
+    window.intervalMs += frame.intervalMs;
+    window.intervalMaxMs = std::max(window.intervalMaxMs, frame.intervalMs);
+    window.updateMs += frame.updateMs;
+    window.uploadMs += frame.uploadMs;
+    if (frame.drawMs >= 0)
+    {
+        window.drawMs += frame.drawMs;
+        window.drawFrames++;
+    }
+    window.ripples = frame.ripples;
+    window.retired += frame.retired;
+    window.dirtyBytes += frame.dirtyBytes;
+    window.missedFrames += frame.missedFrame;
+    window.missedBudgets += frame.missedBudget;
+
+    if (window.frames >= windowSize)
+        push();
+}
+
+void FrameTelemetry::push()
+{
+    window.time = startTime + std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // A full queue drops the record rather than waiting for the writer
+    unsigned slot = head.load(std::memory_order_relaxed);
+    if (slot - tail.load(std::memory_order_acquire) < TELEMETRY_QUEUE_SIZE)
+    {
+        queue[slot & (TELEMETRY_QUEUE_SIZE-1)] = window;
+        head.store(slot + 1, std::memory_order_release);
+    }
+    else
+    {
+        droppedRecords++;
+    }
+    window = Record();
+}
+
+void FrameTelemetry::run()
+{
+    for (;;)
+    {
+        // Read the flag first, so records pushed before close are written
+        bool last = stopping;
+        unsigned slot = tail.load(std::memory_order_relaxed);
+        unsigned end = head.load(std::memory_order_acquire);
+        for (; slot != end; slot++)
+        {
+            write(queue[slot & (TELEMETRY_QUEUE_SIZE-1)]);
+            tail.store(slot + 1, std::memory_order_release);
+        }
+        std::fflush(file);
+
+        if (last)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(TELEMETRY_POLL_MS));
+    }
+}
+
+void FrameTelemetry::write(const Record& record)
+{
+    // Means over the window; no GPU time reads as an empty field or null
+    float n = record.frames;
+    char draw[32];
+    if (record.drawFrames > 0)
+        std::snprintf(draw, sizeof(draw), "%.3f", record.drawMs / record.drawFrames);
+    else
+        std::snprintf(draw, sizeof(draw), "%s", format == eFormatCsv ? "" : "null");
+
+    const char *pattern = format == eFormatCsv ?
+        "%.3f,%d,%.3f,%.3f,%.3f,%.3f,%s,%d,%d,%lld,%d,%d\n" :
+        "{\"timestamp\":%.3f,\"frames\":%d,\"interval_ms\":%.3f,\"interval_max_ms\":%.3f,\"update_ms\":%.3f,\"upload_ms\":%.3f,"
+        "\"draw_ms\":%s,\"ripples\":%d,\"retired\":%d,\"dirty_bytes\":%lld,\"missed_frames\":%d,\"missed_budgets\":%d}\n";
+
+    std::fprintf(file, pattern, record.time, record.frames, record.intervalMs / n, record.intervalMaxMs, record.updateMs / n,
+                 record.uploadMs / n, draw, record.ripples, record.retired, record.dirtyBytes, record.missedFrames, record.missedBudgets);
+}
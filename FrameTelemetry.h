@@ -0,0 +1,90 @@
+#ifndef FRAMETELEMETRY_H
+#define FRAMETELEMETRY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// Frame records for offline analysis, as CSV or JSON lines, one per frame
+// or per window of frames. The render thread only sums frames into the
+// current window and pushes finished records into a bounded single-producer,
+// single-consumer ring; a writer thread formats and writes them. When the
+// writer falls behind, records are dropped and counted instead of stalling
+// a frame.
+class FrameTelemetry
+{
+public:
+
+    enum Format
+    {
+        eFormatCsv,
+        eFormatJson             // JSON lines, one object per record
+    };
+
+    struct Frame
+    {
+        float intervalMs;       // since the previous frame
+        float updateMs;         // CPU, including the upload
+        float uploadMs;         // CPU, buffer and texture writes
+        float drawMs;           // GPU, negative when unknown
+        int ripples;
+        int retired;            // ripples retired by this frame's update
+        long long dirtyBytes;   // uploaded by this frame's update
+        bool missedFrame;       // interval over the display deadline
+        bool missedBudget;      // update and draw over the work budget
+    };
+
+    FrameTelemetry();
+    virtual ~FrameTelemetry();
+
+    // 'window' frames make one record: times are means, the interval also
+    // has its longest, counts and bytes are summed and misses counted
+    bool open(const char *fileName, Format format, int window);
+    void close();               // writes what is queued and the last window, then stops the writer
+    bool isOpen() const;
+
+    void add(const Frame& frame);   // render thread only
+    long dropped() const;
+
+private:
+
+    struct Record
+    {
+        double time;            // ms since the Unix epoch, at the last frame
+        int frames;
+        float intervalMs;
+        float intervalMaxMs;
+        float updateMs;
+        float uploadMs;
+        float drawMs;
+        int drawFrames;         // frames with a GPU time
+        int ripples;
+        int retired;
+        long long dirtyBytes;
+        int missedFrames;
+        int missedBudgets;
+    };
+
+    void push();                // render thread, ends the window
+    void run();
+    void write(const Record& record);
+
+    FILE *file;
+    Format format;
+    int windowSize;
+    Record window;              // being summed on the render thread
+    long droppedRecords;
+
+    std::chrono::steady_clock::time_point start;
+    double startTime;           // ms since the Unix epoch when opened
+
+    std::vector<Record> queue;  // TELEMETRY_QUEUE_SIZE slots
+    std::atomic<unsigned> head; // next slot the render thread fills
+    std::atomic<unsigned> tail; // next slot the writer reads
+    std::atomic<bool> stopping;
+    std::thread writer;
+};
+
+#endif // FRAMETELEMETRY_H
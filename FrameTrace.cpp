@@ -0,0 +1,99 @@
+#include "FrameTrace.h"
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define TRACE_RING_SIZE         16384       // zones kept per thread, a power of two
+
+struct TraceEvent
+{
+    const char *name;
+    long long begin;
+    long long end;
+};
+
+struct TraceRing
+{
+    std::vector<TraceEvent> events;
+    std::atomic<unsigned long long> written;    // zones recorded, the next slot modulo the size
+    std::string name;
+    int id;
+};
+
+// Rings outlive their threads, so the zones of a finished worker still
+// make it into the dump
+static std::mutex ringMutex;
+static std::vector<TraceRing*> rings;
+static const long long traceStart = FrameTrace::now();
+
+static TraceRing *threadRing()
+{
+    thread_local TraceRing *ring = nullptr;
+    if (!ring)
+    {
+        ring = new TraceRing();
+        ring->events.resize(TRACE_RING_SIZE);
+        ring->written = 0;
+
+        std::lock_guard<std::mutex> lock(ringMutex);
+        ring->id = (int) rings.size() + 1;
+        ring->name = "thread " + std::to_string(ring->id);
+        rings.push_back(ring);
+    }
+    return ring;
+}
+
+void FrameTrace::setThreadName(const char *name)
+{
+    TraceRing *ring = threadRing();
+    std::lock_guard<std::mutex> lock(ringMutex);
+    ring->name = name;
+}
+
+void FrameTrace::record(const char *name, long long begin, long long end)
+{
+    TraceRing *ring = threadRing();
+    unsigned long long index = ring->written.load(std::memory_order_relaxed);
+    TraceEvent &event = ring->events[index & (TRACE_RING_SIZE-1)];
+    event.name = name;
+    event.begin = begin;
+    event.end = end;
+    ring->written.store(index + 1, std::memory_order_release);
+}
+
+bool FrameTrace::dump(const char *fileName)
+{
+    FILE *file = std::fopen(fileName, "w");
+    if (!file)
+        return false;
+
+    std::lock_guard<std::mutex> lock(ringMutex);
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+
+    const char *separator = "";
+    for (TraceRing *ring : rings)
+    {
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                     separator, ring->id, ring->name.c_str());
+        separator = ",\n";
+
+        unsigned long long written = ring->written.load(std::memory_order_acquire);
+        unsigned long long first = written > TRACE_RING_SIZE ? written - TRACE_RING_SIZE : 0;
+        for (unsigned long long i = first; i < written; i++)
+        {
+            TraceEvent event = ring->events[i & (TRACE_RING_SIZE-1)];
+
+            // The thread may have lapped the ring while this one was copied
+            if (ring->written.load(std::memory_order_acquire) >= i + TRACE_RING_SIZE)
+                continue;
+
+            std::fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"ripple\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                         event.name, (event.begin - traceStart) / 1e3, (event.end - event.begin) / 1e3, ring->id);
+        }
+    }
+
+    std::fputs("\n]}\n", file);
+    return std::fclose(file) == 0;
+}
@@ -0,0 +1,58 @@
+#ifndef FRAMETRACE_H
+#define FRAMETRACE_H
+
+#include <chrono>
+
+// Scoped trace zones, dumped as Chrome trace-event JSON for chrome://tracing
+// or Perfetto. Each thread writes its zones into its own ring of the last
+// TRACE_RING_SIZE, so recording takes no lock. Zones only exist in builds
+// with RIPPLE_TRACE defined (qmake CONFIG+=trace); otherwise TRACE_ZONE
+// expands to nothing.
+//
+//   TRACE_ZONE("RippleEffect::update");    // from here to the end of the scope
+class FrameTrace
+{
+public:
+
+    // Name for the calling thread in the dump; threads left unnamed show
+    // as "thread N"
+    static void setThreadName(const char *name);
+
+    // Zones recorded so far by every thread. Threads still recording may
+    // overwrite some while they are copied; those are left out.
+    static bool dump(const char *fileName);
+
+    static long long now();     // ns on the steady clock
+
+    class Zone
+    {
+    public:
+        explicit Zone(const char *name) : name(name), begin(now()) { }
+        ~Zone() { record(name, begin, now()); }
+
+    private:
+        const char *name;       // a literal, kept by pointer
+        long long begin;
+    };
+
+private:
+    static void record(const char *name, long long begin, long long end);
+};
+
+inline long long FrameTrace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#define TRACE_CONCAT_(a, b)     a##b
+#define TRACE_CONCAT(a, b)      TRACE_CONCAT_(a, b)
+
+#ifdef RIPPLE_TRACE
+#define TRACE_ZONE(name)        FrameTrace::Zone TRACE_CONCAT(traceZone, __LINE__)(name)
+#define TRACE_THREAD(name)      FrameTrace::setThreadName(name)
+#else
+#define TRACE_ZONE(name)
+#define TRACE_THREAD(name)
+#endif
+
+#endif // FRAMETRACE_H
@@ -1,10 +1,58 @@
 #include "GLWidget.h"
+#include "RippleTable.h"
+#include "RippleGeometry.h"
+#include "StartupGraph.h"
+#include "FrameTrace.h"
 #include <QMouseEvent>
+#include <QWheelEvent>
+#include <QLoggingCategory>
+#include <QFile>
+#include <cmath>
 
-GLWidget::GLWidget(QWidget *parent) : QOpenGLWidget(parent), ripple(nullptr), speed(7), idxTexture(0)
+#define RENDER_SCALE_MIN        0.5f
+#define RENDER_SCALE_STEP       0.05f
+#define RENDER_SCALE_HEADROOM   0.6f        // step back up below this share of the target
+#define RENDER_SCALE_COOLDOWN   30          // frames between two scale changes
+#define SCENE_TARGET_MS         8.f
+#define ZOOM_MIN                0.1f
+#define ZOOM_MAX                8.f
+#define ZOOM_STEP               1.2f        // per wheel notch
+#define TILE_CACHE_BUDGET       (64 << 20)  // bytes of tile cache per tiled image
+#define TEXTURE_BUDGET          (256 << 20) // bytes of resident playlist images
+#define TILE_TEXCOORD_MARGIN    0.02f       // around the view, for displaced texcoords
+#define FRAME_BUDGET_MS         12.f        // update and scene time the adaptive quality aims for
+#define FRAME_INTERVAL_MS       12          // between two updates
+#define FRAME_DEADLINE_MS       16.7f       // one refresh at 60 Hz, longer intervals count as missed
+
+Q_LOGGING_CATEGORY(lcReplay, "ripple.replay")
+Q_LOGGING_CATEGORY(lcWorkload, "ripple.workload")
+
+GLWidget::GLWidget(QWidget *parent) : QOpenGLWidget(parent), textureBudget(TEXTURE_BUDGET), textures(nullptr), ripple(nullptr),
+    frameInterval(FRAME_INTERVAL_MS), updateCount(0), speed(7), idxTexture(0), distort(1), gridSize(GRID_SIZE_X), surfaceSize(512, 512), zoom(1.f), dragging(false),
+    sceneFbo(nullptr), sceneQuery(0), drawMonitor(0), drawMs(-1), renderScale(1.f), dynamicScale(false), sceneTarget(SCENE_TARGET_MS), scaleCooldown(0),
+    quality(FRAME_BUDGET_MS), adaptiveQuality(false), keyframeInterval(1), updateMs(0),
+    recordStart(0), replayStart(0), replayNext(0), replaying(false), emitter(nullptr), emitterOverflow(false), evaluationTotal(0),
+    hud(nullptr), hudVisible(false), uploadMs(0), uploadBytes(0), retired(0), shaderMs(0), firstFrame(true)
 {
+    startupClock.start();
+
+    const char* files[] = {
+        ":/textures/Underwater-Fish-Wallpaper.jpg",
+        ":/textures/water_water_0056_01.jpg",
+        ":/textures/stones-770264.jpg"
+    };
+
     for (int i = 0; i < 3; i++)
-        textures[i] = nullptr;
+        imageFiles << files[i];
+    for (int i = 0; i < QUALITY_MESH_LEVELS; i++)
+        meshes[i] = nullptr;
+    for (int i = 0; i < 3; i++)
+    {
+        sceneQueries[i] = nullptr;
+        sceneQueryPending[i] = false;
+        drawMonitors[i] = nullptr;
+        drawMonitorPending[i] = false;
+    }
 }
 
 GLWidget::~GLWidget()
@@ -12,18 +60,185 @@ GLWidget::~GLWidget()
     // Make sure the context is current when deleting the texture
     // and the buffers.
     makeCurrent();
+    delete textures;
     for (int i = 0; i < 3; i++)
-        delete textures[i];
-    delete ripple;
+    {
+        delete sceneQueries[i];
+        delete drawMonitors[i];
+    }
+    delete sceneFbo;
+    delete hud;
+    for (int i = 0; i < QUALITY_MESH_LEVELS; i++)
+        delete meshes[i];
+    doneCurrent();
+    delete emitter;
+
+    telemetry.close();
+    if (telemetry.dropped() > 0)
+        qWarning("GLWidget: %ld telemetry records dropped, the writer fell behind", telemetry.dropped());
+}
+
+void GLWidget::setSurfaceSize(const QSize& size)
+{
+    surfaceSize = size;
+}
+
+void GLWidget::setImageFile(int index, const QString& fileName)
+{
+    if (index < 0 || index >= imageFiles.size())
+        return;
+
+    QStringList files = imageFiles;
+    files[index] = fileName;
+    setPlaylist(files);
+}
+
+void GLWidget::setPlaylist(const QStringList& files)
+{
+    imageFiles = files;
+    idxTexture = qBound(0, idxTexture, qMax(0, files.size()-1));
+    if (!textures)
+        return;
+
+    // Releasing the old entries deletes their textures
+    makeCurrent();
+    textures->setPlaylist(files);
+    textures->prefetch(idxTexture);
     doneCurrent();
 }
 
+void GLWidget::setTextureBudget(qint64 bytes)
+{
+    textureBudget = bytes;
+    if (!textures)
+        return;
+
+    // Textures over the new budget are deleted right away
+    makeCurrent();
+    textures->setBudget(bytes);
+    doneCurrent();
+}
+
+bool GLWidget::startRecording(const QString& fileName)
+{
+    if (!recording.create(QFile::encodeName(fileName).constData(), surfaceSize.width(), surfaceSize.height()))
+    {
+        qWarning("GLWidget: could not write the ripple log %s", qPrintable(fileName));
+        return false;
+    }
+
+    recordStart = updateCount;
+    recordClock.start();
+    return true;
+}
+
+bool GLWidget::startReplay(const QString& fileName, bool fast)
+{
+    if (!replay.load(QFile::encodeName(fileName).constData()))
+    {
+        qWarning("GLWidget: could not read the ripple log %s", qPrintable(fileName));
+        return false;
+    }
+
+    // Ripples land where they did only on a surface of the recorded size
+    QSize size(qRound(replay.width()), qRound(replay.height()));
+    if (!ripple)
+        surfaceSize = size;
+    else if (size != surfaceSize)
+        qCWarning(lcReplay, "log recorded on a %dx%d surface, replaying on %dx%d",
+                  size.width(), size.height(), surfaceSize.width(), surfaceSize.height());
+
+    replayStart = updateCount;
+    replayNext = 0;
+    replaying = true;
+
+    // Quality changes move and trim ripples, so a replay runs at full quality
+    if (adaptiveQuality && ripple)
+    {
+        quality.reset();
+        makeCurrent();
+        applyQuality();
+        doneCurrent();
+    }
+
+    // At full speed updates run back to back instead of on the timer rate
+    if (fast)
+        setUnthrottled(true);
+
+    qCInfo(lcReplay, "replaying %d ripples from %s", (int) replay.events().size(), qPrintable(fileName));
+    return true;
+}
+
+bool GLWidget::setEmitter(const QString& spec)
+{
+    RippleEmitter::Config config;
+    if (!RippleEmitter::parse(spec.toStdString(), config))
+    {
+        qWarning("GLWidget: unknown workload %s", qPrintable(spec));
+        return false;
+    }
+
+    delete emitter;
+    emitter = new RippleEmitter(config, surfaceSize.width(), surfaceSize.height());
+    emitterOverflow = false;
+    return true;
+}
+
+bool GLWidget::startTelemetry(const QString& fileName, int window)
+{
+    FrameTelemetry::Format format = fileName.endsWith(".csv", Qt::CaseInsensitive) ? FrameTelemetry::eFormatCsv : FrameTelemetry::eFormatJson;
+    if (!telemetry.open(QFile::encodeName(fileName).constData(), format, window))
+    {
+        qWarning("GLWidget: could not write the telemetry log %s", qPrintable(fileName));
+        return false;
+    }
+    return true;
+}
+
+void GLWidget::setUnthrottled(bool enabled)
+{
+    frameInterval = enabled ? 0 : FRAME_INTERVAL_MS;
+    if (ripple)
+        startFrames();
+}
+
+const FrameStats& GLWidget::frameStats() const
+{
+    return stats;
+}
+
+double GLWidget::evaluationRate() const
+{
+    qint64 ns = runClock.isValid() ? runClock.nsecsElapsed() : 0;
+    return ns > 0 ? evaluationTotal / (ns / 1e9) : 0;
+}
+
 void GLWidget::initializeGL()
 {
+    TRACE_THREAD("gui");
     initializeOpenGLFunctions();
 
-    initShaders();
-    initTextures();
+    // Start-up as a task graph: the first images start decoding, the mesh
+    // tables are built on the worker pool while this thread compiles the
+    // shaders, and the meshes are uploaded once both are done
+    StartupGraph graph;
+    graph.add("textures", StartupGraph::eThreadGL, [this]() { initTextures(); });
+
+    std::vector<int> ready;
+    for (int i = 0; i < QUALITY_MESH_LEVELS; i++)
+    {
+        int cols = meshCols(i);
+        int rows = meshRows(i);
+        ready.push_back(graph.add(QString("tables %1x%2").arg(cols).arg(rows), StartupGraph::eThreadWorker,
+                                  [cols, rows]() { RippleGeometry::prepare(cols, rows); }));
+    }
+
+    ready.push_back(graph.add("shaders", StartupGraph::eThreadGL, [this]() { initShaders(); }));
+    graph.add("meshes", StartupGraph::eThreadGL, [this]() { initMeshes(); }, ready);
+    graph.add("queries", StartupGraph::eThreadGL, [this]() { initQueries(); });
+
+    graph.run();
+    graph.timeline();
 
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     // Enable depth buffer
@@ -31,8 +246,66 @@ void GLWidget::initializeGL()
     // Enable back face culling
     glEnable(GL_CULL_FACE);
 
-    ripple = new RippleEffect(&program, 512, 512);
-    timer.start(12, this);
+    startFrames();
+}
+
+void GLWidget::initMeshes()
+{
+    // Coarser meshes are built up front, so the quality controller can
+    // switch between them without a stall
+    for (int i = 0; i < QUALITY_MESH_LEVELS; i++)
+    {
+        meshes[i] = new RippleSurface(&program, surfaceSize.width(), surfaceSize.height());
+        meshes[i]->setMeshSize(meshCols(i), meshRows(i));
+        meshes[i]->setDistortMode(distort == 0 ? RippleEffect::eDistortVertices : RippleEffect::eDistortTexCoords);
+        meshes[i]->setKeyframeInterval(keyframeInterval);
+    }
+    ripple = meshes[0];
+    updateQualityLadder();
+}
+
+void GLWidget::initQueries()
+{
+    // A ring of timer queries, read a few frames late so they never stall
+    for (int i = 0; i < 3; i++)
+    {
+        sceneQueries[i] = new QOpenGLTimerQuery();
+        if (!sceneQueries[i]->create())
+        {
+            for (int j = 0; j <= i; j++)
+            {
+                delete sceneQueries[j];
+                sceneQueries[j] = nullptr;
+            }
+            break;
+        }
+    }
+
+    // Timestamps rather than elapsed time, which can't nest in the scene query
+    for (int i = 0; i < 3 && sceneQueries[0]; i++)
+    {
+        drawMonitors[i] = new QOpenGLTimeMonitor();
+        drawMonitors[i]->setSampleCount(2);
+        if (!drawMonitors[i]->create())
+        {
+            for (int j = 0; j <= i; j++)
+            {
+                delete drawMonitors[j];
+                drawMonitors[j] = nullptr;
+            }
+            break;
+        }
+    }
+}
+
+int GLWidget::meshCols(int level) const
+{
+    return qMax(4, gridSize >> level);
+}
+
+int GLWidget::meshRows(int level) const
+{
+    return qMax(4, gridSize >> level);
 }
 
 void GLWidget::resizeGL(int w, int h)
@@ -43,14 +316,41 @@ void GLWidget::resizeGL(int w, int h)
 
 void GLWidget::paintGL()
 {
+    TRACE_ZONE("GLWidget::paintGL");
+    // Draw the scene offscreen at reduced size, then upscale it
+    QSize size = sceneSize();
+    QSize target = this->size() * devicePixelRatioF();
+    bool scaled = size != target && QOpenGLFramebufferObject::hasOpenGLFramebufferBlit();
+    if (scaled)
+    {
+        if (!sceneFbo || sceneFbo->size() != size)
+        {
+            delete sceneFbo;
+            sceneFbo = new QOpenGLFramebufferObject(size, QOpenGLFramebufferObject::CombinedDepthStencil);
+        }
+        sceneFbo->bind();
+        glViewport(0, 0, size.width(), size.height());
+    }
+
+    QOpenGLTimerQuery *query = sceneQueries[sceneQuery];
+    if (query)
+        query->begin();
+    else
+        sceneClock.start();
+
     // Clear color and depth buffer
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    textures[idxTexture]->bind();
+    // Offscreen ripple passes may have bound their own programs
+    program.bind();
+    textures->update();
+    textures->bind(idxTexture, textureRect(), &program);
 
     // Calculate model view transformation
     QMatrix4x4 matrix;
     matrix.translate(this->size().width()/2,  this->size().height()/2, 0);
+    matrix.scale(zoom, zoom, 1.f);
+    matrix.translate(-pan.x(), -pan.y(), 0);
 
     // Set modelview-projection matrix
     program.setUniformValue("mvp_matrix", projection * matrix);
@@ -58,42 +358,383 @@ void GLWidget::paintGL()
     // Use texture unit 0 which contains cube.png
     program.setUniformValue("texture", 0);
 
-    // Draw Ripple
+    // Draw Ripple, skipping chunks out of view. drawMs only holds a result
+    // that arrived this frame, so the overlay never counts one twice.
+    QOpenGLTimeMonitor *monitor = hudVisible || telemetry.isOpen() ? drawMonitors[drawMonitor] : nullptr;
+    drawMs = -1;
+    if (monitor)
+    {
+        monitor->reset();
+        monitor->recordSample();
+    }
+    else
+    {
+        // Samples from before a pause are stale by the time it ends
+        for (int i = 0; i < 3; i++)
+            drawMonitorPending[i] = false;
+    }
+    ripple->setViewport(viewRect());
     ripple->draw();
+    if (monitor)
+    {
+        monitor->recordSample();
+        drawMonitorPending[drawMonitor] = true;
+        drawMonitor = (drawMonitor + 1) % 3;
+        QOpenGLTimeMonitor *oldest = drawMonitors[drawMonitor];
+        if (drawMonitorPending[drawMonitor] && oldest->isResultAvailable())
+            drawMs = oldest->waitForIntervals()[0] / 1e6f;
+        drawMonitorPending[drawMonitor] = false;
+    }
+
+    if (scaled)
+    {
+        // Bilinear upscale into the widget's framebuffer
+        sceneFbo->release();
+        QOpenGLFramebufferObject::blitFramebuffer(nullptr, QRect(QPoint(0, 0), target), sceneFbo, QRect(QPoint(0, 0), size),
+                                                  GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        glViewport(0, 0, target.width(), target.height());
+    }
+
+    // Feed the controllers with the oldest query, which is done by now
+    float sceneMs = -1;
+    if (query)
+    {
+        query->end();
+        sceneQueryPending[sceneQuery] = true;
+
+        // The first frames leave slots that were never begun
+        sceneQuery = (sceneQuery + 1) % 3;
+        QOpenGLTimerQuery *oldest = sceneQueries[sceneQuery];
+        if (sceneQueryPending[sceneQuery] && oldest->isResultAvailable())
+            sceneMs = oldest->waitForResult() / 1e6f;
+        sceneQueryPending[sceneQuery] = false;
+    }
+    else
+    {
+        sceneMs = sceneClock.nsecsElapsed() / 1e6f;
+    }
+
+    if (sceneMs >= 0)
+    {
+        adjustRenderScale(sceneMs);
+        adjustQuality(updateMs + sceneMs);
+    }
+
+    // Time between frames, for the summary
+    float frameMs = 0;
+    if (frameClock.isValid())
+    {
+        frameMs = frameClock.nsecsElapsed() / 1e6f;
+        stats.add(frameMs);
+    }
+    else
+    {
+        runClock.start();
+    }
+    frameClock.start();
+
+    if (hudVisible)
+    {
+        if (!hud)
+            hud = new PerfHud();
+
+        PerfHud::Frame frame =
+        {
+            frameMs,
+            updateMs,
+            uploadMs,
+            drawMs,
+            uploadBytes,
+            ripple->rippleCount(),
+            ripple->vertexCount()
+        };
+        hud->add(frame);
+        hud->draw(target.width(), target.height(), devicePixelRatioF());
+    }
+
+    if (telemetry.isOpen())
+    {
+        FrameTelemetry::Frame frame =
+        {
+            frameMs,
+            updateMs,
+            uploadMs,
+            drawMs,
+            ripple->rippleCount(),
+            retired,
+            uploadBytes,
+            frameMs > FRAME_DEADLINE_MS,
+            sceneMs >= 0 && updateMs + sceneMs > FRAME_BUDGET_MS
+        };
+        telemetry.add(frame);
+    }
+
+    if (firstFrame)
+    {
+        qCInfo(lcStartup, "first frame %lld ms after start, shaders built in %.1f ms", startupClock.elapsed(), shaderMs);
+        firstFrame = false;
+    }
+}
+
+QSize GLWidget::sceneSize() const
+{
+    QSize target = this->size() * devicePixelRatioF();
+    return QSize(qMax(1, qRound(target.width() * renderScale)), qMax(1, qRound(target.height() * renderScale)));
+}
+
+void GLWidget::adjustRenderScale(float ms)
+{
+    if (!dynamicScale)
+        return;
+
+    if (scaleCooldown > 0)
+    {
+        scaleCooldown--;
+        return;
+    }
+
+    // Fragment cost follows the pixel count, so step down quickly and only
+    // step back up with plenty of headroom
+    float scale = renderScale;
+    if (ms > sceneTarget)
+        scale -= RENDER_SCALE_STEP;
+    else if (ms < sceneTarget * RENDER_SCALE_HEADROOM)
+        scale += RENDER_SCALE_STEP;
+    scale = qBound(RENDER_SCALE_MIN, scale, 1.f);
+
+    if (scale != renderScale)
+    {
+        renderScale = scale;
+        scaleCooldown = RENDER_SCALE_COOLDOWN;
+        emit renderScaleChanged(qRound(renderScale * 100));
+    }
+}
+
+void GLWidget::adjustQuality(float ms)
+{
+    if (adaptiveQuality && !replaying && quality.frame(ms))
+        applyQuality();
+}
+
+void GLWidget::applyQuality()
+{
+    if (!ripple)
+        return;
+
+    const QualityController::Level &level = quality.current();
+
+    RippleSurface *next = meshes[level.meshLevel];
+    if (next != ripple)
+    {
+        ripple->moveRipples(*next);
+        ripple = next;
+    }
+
+    ripple->setMaxRipples(level.maxRipples);
+    ripple->setKeyframeInterval(qMax(keyframeInterval, level.keyframeInterval));
+}
+
+void GLWidget::updateQualityLadder()
+{
+    // Keyframe rungs only where the meshes blend keyframes; a new ladder
+    // starts from full quality
+    if (!ripple)
+        return;
+    quality.setKeyframes(ripple->hasKeyframes());
+    applyQuality();
+}
+
+QPointF GLWidget::surfacePos(const QPointF& pos) const
+{
+    // Widget pixels to surface pixels, centered with y up
+    float x = pos.x() - this->size().width()/2;
+    float y = this->size().height()/2 - pos.y();
+    return QPointF(x / zoom + pan.x(), y / zoom + pan.y());
+}
+
+QRectF GLWidget::viewRect() const
+{
+    float w = this->size().width() / zoom;
+    float h = this->size().height() / zoom;
+    return QRectF(pan.x() - w/2, pan.y() - h/2, w, h);
+}
+
+QRectF GLWidget::textureRect() const
+{
+    // The view in image texture coordinates, with room for displacement
+    QRectF view = viewRect();
+    float w = surfaceSize.width();
+    float h = surfaceSize.height();
+    return QRectF((view.left() + w/2) / w - TILE_TEXCOORD_MARGIN, (view.top() + h/2) / h - TILE_TEXCOORD_MARGIN,
+                  view.width() / w + 2*TILE_TEXCOORD_MARGIN, view.height() / h + 2*TILE_TEXCOORD_MARGIN);
 }
 
 void GLWidget::mousePressEvent(QMouseEvent *event)
 {        
-    float x = event->localPos().x() - this->size().width()/2;
-    float y = this->size().height()/2 - event->localPos().y();
-    ripple->addRipple(x, y, speed);
+    // Left button drops a ripple, the others drag the view
+    if (event->button() != Qt::LeftButton)
+    {
+        dragging = true;
+        dragPos = event->pos();
+        return;
+    }
+
+    addRipple(surfacePos(event->localPos()), speed);
 }
 
 void GLWidget::mouseReleaseEvent(QMouseEvent *)
 {
+    dragging = false;
+}
 
+void GLWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!dragging)
+        return;
+
+    QPoint delta = event->pos() - dragPos;
+    dragPos = event->pos();
+    pan = QPointF(qBound(-surfaceSize.width()/2.f, (float) (pan.x() - delta.x() / zoom), surfaceSize.width()/2.f),
+                  qBound(-surfaceSize.height()/2.f, (float) (pan.y() + delta.y() / zoom), surfaceSize.height()/2.f));
+}
+
+void GLWidget::wheelEvent(QWheelEvent *event)
+{
+    // Zoom around the cursor, keeping the point under it in place
+    QPointF anchor = surfacePos(event->posF());
+    zoom = qBound(ZOOM_MIN, zoom * std::pow(ZOOM_STEP, event->angleDelta().y() / 120.f), ZOOM_MAX);
+    QPointF moved = surfacePos(event->posF());
+    pan += anchor - moved;
 }
 
 void GLWidget::timerEvent(QTimerEvent *)
 {
+    TRACE_ZONE("GLWidget::timerEvent");
+    nextFrame();
+}
+
+void GLWidget::startFrames()
+{
+    // Unthrottled, each swap starts the next update and frame
+    timer.stop();
+    disconnect(this, &QOpenGLWidget::frameSwapped, this, &GLWidget::nextFrame);
+    if (frameInterval > 0)
+    {
+        timer.start(frameInterval, this);
+    }
+    else
+    {
+        connect(this, &QOpenGLWidget::frameSwapped, this, &GLWidget::nextFrame);
+        update();
+    }
+}
+
+void GLWidget::nextFrame()
+{
+    TRACE_ZONE("GLWidget::nextFrame");
+    // Updates write buffers and may render offscreen
+    makeCurrent();
+    replayRipples();
+    emitRipples();
+    updateClock.start();
+    ripple->setViewport(viewRect());
     ripple->update();
+    updateMs = updateClock.nsecsElapsed() / 1e6f;
+    uploadMs = ripple->uploadTime() / 1e6f;
+    uploadBytes = ripple->uploadBytes();
+    retired = ripple->retiredCount();
+    updateCount++;
+    evaluationTotal += ripple->evaluationCount();
+    doneCurrent();
     update();
 }
 
+void GLWidget::addRipple(const QPointF& pos, int step)
+{
+    ripple->addRipple(pos.x(), pos.y(), step);
+
+    if (recording.isOpen())
+    {
+        RippleLog::Event event =
+        {
+            updateCount - recordStart,
+            (unsigned) recordClock.elapsed(),
+            (float) pos.x(),
+            (float) pos.y(),
+            step,
+            idxTexture,
+            distort
+        };
+        recording.append(event);
+    }
+}
+
+void GLWidget::replayRipples()
+{
+    if (!replaying)
+        return;
+
+    // Each ripple lands before the same update it did when recorded, with
+    // the settings it was added with
+    const std::vector<RippleLog::Event>& events = replay.events();
+    for (; replayNext < events.size() && events[replayNext].frame <= updateCount - replayStart; replayNext++)
+    {
+        const RippleLog::Event& event = events[replayNext];
+        if (event.texture != idxTexture)
+            setTexture(event.texture);
+        if (event.distort != distort)
+            setDistort(event.distort);
+        addRipple(QPointF(event.x, event.y), event.step);
+    }
+
+    if (replayNext == events.size())
+    {
+        qCInfo(lcReplay, "replay done after %u updates", updateCount - replayStart);
+        replaying = false;
+    }
+}
+
+void GLWidget::emitRipples()
+{
+    if (!emitter)
+        return;
+
+    // Through addRipple, so a recording captures the workload too
+    long dropped = ripple->droppedCount();
+    const std::vector<RippleEmitter::Drop>& drops = emitter->next();
+    for (const RippleEmitter::Drop& drop : drops)
+        addRipple(QPointF(drop.x, drop.y), drop.step);
+
+    // Past the pool size the workload measures the pool, not the backend
+    dropped = ripple->droppedCount() - dropped;
+    if (dropped > 0 && !emitterOverflow)
+    {
+        qCWarning(lcWorkload, "ripple pool full after %u updates, %ld ripples dropped to make way for %d new ones; "
+                  "later drops are not reported", updateCount, dropped, (int) drops.size());
+        emitterOverflow = true;
+    }
+}
+
 void GLWidget::initShaders()
 {
-    // Compile vertex shader
-    if (!program.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/vshader.glsl"))
+    QElapsedTimer clock;
+    clock.start();
+
+    // Register vertex shader; compiled at link unless the disk cache has
+    // the program binary
+    if (!program.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/vshader.glsl"))
         close();
 
-    // Compile fragment shader
-    if (!program.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/fshader.glsl"))
+    // Register fragment shader
+    if (!program.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/fshader.glsl"))
         close();
 
-    // Link shader pipeline
+    // Link shader pipeline, or load the cached binary
     if (!program.link())
         close();
 
+    shaderMs = clock.nsecsElapsed() / 1e6f;
+
     // Bind shader pipeline for use
     if (!program.bind())
         close();
@@ -101,27 +742,10 @@ void GLWidget::initShaders()
 
 void GLWidget::initTextures()
 {
-    const char* files[] = {
-        ":/textures/Underwater-Fish-Wallpaper.jpg",
-        ":/textures/water_water_0056_01.jpg",
-        ":/textures/stones-770264.jpg"
-    };
-
-    // Load image
-    for (int i = 0; i < 3; i++)
-    {
-        textures[i] = new QOpenGLTexture(QImage(files[i]).mirrored());
-
-        // Set nearest filtering mode for texture minification
-        textures[i]->setMinificationFilter(QOpenGLTexture::Nearest);
-
-        // Set bilinear filtering mode for texture magnification
-        textures[i]->setMagnificationFilter(QOpenGLTexture::Linear);
-
-        // Wrap texture coordinates by repeating
-        // f.ex. texture coordinate (1.1, 1.2) is same as (0.1, 0.2)
-        textures[i]->setWrapMode(QOpenGLTexture::Repeat);
-    }
+    // Images load on first use, the first frames show a placeholder
+    textures = new TextureManager(textureBudget, TILE_CACHE_BUDGET);
+    textures->setPlaylist(imageFiles);
+    textures->prefetch(idxTexture);
 }
 
 void GLWidget::setSpeed(int value)
@@ -134,7 +758,125 @@ void GLWidget::setTexture(int value)
     idxTexture = value;
 }
 
+void GLWidget::nextImage()
+{
+    if (!imageFiles.isEmpty())
+        setTexture((idxTexture + 1) % imageFiles.size());
+}
+
+void GLWidget::previousImage()
+{
+    if (!imageFiles.isEmpty())
+        setTexture((idxTexture + imageFiles.size() - 1) % imageFiles.size());
+}
+
 void GLWidget::setDistort(int value)
 {
-    ripple->setDistortMode(value == 0 ? RippleEffect::eDistortVertices : RippleEffect::eDistortTexCoords);
+    distort = value;
+    if (!ripple)
+        return;
+
+    for (RippleSurface *mesh : meshes)
+        mesh->setDistortMode(value == 0 ? RippleEffect::eDistortVertices : RippleEffect::eDistortTexCoords);
+}
+
+void GLWidget::setVertexFormat(int value)
+{
+    // Buffers are reallocated, so the context has to be current
+    makeCurrent();
+    for (RippleSurface *mesh : meshes)
+        mesh->setVertexFormat(value == 0 ? RippleEffect::eVertexFloat : RippleEffect::eVertexCompact);
+    updateQualityLadder();
+    doneCurrent();
+}
+
+void GLWidget::setBackend(int value)
+{
+    makeCurrent();
+    const RippleEffect::Backend backends[] = {
+        RippleEffect::eBackendVertices,
+        RippleEffect::eBackendTexture,
+        RippleEffect::eBackendSplat,
+        RippleEffect::eBackendCompute
+    };
+    // Splats carry thousands of ripples, the CPU backends would crawl
+    for (RippleSurface *mesh : meshes)
+    {
+        if (mesh->setBackend(backends[value]))
+            mesh->setPoolSize(backends[value] == RippleEffect::eBackendSplat ? RIPPLE_POOL_SIZE_SPLAT : RIPPLE_POOL_SIZE);
+    }
+    updateQualityLadder();
+    doneCurrent();
+}
+
+void GLWidget::setMeshSize(int value)
+{
+    // Before the first show, initMeshes builds this size
+    gridSize = value;
+    if (!ripple)
+        return;
+
+    makeCurrent();
+    for (int i = 0; i < QUALITY_MESH_LEVELS; i++)
+        meshes[i]->setMeshSize(meshCols(i), meshRows(i));
+    doneCurrent();
+}
+
+void GLWidget::setFieldSize(int value)
+{
+    makeCurrent();
+    for (RippleSurface *mesh : meshes)
+        mesh->setFieldSize(value, value);
+    doneCurrent();
+}
+
+void GLWidget::setKeyframeInterval(int value)
+{
+    keyframeInterval = value;
+    if (!ripple)
+        return;
+
+    makeCurrent();
+    for (RippleSurface *mesh : meshes)
+        mesh->setKeyframeInterval(value);
+    applyQuality();
+    doneCurrent();
+}
+
+void GLWidget::setAdaptiveMesh(bool enabled)
+{
+    makeCurrent();
+    for (RippleSurface *mesh : meshes)
+        mesh->setMeshMode(enabled ? RippleEffect::eMeshAdaptive : RippleEffect::eMeshUniform);
+    doneCurrent();
+}
+
+void GLWidget::setRenderScale(int value)
+{
+    renderScale = qBound(RENDER_SCALE_MIN, value / 100.f, 1.f);
+}
+
+void GLWidget::setDynamicScale(bool enabled)
+{
+    dynamicScale = enabled;
+    scaleCooldown = 0;
+}
+
+void GLWidget::setAdaptiveQuality(bool enabled)
+{
+    adaptiveQuality = enabled;
+    quality.reset();
+    if (!ripple)
+        return;
+
+    // Back to the full mesh and the user's settings
+    makeCurrent();
+    applyQuality();
+    doneCurrent();
+}
+
+void GLWidget::setHudVisible(bool visible)
+{
+    // Built on first show, nothing is measured for it while hidden
+    hudVisible = visible;
 }
@@ -5,8 +5,19 @@
 #include <QOpenGLFunctions>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLTexture>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLTimerQuery>
+#include <QOpenGLTimeMonitor>
 #include <QBasicTimer>
-#include "RippleEffect.h"
+#include <QElapsedTimer>
+#include "RippleSurface.h"
+#include "QualityController.h"
+#include "TextureManager.h"
+#include "RippleLog.h"
+#include "RippleEmitter.h"
+#include "FrameStats.h"
+#include "PerfHud.h"
+#include "FrameTelemetry.h"
 
 class GLWidget : public QOpenGLWidget, protected QOpenGLFunctions
 {
@@ -15,6 +26,34 @@ public:
     explicit GLWidget(QWidget *parent = 0);
     virtual ~GLWidget();
 
+    // Takes effect when the GL resources are created, before the first show
+    void setSurfaceSize(const QSize& size);
+
+    // Background images, stepped through with nextImage and previousImage;
+    // the budget caps the bytes of uploaded images, and larger images are
+    // streamed in tiles
+    void setImageFile(int index, const QString& fileName);
+    void setPlaylist(const QStringList& files);
+    void setTextureBudget(qint64 bytes);
+
+    // Ripple logs; a replay sets the surface size when started before the first show
+    bool startRecording(const QString& fileName);
+    bool startReplay(const QString& fileName, bool fast);
+
+    // Synthetic ripples before every update, see RippleEmitter for the spec
+    bool setEmitter(const QString& spec);
+
+    // Frame records for offline analysis, CSV for a .csv file and JSON
+    // lines otherwise, one per 'window' frames
+    bool startTelemetry(const QString& fileName, int window);
+
+    // Updates and frames back to back after each swap instead of on the
+    // timer; set a swap interval of 0 in the default format to go unthrottled
+    void setUnthrottled(bool enabled);
+
+    const FrameStats& frameStats() const;   // time between frames
+    double evaluationRate() const;          // ripple-vertex evaluations per second
+
 protected:
     void initializeGL();
     void resizeGL(int width, int height);
@@ -22,27 +61,120 @@ protected:
 
     void mousePressEvent(QMouseEvent *e);
     void mouseReleaseEvent(QMouseEvent *e);
+    void mouseMoveEvent(QMouseEvent *e);
+    void wheelEvent(QWheelEvent *e);
     void timerEvent(QTimerEvent *e);
+    void startFrames();
+    void nextFrame();
 
     void initShaders();
     void initTextures();    
+    void initMeshes();
+    void initQueries();
+    int meshCols(int level) const;
+    int meshRows(int level) const;
+
+    QSize sceneSize() const;
+    QPointF surfacePos(const QPointF& pos) const;
+    QRectF viewRect() const;
+    QRectF textureRect() const;
+    void adjustRenderScale(float ms);
+    void adjustQuality(float ms);
+    void applyQuality();
+    void updateQualityLadder();
+    void addRipple(const QPointF& pos, int step);
+    void replayRipples();
+    void emitRipples();
 
 private:
     QOpenGLShaderProgram program;
     QMatrix4x4 projection;
 
-    QOpenGLTexture *textures[3];
-    RippleEffect *ripple;
+    QStringList imageFiles;
+    qint64 textureBudget;
+    TextureManager *textures;
+    RippleSurface *ripple;
+    RippleSurface *meshes[QUALITY_MESH_LEVELS];
     QBasicTimer timer;
+    int frameInterval;          // ms between updates, 0 for back to back
+    unsigned updateCount;       // updates run, the clock ripple logs keep
 
     int speed;
     int idxTexture;
+    int distort;
+    int gridSize;               // cells of the finest mesh level
+
+    QSize surfaceSize;
+    float zoom;
+    QPointF pan;                // surface point at the center of the widget
+    QPoint dragPos;
+    bool dragging;
+
+    QOpenGLFramebufferObject *sceneFbo;
+    QOpenGLTimerQuery *sceneQueries[3];
+    bool sceneQueryPending[3];  // ended and not read yet
+    int sceneQuery;
+    QElapsedTimer sceneClock;
+    QOpenGLTimeMonitor *drawMonitors[3];    // timestamps around the ripple draw, for the overlay
+    bool drawMonitorPending[3]; // recorded and not read yet
+    int drawMonitor;
+    float drawMs;               // this frame's result, -1 when none arrived
+
+    float renderScale;
+    bool dynamicScale;
+    float sceneTarget;          // ms of scene time the dynamic scale aims for
+    int scaleCooldown;
+
+    QualityController quality;
+    bool adaptiveQuality;
+    int keyframeInterval;       // user setting, the controller may only raise it
+    QElapsedTimer updateClock;
+    float updateMs;
+
+    RippleLog recording;
+    unsigned recordStart;       // updateCount when recording started
+    QElapsedTimer recordClock;
+    RippleLog replay;
+    unsigned replayStart;
+    size_t replayNext;          // next event to replay
+    bool replaying;
+    RippleEmitter *emitter;
+    bool emitterOverflow;       // warned about the pool dropping emitted ripples
+
+    FrameStats stats;
+    QElapsedTimer frameClock;
+    QElapsedTimer runClock;     // since the first frame
+    qint64 evaluationTotal;
+
+    PerfHud *hud;
+    bool hudVisible;
+    float uploadMs;
+    qint64 uploadBytes;
+    int retired;                // by the last update
+    FrameTelemetry telemetry;
+
+    QElapsedTimer startupClock;
+    float shaderMs;
+    bool firstFrame;
 signals:
+    void renderScaleChanged(int value);
 
 public slots:
     void setSpeed(int value);
     void setTexture(int value);
+    void nextImage();
+    void previousImage();
     void setDistort(int value);
+    void setVertexFormat(int value);
+    void setBackend(int value);
+    void setMeshSize(int value);
+    void setFieldSize(int value);
+    void setKeyframeInterval(int value);
+    void setAdaptiveMesh(bool enabled);
+    void setRenderScale(int value);
+    void setDynamicScale(bool enabled);
+    void setAdaptiveQuality(bool enabled);
+    void setHudVisible(bool visible);
 };
 
 #endif // GLWIDGET_H
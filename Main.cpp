@@ -1,5 +1,82 @@
 #include "Window.h"
+#include "GLWidget.h"
+#include "FrameTrace.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QSurfaceFormat>
+#include <QRadioButton>
+#include <QSpinBox>
+#include <QSlider>
+#include <QCheckBox>
+#include <QTimer>
+#include <QShortcut>
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QImageReader>
+#include <cstdio>
+
+#define SURFACE_SIZE_MAX        16384       // pixels along either side
+#define DURATION_MAX            2000000     // seconds, QTimer's int milliseconds hold about 24 days
+
+// "WxH" with both sides within 1 to SURFACE_SIZE_MAX
+static bool parseSize(const QString& text, QSize *size)
+{
+    QStringList parts = text.split('x');
+    bool ok[2] = { false, false };
+    if (parts.size() == 2)
+        *size = QSize(parts[0].toInt(&ok[0]), parts[1].toInt(&ok[1]));
+    return ok[0] && ok[1] && size->width() >= 1 && size->height() >= 1 &&
+           size->width() <= SURFACE_SIZE_MAX && size->height() <= SURFACE_SIZE_MAX;
+}
+
+// A directory's images in name order, or a text file naming one image per
+// line, relative to the file
+static bool loadPlaylist(const QString& path, QStringList *files)
+{
+    QFileInfo info(path);
+    if (info.isDir())
+    {
+        QStringList filters;
+        for (const QByteArray& format : QImageReader::supportedImageFormats())
+            filters << "*." + QString::fromLatin1(format);
+
+        QDir dir(path);
+        for (const QString& name : dir.entryList(filters, QDir::Files, QDir::Name))
+            *files << dir.filePath(name);
+        return !files->isEmpty();
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+
+    QTextStream stream(&file);
+    while (!stream.atEnd())
+    {
+        QString line = stream.readLine().trimmed();
+        if (!line.isEmpty() && !line.startsWith('#'))
+            *files << info.dir().filePath(line);
+    }
+    return !files->isEmpty();
+}
+
+static void printSummary(const GLWidget *widget)
+{
+    const FrameStats& stats = widget->frameStats();
+    std::printf("%ld frames, frame time mean %.2f ms, p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, longest %.2f ms\n",
+                stats.count(), stats.mean(), stats.percentile(0.50), stats.percentile(0.95), stats.percentile(0.99), stats.longest());
+    std::printf("%.1f M ripple-vertex evaluations/s\n", widget->evaluationRate() / 1e6);
+}
+
+#ifdef RIPPLE_TRACE
+static void dumpTrace(const QString& fileName)
+{
+    if (!FrameTrace::dump(QFile::encodeName(fileName).constData()))
+        qWarning("Could not write the trace %s", qPrintable(fileName));
+}
+#endif
 
 int main(int argc, char *argv[])
 {
@@ -7,8 +84,201 @@ int main(int argc, char *argv[])
     app.setApplicationName("Ripple Effect");
     app.setApplicationVersion("0.1");
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption grid("grid", "Mesh size in cells, 4 to 255.", "cells");
+    QCommandLineOption distort("distort", "Distort vertices or texcoords.", "mode");
+    QCommandLineOption texture("texture", "Image 1 to 3.", "index");
+    QCommandLineOption image("image", "Show <file> as image 1, streamed in tiles when it is too large to upload.", "file");
+    QCommandLineOption surface("surface", "Ripple surface of WxH pixels, 512x512 by default. Larger surfaces are split\n"
+                                          "into chunks; zoom with the wheel and pan with a right-button drag.", "size");
+    QCommandLineOption playlist("playlist", "Background images from a directory, or from a file naming one per line.\n"
+                                            "Page Down and Page Up step through them.", "path");
+    QCommandLineOption textureBudget("texture-budget", "Megabytes of uploaded background images, 256 by default.", "MB");
+    QCommandLineOption speed("speed", "Ripple speed, 1 to 20.", "step");
+    QCommandLineOption record("record", "Log every ripple to <file>.", "file");
+    QCommandLineOption replay("replay", "Replay the ripples logged in <file>.", "file");
+    QCommandLineOption replayFast("replay-fast", "Replay with updates back to back instead of at the timer rate.");
+    QCommandLineOption workload("emit", "Add synthetic ripples every update: rain, drag or burst, with options\n"
+                                        "as in rain:rate=0.5, drag:speed=12,rate=1 or burst:count=200,period=90.", "spec");
+    QCommandLineOption duration("duration", "Quit after <seconds>.", "seconds");
+    QCommandLineOption telemetry("telemetry", "Write frame records to <file>, CSV for .csv and JSON lines otherwise.", "file");
+    QCommandLineOption telemetryWindow("telemetry-window", "Frames per telemetry record, 1 by default.", "frames", "1");
+    QCommandLineOption hud("hud", "Show the performance overlay.");
+    QCommandLineOption unthrottled("unthrottled", "Swap interval 0 and frames back to back, to measure the throughput ceiling.");
+    parser.addOption(grid);
+    parser.addOption(distort);
+    parser.addOption(texture);
+    parser.addOption(image);
+    parser.addOption(surface);
+    parser.addOption(playlist);
+    parser.addOption(textureBudget);
+    parser.addOption(speed);
+    parser.addOption(record);
+    parser.addOption(replay);
+    parser.addOption(replayFast);
+    parser.addOption(workload);
+    parser.addOption(duration);
+    parser.addOption(unthrottled);
+    parser.addOption(hud);
+    parser.addOption(telemetry);
+    parser.addOption(telemetryWindow);
+#ifdef RIPPLE_TRACE
+    QCommandLineOption trace("trace", "Write the trace zones to <file> as Chrome trace JSON on F12 and at exit.", "file");
+    parser.addOption(trace);
+#endif
+    parser.process(app);
+
+    // Before the widget creates its context
+    if (parser.isSet(unthrottled))
+    {
+        QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+        format.setSwapInterval(0);
+        QSurfaceFormat::setDefaultFormat(format);
+    }
+
     Window window;
+    GLWidget *widget = window.findChild<GLWidget*>("glWidget");
+
+    // Before the meshes are built; a replay then takes the size it was recorded on
+    if (parser.isSet(surface))
+    {
+        QSize size;
+        if (!parseSize(parser.value(surface), &size))
+        {
+            qWarning("Bad surface size %s, use WxH with sides of 1 to %d", qPrintable(parser.value(surface)), SURFACE_SIZE_MAX);
+            return 1;
+        }
+        widget->setSurfaceSize(size);
+    }
+
+    if (parser.isSet(playlist))
+    {
+        QStringList files;
+        if (!loadPlaylist(parser.value(playlist), &files))
+        {
+            qWarning("No images in the playlist %s", qPrintable(parser.value(playlist)));
+            return 1;
+        }
+        widget->setPlaylist(files);
+    }
+    if (parser.isSet(image))
+    {
+        QImageReader reader(parser.value(image));
+        if (!reader.canRead())
+        {
+            qWarning("Could not read the image %s: %s", qPrintable(parser.value(image)), qPrintable(reader.errorString()));
+            return 1;
+        }
+        widget->setImageFile(0, parser.value(image));
+    }
+    if (parser.isSet(textureBudget))
+    {
+        bool ok = false;
+        int megabytes = parser.value(textureBudget).toInt(&ok);
+        if (!ok || megabytes < 1)
+        {
+            qWarning("Bad texture budget %s, use a number of megabytes", qPrintable(parser.value(textureBudget)));
+            return 1;
+        }
+        widget->setTextureBudget((qint64) megabytes << 20);
+    }
+
+    // Settings go through the controls, so the panel shows them
+    if (parser.isSet(grid))
+    {
+        QSpinBox *box = window.findChild<QSpinBox*>("meshSpinBox");
+        bool ok = false;
+        int cells = parser.value(grid).toInt(&ok);
+        if (!ok || cells < box->minimum() || cells > box->maximum())
+        {
+            qWarning("Bad grid size %s, use %d to %d cells", qPrintable(parser.value(grid)), box->minimum(), box->maximum());
+            return 1;
+        }
+        box->setValue(cells);
+    }
+    if (parser.isSet(speed))
+    {
+        QSlider *slider = window.findChild<QSlider*>("speedSlider");
+        bool ok = false;
+        int step = parser.value(speed).toInt(&ok);
+        if (!ok || step < 1 || step > slider->maximum())
+        {
+            qWarning("Bad speed %s, use 1 to %d", qPrintable(parser.value(speed)), slider->maximum());
+            return 1;
+        }
+        slider->setValue(step);
+    }
+    if (parser.isSet(distort))
+    {
+        QString mode = parser.value(distort);
+        if (mode != "vertices" && mode != "texcoords")
+        {
+            qWarning("Unknown distort mode %s, use vertices or texcoords", qPrintable(mode));
+            return 1;
+        }
+        window.findChild<QRadioButton*>(mode == "vertices" ? "distortVertices" : "distortTexCoords")->click();
+    }
+    if (parser.isSet(image) && !parser.isSet(texture))
+        window.findChild<QRadioButton*>("imageRadioButton1")->click();
+    if (parser.isSet(texture))
+    {
+        QRadioButton *button = window.findChild<QRadioButton*>(QString("imageRadioButton%1").arg(parser.value(texture).toInt()));
+        if (!button)
+        {
+            qWarning("No image %s, use 1 to 3", qPrintable(parser.value(texture)));
+            return 1;
+        }
+        button->click();
+    }
+    if (parser.isSet(hud))
+        window.findChild<QCheckBox*>("hudVisible")->setChecked(true);
+
+    // Checked before any log or telemetry file is opened
+    bool ok = false;
+    int frames = parser.value(telemetryWindow).toInt(&ok);
+    if (!ok || frames < 1)
+    {
+        qWarning("Bad telemetry window %s, use a number of frames", qPrintable(parser.value(telemetryWindow)));
+        return 1;
+    }
+    double seconds = parser.isSet(duration) ? parser.value(duration).toDouble(&ok) : 0;
+    if (parser.isSet(duration) && (!ok || !(seconds > 0) || seconds > DURATION_MAX))
+    {
+        qWarning("Bad duration %s, use up to %d seconds", qPrintable(parser.value(duration)), DURATION_MAX);
+        return 1;
+    }
+
+    if (parser.isSet(replay) && !widget->startReplay(parser.value(replay), parser.isSet(replayFast)))
+        return 1;
+    if (parser.isSet(workload) && !widget->setEmitter(parser.value(workload)))
+        return 1;
+    if (parser.isSet(record) && !widget->startRecording(parser.value(record)))
+        return 1;
+    if (parser.isSet(telemetry) && !widget->startTelemetry(parser.value(telemetry), frames))
+        return 1;
+    if (parser.isSet(unthrottled))
+        widget->setUnthrottled(true);
+    if (parser.isSet(duration))
+        QTimer::singleShot(qRound(seconds * 1000), &app, &QCoreApplication::quit);
+
+#ifdef RIPPLE_TRACE
+    QString traceFile = parser.value(trace);
+    if (!traceFile.isEmpty())
+    {
+        QShortcut *dump = new QShortcut(QKeySequence(Qt::Key_F12), &window);
+        QObject::connect(dump, &QShortcut::activated, [traceFile]() { dumpTrace(traceFile); });
+    }
+#endif
+
     window.show();
 
-    return app.exec();
+    int result = app.exec();
+    printSummary(widget);
+#ifdef RIPPLE_TRACE
+    if (!traceFile.isEmpty())
+        dumpTrace(traceFile);
+#endif
+    return result;
 }
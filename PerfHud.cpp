@@ -0,0 +1,142 @@
+#include "PerfHud.h"
+#include <QPainter>
+
+#define HUD_WIDTH               240
+#define HUD_HEIGHT              132
+#define HUD_MARGIN              8           // from the widget corner, in pixels
+#define HUD_REFRESH_MS          250
+#define HUD_GRAPH_FRAMES        114         // two pixel columns each
+#define HUD_GRAPH_HEIGHT        48
+#define HUD_GRAPH_RANGE_MS      33.3f       // frame time at the top of the graph
+#define HUD_BUDGET_MS           16.7f       // marked on the graph
+
+PerfHud::PerfHud() : texture(nullptr), image(HUD_WIDTH, HUD_HEIGHT, QImage::Format_RGBA8888_Premultiplied),
+    frameTimes(HUD_GRAPH_FRAMES, 0.f), head(0), last(), sum(), frames(0), drawFrames(0)
+{
+    initializeOpenGLFunctions();
+
+    if (!program.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/hud_vshader.glsl") ||
+        !program.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/hud_fshader.glsl") ||
+        !program.link())
+    {
+        qWarning("PerfHud: failed to build the overlay program");
+    }
+
+    const GLfloat corners[] = { 0.f, 0.f, 1.f, 0.f, 0.f, 1.f, 1.f, 1.f };
+    quadBuf.create();
+    quadBuf.bind();
+    quadBuf.allocate(corners, sizeof(corners));
+
+    texture = new QOpenGLTexture(QOpenGLTexture::Target2D);
+    texture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+    texture->setSize(HUD_WIDTH, HUD_HEIGHT);
+    texture->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
+    texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+    texture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+
+    repaint();
+    refreshClock.start();
+}
+
+PerfHud::~PerfHud()
+{
+    quadBuf.destroy();
+    delete texture;
+}
+
+void PerfHud::add(const Frame& frame)
+{
+    frameTimes[head] = frame.frameMs;
+    head = (head + 1) % HUD_GRAPH_FRAMES;
+
+    last = frame;
+    sum.frameMs += frame.frameMs;
+    sum.updateMs += frame.updateMs;
+    sum.uploadMs += frame.uploadMs;
+    sum.uploadBytes += frame.uploadBytes;
+    frames++;
+    if (frame.drawMs >= 0)
+    {
+        sum.drawMs += frame.drawMs;
+        drawFrames++;
+    }
+}
+
+void PerfHud::draw(int width, int height, float scale)
+{
+    if (refreshClock.elapsed() >= HUD_REFRESH_MS && frames > 0)
+    {
+        repaint();
+        refreshClock.start();
+    }
+
+    float w = 2.f * HUD_WIDTH * scale / width;
+    float h = 2.f * HUD_HEIGHT * scale / height;
+    float left = -1.f + 2.f * HUD_MARGIN * scale / width;
+    float top = 1.f - 2.f * HUD_MARGIN * scale / height;
+
+    program.bind();
+    program.setUniformValue("rect", left, top - h, w, h);
+    program.setUniformValue("image", 0);
+    glActiveTexture(GL_TEXTURE0);
+    texture->bind();
+
+    quadBuf.bind();
+    int cornerLocation = program.attributeLocation("a_corner");
+    program.enableAttributeArray(cornerLocation);
+    program.setAttributeBuffer(cornerLocation, GL_FLOAT, 0, 2, 2 * sizeof(GLfloat));
+
+    // On top of the scene, then back to the scene's state
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+
+    program.disableAttributeArray(cornerLocation);
+}
+
+void PerfHud::repaint()
+{
+    // Averages over the refresh window, so the numbers stay readable
+    float n = qMax(frames, 1);
+    QString lines[] =
+    {
+        QString("%1 ripples, %2 vertices").arg(last.ripples).arg(last.vertices),
+        QString("frame  %1 ms").arg(sum.frameMs / n, 0, 'f', 2),
+        QString("update %1 ms cpu").arg((sum.updateMs - sum.uploadMs) / n, 0, 'f', 2),
+        QString("upload %1 ms cpu, %2 KB").arg(sum.uploadMs / n, 0, 'f', 2).arg(sum.uploadBytes / n / 1024, 0, 'f', 1),
+        drawFrames > 0 ? QString("draw   %1 ms gpu").arg(sum.drawMs / drawFrames, 0, 'f', 2) : QString("draw   - ms gpu")
+    };
+
+    image.fill(QColor(0, 0, 0, 160));
+    QPainter painter(&image);
+    painter.setPen(Qt::white);
+    QFont font("monospace");
+    font.setStyleHint(QFont::TypeWriter);
+    font.setPixelSize(11);
+    painter.setFont(font);
+    int lineHeight = painter.fontMetrics().height();
+    for (int i = 0; i < 5; i++)
+        painter.drawText(6, 4 + (i + 1) * lineHeight - painter.fontMetrics().descent(), lines[i]);
+
+    // Frame times oldest to newest, the budget as a line across
+    int bottom = HUD_HEIGHT - 6;
+    int x0 = (HUD_WIDTH - 2*HUD_GRAPH_FRAMES) / 2;
+    for (int i = 0; i < HUD_GRAPH_FRAMES; i++)
+    {
+        float ms = frameTimes[(head + i) % HUD_GRAPH_FRAMES];
+        int bar = qMin(HUD_GRAPH_HEIGHT, qRound(ms / HUD_GRAPH_RANGE_MS * HUD_GRAPH_HEIGHT));
+        painter.fillRect(x0 + 2*i, bottom - bar, 2, bar, ms > HUD_BUDGET_MS ? QColor(240, 80, 60) : QColor(80, 200, 120));
+    }
+    int budget = qRound(HUD_BUDGET_MS / HUD_GRAPH_RANGE_MS * HUD_GRAPH_HEIGHT);
+    painter.fillRect(x0, bottom - budget, 2*HUD_GRAPH_FRAMES, 1, QColor(255, 255, 255, 128));
+    painter.end();
+
+    texture->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, image.constBits());
+
+    sum = Frame();
+    frames = 0;
+    drawFrames = 0;
+}
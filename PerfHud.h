@@ -0,0 +1,55 @@
+#ifndef PERFHUD_H
+#define PERFHUD_H
+
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLBuffer>
+#include <QOpenGLTexture>
+#include <QElapsedTimer>
+#include <QImage>
+#include <vector>
+
+// Performance overlay in the top left corner of the widget. Text and the
+// frame-time graph are painted into an image every HUD_REFRESH_MS and drawn
+// as one textured quad, so showing it costs a small texture upload a few
+// times a second and a single draw call per frame.
+class PerfHud : protected QOpenGLFunctions
+{
+public:
+
+    struct Frame
+    {
+        float frameMs;          // since the previous frame
+        float updateMs;         // CPU, simulation and evaluation
+        float uploadMs;         // CPU, buffer and texture writes
+        float drawMs;           // GPU, the ripple draw calls; negative on frames without a new result
+        qint64 uploadBytes;
+        int ripples;
+        int vertices;
+    };
+
+    PerfHud();
+    virtual ~PerfHud();
+
+    void add(const Frame& frame);
+    void draw(int width, int height, float scale);  // viewport in pixels, scale for high-dpi
+
+private:
+    void repaint();
+
+    QOpenGLShaderProgram program;
+    QOpenGLBuffer quadBuf;
+    QOpenGLTexture *texture;
+    QImage image;
+    QElapsedTimer refreshClock;
+
+    std::vector<float> frameTimes;  // ring of the last HUD_GRAPH_FRAMES
+    int head;
+
+    Frame last;
+    Frame sum;                  // over the frames since the last repaint
+    int frames;
+    int drawFrames;             // of those, with a GPU time
+};
+
+#endif // PERFHUD_H
@@ -0,0 +1,103 @@
+#include "QualityController.h"
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(lcQuality, "ripple.quality")
+
+#define QUALITY_SMOOTHING       0.1f        // weight of the newest frame in the average
+#define QUALITY_HEADROOM        0.6f        // step back up below this share of the budget
+#define QUALITY_COOLDOWN        60          // frames to settle after a change
+#define QUALITY_WARMUP          10          // frames measured before the first decision
+
+QualityController::QualityController(float budget)
+    : keyframes(true), budget(budget), average(0), index(0), cooldown(0), frames(0)
+{
+    setKeyframes(false);
+}
+
+void QualityController::setKeyframes(bool enabled)
+{
+    if (enabled == keyframes)
+        return;
+    keyframes = enabled;
+
+    // Cheapest steps first: ripple budget, then simulation rate, then mesh
+    if (keyframes)
+    {
+        levels = {
+            { 0, 0,  1 },
+            { 0, 64, 1 },
+            { 0, 64, 2 },
+            { 1, 32, 2 },
+            { 1, 16, 3 },
+            { 2, 16, 4 }
+        };
+    }
+    else
+    {
+        levels = {
+            { 0, 0,  1 },
+            { 0, 64, 1 },
+            { 1, 32, 1 },
+            { 1, 16, 1 },
+            { 2, 16, 1 }
+        };
+    }
+    reset();
+}
+
+void QualityController::setBudget(float ms)
+{
+    budget = ms;
+    cooldown = 0;
+}
+
+void QualityController::reset()
+{
+    index = 0;
+    average = 0;
+    cooldown = 0;
+    frames = 0;
+}
+
+bool QualityController::frame(float ms)
+{
+    average = frames == 0 ? ms : average + (ms - average) * QUALITY_SMOOTHING;
+    if (frames < QUALITY_WARMUP)
+    {
+        frames++;
+        return false;
+    }
+
+    if (cooldown > 0)
+    {
+        cooldown--;
+        return false;
+    }
+
+    int next = index;
+    if (average > budget && index + 1 < (int) levels.size())
+        next = index + 1;
+    else if (average < budget * QUALITY_HEADROOM && index > 0)
+        next = index - 1;
+
+    if (next == index)
+        return false;
+
+    const Level &level = levels[next];
+    qCInfo(lcQuality, "level %d -> %d: frame %.2f ms, budget %.2f ms, mesh level %d, max ripples %d, keyframe %d",
+           index, next, average, budget, level.meshLevel, level.maxRipples, level.keyframeInterval);
+
+    index = next;
+    cooldown = QUALITY_COOLDOWN;
+    return true;
+}
+
+int QualityController::level() const
+{
+    return index;
+}
+
+const QualityController::Level& QualityController::current() const
+{
+    return levels[index];
+}
@@ -0,0 +1,48 @@
+#ifndef QUALITYCONTROLLER_H
+#define QUALITYCONTROLLER_H
+
+#include <vector>
+
+#define QUALITY_MESH_LEVELS     3           // prebuilt meshes, each level halves the grid
+
+// Steps a quality ladder down when the measured frame time exceeds the
+// budget and back up when there is headroom again. Decisions are logged
+// to the "ripple.quality" category.
+class QualityController
+{
+public:
+
+    struct Level
+    {
+        int meshLevel;          // index of the prebuilt mesh
+        int maxRipples;         // 0 for no limit
+        int keyframeInterval;   // display frames per simulated frame
+    };
+
+    explicit QualityController(float budget = 12.f);
+
+    void setBudget(float ms);
+    void reset();
+
+    // Rungs that raise the keyframe interval only save time where the
+    // backend blends keyframes; without, the ladder leaves them out.
+    // A different ladder starts again from full quality.
+    void setKeyframes(bool enabled);
+
+    bool frame(float ms);
+
+    int level() const;
+    const Level& current() const;
+
+private:
+
+    std::vector<Level> levels;
+    bool keyframes;
+    float budget;
+    float average;              // smoothed frame time, in ms
+    int index;
+    int cooldown;
+    int frames;
+};
+
+#endif // QUALITYCONTROLLER_H
@@ -0,0 +1,116 @@
+#include "RippleCompute.h"
+#include "RippleTable.h"
+#include <QOpenGLContext>
+#include <QFile>
+
+RippleCompute::RippleCompute() : cols(0), rows(0), valid(true)
+{
+    initializeOpenGLFunctions();
+
+    QFile file(":/shaders/ripple_compute.glsl");
+    file.open(QIODevice::ReadOnly);
+    QByteArray source = file.readAll();
+
+    QByteArray header = QOpenGLContext::currentContext()->isOpenGLES() ?
+                "#version 310 es\nprecision highp float;\nprecision highp int;\n" : "#version 430 core\n";
+
+    // One variant per output layout, so each only declares the buffer it writes
+    const char *outputs[] = { "OUTPUT_POSITIONS", "OUTPUT_TEXCOORDS", "OUTPUT_OFFSETS" };
+    for (int i = 0; i < 3; i++)
+    {
+        QByteArray code = header + "#define " + outputs[i] + "\n" + source;
+        if (!programs[i].addCacheableShaderFromSourceCode(QOpenGLShader::Compute, code) || !programs[i].link())
+        {
+            qWarning("RippleCompute: failed to build the %s program", outputs[i]);
+            valid = false;
+        }
+    }
+
+    rippleBuf.create();
+    rippleBuf.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    vectorBuf.create();
+
+    ampBuf.create();
+    ampBuf.bind();
+    ampBuf.allocate(g_ripple_amp, RIPPLE_LENGTH * sizeof(RIPPLE_AMP));
+    ampBuf.release();
+}
+
+RippleCompute::~RippleCompute()
+{
+    rippleBuf.destroy();
+    vectorBuf.destroy();
+    ampBuf.destroy();
+}
+
+void RippleCompute::setVectors(const RIPPLE_VECTOR *vectors, int cols, int rows)
+{
+    this->cols = cols;
+    this->rows = rows;
+
+    vectorBuf.bind();
+    vectorBuf.allocate(vectors, (cols+1)*(rows+1) * sizeof(RIPPLE_VECTOR));
+    vectorBuf.release();
+}
+
+void RippleCompute::run(Output output, QOpenGLBuffer& target, const RippleSplat::Instance *ripples, int count, float x, float y, float w, float h,
+                        int pinned)
+{
+    // Empty storage buffers cannot be bound, keep at least one entry
+    rippleBuf.bind();
+    if (count > 0)
+        rippleBuf.allocate(ripples, count * sizeof(RippleSplat::Instance));
+    else
+        rippleBuf.allocate(sizeof(RippleSplat::Instance));
+    rippleBuf.release();
+
+    // Vertices off the pinned edges, as RippleField::evaluatedRange lays them out
+    int x0 = pinned & RippleField::eEdgeLeft ? 1 : 0;
+    int y0 = pinned & RippleField::eEdgeTop ? 1 : 0;
+    int x1 = pinned & RippleField::eEdgeRight ? cols-1 : cols;
+    int y1 = pinned & RippleField::eEdgeBottom ? rows-1 : rows;
+
+    QOpenGLShaderProgram &program = programs[output];
+    program.bind();
+    glUniform2i(program.uniformLocation("grid_size"), cols, rows);
+    glUniform2i(program.uniformLocation("first_vertex"), x0, y0);
+    glUniform2i(program.uniformLocation("last_vertex"), x1, y1);
+    program.setUniformValue("ripple_count", count);
+    program.setUniformValue("ripple_length", RIPPLE_LENGTH);
+    program.setUniformValue("image_origin", QVector2D(x, y));
+    program.setUniformValue("image_size", QVector2D(w, h));
+    program.setUniformValue("reference_size", QVector2D(GRID_SIZE_X, GRID_SIZE_Y));
+    program.setUniformValue("cell_length", (GLfloat) RIPPLE_CELL_LENGTH);
+    program.setUniformValue("offset_range", RIPPLE_OFFSET_RANGE);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, rippleBuf.bufferId());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, vectorBuf.bufferId());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, ampBuf.bufferId());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, target.bufferId());
+
+    glDispatchCompute((x1-x0+1 + 7)/8, (y1-y0+1 + 7)/8, 1);
+
+    // The next draw reads the buffer as vertex attributes
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+    for (GLuint i = 0; i < 4; i++)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, 0);
+    program.release();
+}
+
+bool RippleCompute::isValid() const
+{
+    return valid;
+}
+
+bool RippleCompute::isSupported()
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context)
+        return false;
+
+    if (context->isOpenGLES())
+        return context->format().version() >= qMakePair(3, 1);
+
+    return context->format().version() >= qMakePair(4, 3);
+}
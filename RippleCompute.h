@@ -0,0 +1,47 @@
+#ifndef RIPPLECOMPUTE_H
+#define RIPPLECOMPUTE_H
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLBuffer>
+#include "RippleSplat.h"
+
+struct RIPPLE_VECTOR;
+
+// Evaluates the ripple kernel in a compute shader and writes the result
+// straight into the mesh's vertex buffer, bound as a storage buffer.
+class RippleCompute : protected QOpenGLExtraFunctions
+{
+public:
+
+    enum Output
+    {
+        eOutputPositions,       // float xyz positions, displaced in pixels
+        eOutputTexCoords,       // float texcoords
+        eOutputOffsets          // packed signed-16 compact offsets
+    };
+
+    RippleCompute();
+    virtual ~RippleCompute();
+
+    void setVectors(const RIPPLE_VECTOR *vectors, int cols, int rows);
+    void run(Output output, QOpenGLBuffer& target, const RippleSplat::Instance *ripples, int count, float x, float y, float w, float h,
+             int pinned = RippleField::eEdgesAll);     // pinned: RippleField::Edge flags
+
+    bool isValid() const;
+
+    static bool isSupported();
+
+private:
+
+    QOpenGLShaderProgram programs[3];
+    QOpenGLBuffer rippleBuf;
+    QOpenGLBuffer vectorBuf;
+    QOpenGLBuffer ampBuf;
+
+    int cols;
+    int rows;
+    bool valid;
+};
+
+#endif // RIPPLECOMPUTE_H
@@ -0,0 +1,30 @@
+#-------------------------------------------------
+#
+# Ripple simulation core: grid, ripple pool, tables,
+# kernels, ripple logs and workloads, without Qt or OpenGL
+#
+#-------------------------------------------------
+
+CONFIG   += staticlib c++11
+CONFIG   -= qt
+
+TARGET = ripplecore
+TEMPLATE = lib
+
+
+SOURCES +=\
+    RippleField.cpp \
+    RippleLog.cpp \
+    RippleEmitter.cpp \
+    RippleGeometry.cpp \
+    RippleQuadTree.cpp \
+    RippleLayout.cpp
+
+HEADERS  += \
+    RippleField.h \
+    RippleLog.h \
+    RippleEmitter.h \
+    RippleGeometry.h \
+    RippleQuadTree.h \
+    RippleLayout.h \
+    RippleTable.h
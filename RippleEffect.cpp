@@ -1,18 +1,40 @@
 #include "RippleEffect.h"
 #include "RippleTable.h"
+#include "RippleGeometry.h"
+#include "FrameTrace.h"
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <algorithm>
 #include <cmath>
+#include <utility>
 
 RippleEffect::RippleEffect(QOpenGLShaderProgram *program, float w, float h, QOpenGLTexture *)
-    : program(program), indexBuf(QOpenGLBuffer::IndexBuffer), distortMode(eDistortTexCoords), imgSize(w, h)
+    : RippleEffect(program, w, h, 0, 0)
 {
+}
+
+RippleEffect::RippleEffect(QOpenGLShaderProgram *program, float w, float h, float x, float y)
+    : program(program), indexBuf(QOpenGLBuffer::IndexBuffer), fieldTexture(nullptr), fieldPrevTexture(nullptr), splat(nullptr), compute(nullptr),
+      distortMode(eDistortTexCoords), vertexFormat(eVertexFloat), indexLayout(eIndexStrip), backend(eBackendVertices), meshMode(eMeshUniform), indexCount(0), evaluations(0), retired(0), uploaded(0), uploadNs(0),
+      keyframeInterval(1), frameCount(0), keyframeTime(0), keyframePeriod(0),
+      imgSize(w, h), origin(x, y), texOrigin(0, 0), texSize(1, 1), culled(false), meshSize(GRID_SIZE_X, GRID_SIZE_Y), fieldSize(GRID_SIZE_X, GRID_SIZE_Y), simSize(GRID_SIZE_X, GRID_SIZE_Y),
+      ripples(w, h), vertices(nullptr), verticesCopy(nullptr), texCoords(nullptr), texCoordsCopy(nullptr), offsets(nullptr), field(nullptr)
+{
+    ripples.setOrigin(x, y);
+
     // Generate VBOs
     positionBuf.create();
     texCoordBuf.create();
+    offsetBuf.create();
+    offsetPrevBuf.create();
     indexBuf.create();
 
     initPositions();
     initTexCoords();
-    initIndices();    
+    initOffsets();
+    initIndices();
+
+    clock.start();
 }
 
 RippleEffect::~RippleEffect()
@@ -23,225 +45,892 @@ RippleEffect::~RippleEffect()
     delete[] texCoords;
     delete[] texCoordsCopy;
 
+    delete[] offsets;
+    delete[] field;
+
     positionBuf.destroy();
     texCoordBuf.destroy();
+    offsetBuf.destroy();
+    offsetPrevBuf.destroy();
     indexBuf.destroy();
+    delete fieldTexture;
+    delete fieldPrevTexture;
+    delete splat;
+    delete compute;
 }
 
 void RippleEffect::initPositions()
 {
-    vertices = new Vector3D[(GRID_SIZE_X+1)*(GRID_SIZE_Y+1)];
-    verticesCopy = new Vector3D[(GRID_SIZE_X+1)*(GRID_SIZE_Y+1)];
+    delete[] vertices;
+    delete[] verticesCopy;
+
+    vertices = new Vector3D[(meshSize.x+1)*(meshSize.y+1)];
+    verticesCopy = new Vector3D[(meshSize.x+1)*(meshSize.y+1)];
+
+    Vector2D offset(origin.x - imgSize.x/2, origin.y - imgSize.y/2);
+    Vector2D piece(imgSize.x/meshSize.x, imgSize.y/meshSize.y);
 
-    Vector2D offset(-imgSize.x/2, -imgSize.y/2);
-    Vector2D piece(imgSize.x/GRID_SIZE_X, imgSize.y/GRID_SIZE_Y);
+    for(int y = 0; y <= meshSize.y; y++)
+        for(int x = 0; x <= meshSize.x; x++)
+            verticesCopy[y*(meshSize.x+1)+x] = vertices[y*(meshSize.x+1)+x] = Vector3D(offset.x + x*piece.x, offset.y + (meshSize.y-y)*piece.y, 0.f);
 
-    for(int y = 0; y <= GRID_SIZE_Y; y++)
-        for(int x = 0; x <= GRID_SIZE_X; x++)
-            verticesCopy[y*(GRID_SIZE_X+1)+x] = vertices[y*(GRID_SIZE_X+1)+x] = Vector3D(offset.x + x*piece.x, offset.y + (GRID_SIZE_Y-y)*piece.y, 0.f);
+    allocatePositions();
+}
+
+void RippleEffect::allocatePositions()
+{
+    int count = (meshSize.x+1)*(meshSize.y+1);
 
     positionBuf.bind();
-    positionBuf.allocate(vertices, (GRID_SIZE_X+1)*(GRID_SIZE_Y+1) * sizeof(Vector3D));   
+    if (vertexFormat == eVertexCompact)
+    {
+        // z is always 0, so only x and y go to the GPU
+        Vector2D *packed = new Vector2D[count];
+        for (int i = 0; i < count; i++)
+            packed[i] = Vector2D(verticesCopy[i].x, verticesCopy[i].y);
+
+        positionBuf.allocate(packed, count * sizeof(Vector2D));
+        delete[] packed;
+    }
+    else
+    {
+        positionBuf.allocate(vertices, count * sizeof(Vector3D));
+    }
 }
 
 void RippleEffect::initTexCoords()
 {
-    texCoords = new Vector2D[(GRID_SIZE_X+1)*(GRID_SIZE_Y+1)];
-    texCoordsCopy = new Vector2D[(GRID_SIZE_X+1)*(GRID_SIZE_Y+1)];
+    delete[] texCoords;
+    delete[] texCoordsCopy;
+
+    texCoords = new Vector2D[(meshSize.x+1)*(meshSize.y+1)];
+    texCoordsCopy = new Vector2D[(meshSize.x+1)*(meshSize.y+1)];
+
+    for (int y = 0; y <= meshSize.y; y++)
+        for (int x = 0; x <= meshSize.x; x++)
+            texCoordsCopy[y*(meshSize.x+1)+x] = texCoords[y*(meshSize.x+1)+x] = Vector2D(x/(GLfloat)meshSize.x, (meshSize.y-y)/(GLfloat)meshSize.y);
+
+    allocateTexCoords();
+}
 
-    for (int y = 0; y <= GRID_SIZE_Y; y++)
-        for (int x = 0; x <= GRID_SIZE_X; x++)        
-            texCoordsCopy[y*(GRID_SIZE_X+1)+x] = texCoords[y*(GRID_SIZE_X+1)+x] = Vector2D(x/(GLfloat)GRID_SIZE_X, (GRID_SIZE_Y-y)/(GLfloat)GRID_SIZE_Y);
+void RippleEffect::allocateTexCoords()
+{
+    int count = (meshSize.x+1)*(meshSize.y+1);
 
     texCoordBuf.bind();
-    texCoordBuf.allocate(texCoords, (GRID_SIZE_X+1)*(GRID_SIZE_Y+1) * sizeof(Vector2D));   
+    if (vertexFormat == eVertexCompact)
+    {
+        // Normalized shorts cover [-1, 1], the shader maps them back to [0, 1]
+        Short2D *packed = new Short2D[count];
+        for (int i = 0; i < count; i++)
+            packed[i] = Short2D((GLshort) std::lround((texCoordsCopy[i].x*2 - 1) * 32767),
+                                (GLshort) std::lround((texCoordsCopy[i].y*2 - 1) * 32767));
+
+        texCoordBuf.allocate(packed, count * sizeof(Short2D));
+        delete[] packed;
+    }
+    else
+    {
+        texCoordBuf.allocate(texCoords, count * sizeof(Vector2D));
+    }
+}
+
+void RippleEffect::initOffsets()
+{
+    delete[] offsets;
+    offsets = new Short2D[(meshSize.x+1)*(meshSize.y+1)];
+
+    offsetBuf.bind();
+    offsetBuf.allocate(offsets, (meshSize.x+1)*(meshSize.y+1) * sizeof(Short2D));
+    offsetPrevBuf.bind();
+    offsetPrevBuf.allocate(offsets, (meshSize.x+1)*(meshSize.y+1) * sizeof(Short2D));
 }
 
 void RippleEffect::initIndices()
 {
-    GLushort *indices = new GLushort[(GRID_SIZE_X+1)*GRID_SIZE_Y*2];
+    RippleGeometry::Indices indices = RippleGeometry::indices(meshSize.x, meshSize.y, indexLayout == eIndexTriangles);
+    indexCount = (int) indices->size();
 
-    int idx = 0;
-    for (int y = 0; y < GRID_SIZE_Y; y++)
+    indexBuf.bind();
+    indexBuf.allocate(indices->data(), indexCount * sizeof(GLushort));
+}
+
+void RippleEffect::initField()
+{
+    if (backend == eBackendSplat)
     {
-        for (int x = 0; x <= GRID_SIZE_X; x++)
-        {
-            indices[idx++] = y*(GRID_SIZE_X+1)+x;
-            indices[idx++] = (y+1)*(GRID_SIZE_X+1)+x;
-        }
+        if (splat)
+            splat->resize(simSize.x, simSize.y);
+        else
+            splat = new RippleSplat(simSize.x, simSize.y);
+        return;
     }
 
-    indexBuf.bind();
-    indexBuf.allocate(indices, GRID_SIZE_X*GRID_SIZE_Y*6 * sizeof(GLushort));
+    delete[] field;
+    field = new Half2D[(simSize.x+1)*(simSize.y+1)];
 
-    delete[] indices;
+    // One texel per simulation vertex, filtered bilinearly onto the mesh.
+    // The previous keyframe is kept for blending between simulated frames.
+    QOpenGLTexture **textures[] = { &fieldTexture, &fieldPrevTexture };
+    for (QOpenGLTexture **texture : textures)
+    {
+        delete *texture;
+        *texture = new QOpenGLTexture(QOpenGLTexture::Target2D);
+        (*texture)->setFormat(QOpenGLTexture::RG16F);
+        (*texture)->setSize(simSize.x+1, simSize.y+1);
+        (*texture)->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
+        (*texture)->setWrapMode(QOpenGLTexture::ClampToEdge);
+        (*texture)->allocateStorage(QOpenGLTexture::RG, QOpenGLTexture::Float16);
+        (*texture)->setData(QOpenGLTexture::RG, QOpenGLTexture::Float16, field);
+    }
 }
 
 void RippleEffect::update()
 {
-    for (auto iter = ripples.begin(); iter != ripples.end(); )
+    TRACE_ZONE("RippleEffect::update");
+    // Between keyframes the vertex shader blends the last two results
+    int frames = keyframeFrames();
+    evaluations = 0;
+    retired = 0;
+    uploaded = 0;
+    uploadNs = 0;
+    if (++frameCount < frames)
+        return;
+    frameCount = 0;
+
+    retired = ripples.advance(frames);
+
+    qint64 now = clock.nsecsElapsed();
+    keyframePeriod = now - keyframeTime;
+    keyframeTime = now;
+
+    if (culled)
+        return;
+
+    if (meshMode == eMeshAdaptive)
     {
-        if (iter->delta > iter->duration)
-        {
-            ripples.erase(iter);
-        }
-        else
-        {
-            iter->delta += iter->step;
-            iter++;
-        }      
+        tessellate(true);
+        evaluations = (qint64) adaptiveVertices.size() * ripples.count();
+        return;
     }
 
-    float dx = distortMode == eDistortVertices ? imgSize.x : 1;
-    float dy = distortMode == eDistortVertices ? imgSize.y : 1;
-    for (int y = 1; y < GRID_SIZE_Y; y++)
+    // Every backend evaluates each ripple at each vertex off the pinned edges
+    evaluations = (qint64) ripples.evaluatedCount() * ripples.count();
+
+    if (backend == eBackendSplat)
     {
-        for (int x = 1; x < GRID_SIZE_X; x++)
-        {
-            int offset = y*(GRID_SIZE_X+1)+x;
-
-            if (distortMode == eDistortVertices)
-                vertices[offset] = verticesCopy[offset];
-            else
-                texCoords[offset] = texCoordsCopy[offset];
-
-            for (RippleData ripple : ripples)
-            {
-                int mx = x - ripple.gx;
-                int my = y - ripple.gy;
-                float sx = dx;
-                float sy = dy;
-
-                if (mx < 0)
-                {
-                    mx *= -1;
-                    sx *= -1;
-                }
-
-                if (my < 0)
-                {
-                    my *= -1;
-                    sy *= -1;
-                }
-
-                int r = ripple.delta - g_ripple_vector[mx][my].r;
-                if (r < 0)
-                    r = 0;
-                else if (r > RIPPLE_LENGTH-1)
-                    r = RIPPLE_LENGTH-1;
-
-                float amp = 1.f - (float) ripple.delta/RIPPLE_LENGTH;
-                amp *= amp;
-                if (amp < 0)
-                    amp = 0;
-
-                if (distortMode == eDistortVertices)
-                {
-                    vertices[offset].x += g_ripple_vector[mx][my].dx * sx * g_ripple_amp[r].amplitude * amp;
-                    vertices[offset].y += g_ripple_vector[mx][my].dy * sy * g_ripple_amp[r].amplitude * amp;
-                }
-                else
-                {
-                    texCoords[offset].x += g_ripple_vector[mx][my].dx * sx * g_ripple_amp[r].amplitude * amp;
-                    texCoords[offset].y += g_ripple_vector[mx][my].dy * sy * g_ripple_amp[r].amplitude * amp;
-                }
-            }
-        }
+        splatRipples();
+        return;
     }
 
-    if (distortMode == eDistortVertices)
+    if (backend == eBackendCompute)
     {
-        positionBuf.bind();
-        positionBuf.write(0, vertices, (GRID_SIZE_X+1)*(GRID_SIZE_Y+1) * sizeof(Vector3D));
+        computeRipples();
+        return;
+    }
+
+    // Compact offsets and the field texture are kept in texture units and
+    // scaled by the shader
+    bool scaled = backend == eBackendVertices && distortMode == eDistortVertices && vertexFormat == eVertexFloat;
+    float dx = scaled ? imgSize.x : 1;
+    float dy = scaled ? imgSize.y : 1;
+
+    // Pack the results straight into the layout that gets uploaded
+    if (backend == eBackendTexture)
+    {
+        ripples.evaluate(dx, dy, [this](int offset, float ox, float oy) {
+            field[offset] = Half2D(ox, oy);
+        });
+    }
+    else if (vertexFormat == eVertexCompact)
+    {
+        ripples.evaluate(dx, dy, [this](int offset, float ox, float oy) {
+            offsets[offset] = packOffset(ox, oy);
+        });
+    }
+    else if (distortMode == eDistortVertices)
+    {
+        ripples.evaluate(dx, dy, [this](int offset, float ox, float oy) {
+            vertices[offset].x = verticesCopy[offset].x + ox;
+            vertices[offset].y = verticesCopy[offset].y + oy;
+        });
     }
     else
     {
-        texCoordBuf.bind();
-        texCoordBuf.write(0, texCoords, (GRID_SIZE_X+1)*(GRID_SIZE_Y+1) * sizeof(Vector2D));
+        ripples.evaluate(dx, dy, [this](int offset, float ox, float oy) {
+            texCoords[offset].x = texCoordsCopy[offset].x + ox;
+            texCoords[offset].y = texCoordsCopy[offset].y + oy;
+        });
+    }
+
+    // The last keyframe becomes the one blended from
+    if (frames > 1)
+    {
+        std::swap(fieldTexture, fieldPrevTexture);
+        std::swap(offsetBuf, offsetPrevBuf);
+    }
+
+    writeDistortion();
+}
+
+void RippleEffect::packInstances()
+{
+    instances.resize(ripples.count());
+    ripples.pack(instances.data());
+}
+
+void RippleEffect::splatRipples()
+{
+    packInstances();
+
+    // The instance upload can't be timed apart from the pass it feeds
+    qint64 start = clock.nsecsElapsed();
+    splat->render(instances.data(), (int) instances.size(), ripples.pinnedEdges());
+    countUpload(start, instances.size() * sizeof(RippleSplat::Instance));
+}
+
+void RippleEffect::computeRipples()
+{
+    packInstances();
+    qint64 start = clock.nsecsElapsed();
+
+    // Same buffer the CPU path would have written
+    if (vertexFormat == eVertexCompact)
+        compute->run(RippleCompute::eOutputOffsets, offsetBuf, instances.data(), (int) instances.size(), origin.x, origin.y, imgSize.x, imgSize.y, ripples.pinnedEdges());
+    else if (distortMode == eDistortVertices)
+        compute->run(RippleCompute::eOutputPositions, positionBuf, instances.data(), (int) instances.size(), origin.x, origin.y, imgSize.x, imgSize.y, ripples.pinnedEdges());
+    else
+        compute->run(RippleCompute::eOutputTexCoords, texCoordBuf, instances.data(), (int) instances.size(), origin.x, origin.y, imgSize.x, imgSize.y, ripples.pinnedEdges());
+    countUpload(start, instances.size() * sizeof(RippleSplat::Instance));
+}
+
+void RippleEffect::initQuadTree()
+{
+    // The finest level is the largest power of two within the mesh size
+    int fine = 0;
+    while (fine < QUADTREE_DEPTH_MAX && (2 << fine) <= qMax(meshSize.x, meshSize.y))
+        fine++;
+
+    quadTree.setDepth(QUADTREE_DEPTH_COARSE, fine);
+    tessellate(true);
+}
+
+void RippleEffect::tessellate(bool displace)
+{
+    int cells = quadTree.size();
+    float scale = (float) cells / GRID_SIZE_X;     // finest cells per cell of the reference grid
+
+    // Refine where a wave is still visible, from activeBegin to activeEnd
+    // behind each wavefront
+    int activeBegin = ripples.activeBegin();
+    int activeEnd = ripples.activeEnd();
+    packInstances();
+    annuli.clear();
+    for (RippleSplat::Instance& instance : instances)
+    {
+        instance.x *= (float) cells / simSize.x;
+        instance.y *= (float) cells / simSize.y;
+        if (!displace || instance.amp < QUADTREE_RIPPLE_MIN || instance.delta < activeBegin)
+            continue;
+
+        RippleQuadTree::Annulus annulus =
+        {
+            instance.x,
+            instance.y,
+            (float) ((instance.delta - activeEnd) / RIPPLE_CELL_LENGTH) * scale,
+            (float) ((instance.delta - activeBegin) / RIPPLE_CELL_LENGTH) * scale
+        };
+        annuli.push_back(annulus);
+    }
+
+    quadTree.build(annuli);
+
+    const std::vector<RippleQuadTree::Point>& points = quadTree.vertices();
+    adaptiveVertices.resize(points.size());
+    adaptiveTexCoords.resize(points.size());
+
+    Vector2D offset(origin.x - imgSize.x/2, origin.y - imgSize.y/2);
+    Vector2D piece(imgSize.x/cells, imgSize.y/cells);
+    float dx = distortMode == eDistortVertices ? imgSize.x : 1;
+    float dy = distortMode == eDistortVertices ? imgSize.y : 1;
+
+    int pinned = ripples.pinnedEdges();
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        const RippleQuadTree::Point& point = points[i];
+        Vector3D& vertex = adaptiveVertices[i] = Vector3D(offset.x + point.x*piece.x, offset.y + (cells-point.y)*piece.y, 0.f);
+        Vector2D& texCoord = adaptiveTexCoords[i] = Vector2D(point.x/(GLfloat)cells, (cells-point.y)/(GLfloat)cells);
+
+        // Pinned edges stay at rest, like on the uniform mesh
+        if (annuli.empty() || (point.x == 0 && (pinned & RippleField::eEdgeLeft)) || (point.y == 0 && (pinned & RippleField::eEdgeTop)) ||
+            (point.x == cells && (pinned & RippleField::eEdgeRight)) || (point.y == cells && (pinned & RippleField::eEdgeBottom)))
+            continue;
+
+        float ox;
+        float oy;
+        RippleField::sample(point.x, point.y, scale, instances.data(), (int) instances.size(), dx, dy, ox, oy);
+
+        if (distortMode == eDistortVertices)
+        {
+            vertex.x += ox;
+            vertex.y += oy;
+        }
+        else
+        {
+            texCoord.x += ox;
+            texCoord.y += oy;
+        }
     }
+
+    // Vertex and index counts follow the active area
+    TRACE_ZONE("RippleEffect::tessellate upload");
+    qint64 start = clock.nsecsElapsed();
+    positionBuf.bind();
+    positionBuf.allocate(adaptiveVertices.data(), (int) (adaptiveVertices.size() * sizeof(Vector3D)));
+    texCoordBuf.bind();
+    texCoordBuf.allocate(adaptiveTexCoords.data(), (int) (adaptiveTexCoords.size() * sizeof(Vector2D)));
+
+    indexCount = (int) quadTree.indices().size();
+    indexBuf.bind();
+    indexBuf.allocate(quadTree.indices().data(), indexCount * sizeof(GLushort));
+    countUpload(start, adaptiveVertices.size() * (sizeof(Vector3D) + sizeof(Vector2D)) + indexCount * sizeof(GLushort));
 }
 
 void RippleEffect::draw()
-{    
+{
+    TRACE_ZONE("RippleEffect::draw");
     // Offset for position
     quintptr offset = 0;
 
+    bool compact = vertexFormat == eVertexCompact;
+    bool textured = hasField();
+
+    // Other passes may have bound their own program since the last frame
+    program->bind();
+
     // Tell OpenGL programmable pipeline how to locate vertex position data
     positionBuf.bind();
     int vertexLocation = program->attributeLocation("a_position");
     program->enableAttributeArray(vertexLocation);
-    program->setAttributeBuffer(vertexLocation, GL_FLOAT, offset, 3, sizeof(Vector3D));
+    if (compact)
+        program->setAttributeBuffer(vertexLocation, GL_FLOAT, offset, 2, sizeof(Vector2D));
+    else
+        program->setAttributeBuffer(vertexLocation, GL_FLOAT, offset, 3, sizeof(Vector3D));
 
     // Tell OpenGL programmable pipeline how to locate vertex texture coordinate data
     texCoordBuf.bind();
     int texcoordLocation = program->attributeLocation("a_texcoord");
     program->enableAttributeArray(texcoordLocation);
-    program->setAttributeBuffer(texcoordLocation, GL_FLOAT, offset, 2, sizeof(Vector2D));
+    if (compact)
+        program->setAttributeBuffer(texcoordLocation, GL_SHORT, offset, 2, sizeof(Short2D));
+    else
+        program->setAttributeBuffer(texcoordLocation, GL_FLOAT, offset, 2, sizeof(Vector2D));
+
+    // Compact offsets are normalized shorts, scaled back to pixels or texture units
+    float blend = keyframeBlend();
+    int offsetLocation = program->attributeLocation("a_offset");
+    int offsetPrevLocation = program->attributeLocation("a_offset_prev");
+    if (compact && !textured)
+    {
+        offsetBuf.bind();
+        program->enableAttributeArray(offsetLocation);
+        program->setAttributeBuffer(offsetLocation, GL_SHORT, offset, 2, sizeof(Short2D));
+    }
+    else
+    {
+        program->disableAttributeArray(offsetLocation);
+        program->setAttributeValue(offsetLocation, 0.f, 0.f);
+    }
+
+    if (compact && !textured && blend < 1.f)
+    {
+        offsetPrevBuf.bind();
+        program->enableAttributeArray(offsetPrevLocation);
+        program->setAttributeBuffer(offsetPrevLocation, GL_SHORT, offset, 2, sizeof(Short2D));
+    }
+    else
+    {
+        program->disableAttributeArray(offsetPrevLocation);
+        program->setAttributeValue(offsetPrevLocation, 0.f, 0.f);
+    }
+
+    // The field texture lives on unit 1, its previous keyframe on unit 2,
+    // the image stays on unit 0
+    if (backend == eBackendTexture)
+    {
+        fieldTexture->bind(1, QOpenGLTexture::ResetTextureUnit);
+        fieldPrevTexture->bind(2, QOpenGLTexture::ResetTextureUnit);
+    }
+    else if (backend == eBackendSplat)
+    {
+        QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
+        f->glActiveTexture(GL_TEXTURE1);
+        f->glBindTexture(GL_TEXTURE_2D, splat->texture());
+        f->glActiveTexture(GL_TEXTURE0);
+    }
 
-    // Draw cube geometry using indices from VBO 1
+    bool vertexOffsets = (compact || textured) && distortMode == eDistortVertices;
+    bool texCoordOffsets = (compact || textured) && distortMode == eDistortTexCoords;
+    program->setUniformValue("texcoord_scale", compact ? QVector2D(0.5f, 0.5f) : QVector2D(1.f, 1.f));
+    program->setUniformValue("texcoord_bias", compact ? QVector2D(0.5f, 0.5f) : QVector2D(0.f, 0.f));
+    program->setUniformValue("offset_range", RIPPLE_OFFSET_RANGE);
+    program->setUniformValue("position_offset_scale", vertexOffsets ? QVector2D(imgSize.x, imgSize.y) : QVector2D());
+    program->setUniformValue("texcoord_offset_scale", texCoordOffsets ? QVector2D(1.f, 1.f) : QVector2D());
+    program->setUniformValue("field_enabled", (GLint) textured);
+    program->setUniformValue("field_size", QVector2D(simSize.x, simSize.y));
+    program->setUniformValue("displacement", 1);
+    program->setUniformValue("displacement_prev", 2);
+    program->setUniformValue("frame_blend", blend);
+    program->setUniformValue("texture_rect", QVector4D(texOrigin.x, texOrigin.y, texSize.x, texSize.y));
+
+    // Draw grid geometry using indices from the index buffer
     indexBuf.bind();
-    glDrawElements(GL_TRIANGLE_STRIP, (GRID_SIZE_X+1)*GRID_SIZE_Y*2, GL_UNSIGNED_SHORT, 0);
+    bool triangles = meshMode == eMeshAdaptive || indexLayout == eIndexTriangles;
+    glDrawElements(triangles ? GL_TRIANGLES : GL_TRIANGLE_STRIP, indexCount, GL_UNSIGNED_SHORT, 0);
 }
 
 void RippleEffect::addRipple(float x, float y, int step)
 {
-    x += imgSize.x/2;
-    y = imgSize.y - (y + imgSize.y/2);
+    ripples.addRipple(x, y, step);
+}
 
-    RippleData data =
-    {
-        (int) (x/imgSize.x * GRID_SIZE_X),
-        (int) (y/imgSize.y * GRID_SIZE_Y),
-        0,
-        (int) std::sqrtf(imgSize.x*imgSize.x + imgSize.y*imgSize.y) + RIPPLE_LENGTH,
-        step
-    };
-    ripples.push_back(data);    
+void RippleEffect::moveRipples(RippleEffect& target)
+{
+    // Hand live ripples over to another mesh, at the same place on its grid
+    ripples.moveRipples(target.ripples);
+    resetDistortion();
 }
 
 void RippleEffect::setDistortMode(DistortMode mode)
 {
-    if (distortMode == eDistortVertices)
+    resetDistortion();
+    distortMode = mode;
+}
+
+void RippleEffect::setVertexFormat(VertexFormat format)
+{
+    if (format == vertexFormat)
+        return;
+
+    if (meshMode == eMeshAdaptive && format != eVertexFloat)
     {
-        for (int y = 1; y < GRID_SIZE_Y; y++)
-            for (int x = 1; x < GRID_SIZE_X; x++)
-                vertices[y*(GRID_SIZE_X+1)+x] = verticesCopy[y*(GRID_SIZE_X+1)+x];
+        qWarning("RippleEffect: adaptive meshes use the float vertex format");
+        return;
+    }
 
-        positionBuf.bind();
-        positionBuf.write(0, vertices, (GRID_SIZE_X+1)*(GRID_SIZE_Y+1) * sizeof(Vector3D));
+    resetDistortion();
+    vertexFormat = format;
+
+    // Reallocate the static buffers in the new layout
+    allocatePositions();
+    allocateTexCoords();
+}
+
+void RippleEffect::setIndexLayout(IndexLayout layout)
+{
+    if (layout == indexLayout)
+        return;
+
+    indexLayout = layout;
+    if (meshMode == eMeshUniform)
+        initIndices();
+}
+
+bool RippleEffect::setBackend(Backend mode)
+{
+    if (mode == backend)
+        return true;
+
+    if (meshMode == eMeshAdaptive && mode != eBackendVertices)
+    {
+        qWarning("RippleEffect: adaptive meshes need the vertex backend");
+        return false;
+    }
+
+    Backend requested = mode;
+
+    if (mode == eBackendTexture && !hasTextureBackend())
+    {
+        qWarning("RippleEffect: vertex texture fetch of RG16F is not available");
+        return false;
+    }
+
+    if (mode == eBackendSplat && !hasSplatBackend())
+    {
+        qWarning("RippleEffect: instancing or half float render targets are not available");
+        return false;
+    }
+
+    // Compute falls back to the CPU kernel over the same buffers
+    if (mode == eBackendCompute && !hasComputeBackend())
+    {
+        qWarning("RippleEffect: compute shaders are not available, using the CPU kernel");
+        mode = eBackendVertices;
+        if (mode == backend)
+            return false;
+    }
+
+    resetDistortion();
+    backend = mode;
+
+    // The vertex and compute backends simulate on the mesh itself
+    if (hasField())
+    {
+        setSimulationSize(fieldSize);
+        initField();
+    }
+    else
+    {
+        setSimulationSize(meshSize);
+    }
+
+    if (backend == eBackendCompute && !compute)
+    {
+        compute = new RippleCompute();
+        compute->setVectors(ripples.vectors(), simSize.x, simSize.y);
+    }
+
+    if ((backend == eBackendSplat && !splat->isValid()) || (backend == eBackendCompute && !compute->isValid()))
+    {
+        qWarning("RippleEffect: could not set up the GPU backend, using the CPU kernel");
+        backend = eBackendVertices;
+        setSimulationSize(meshSize);
+        return false;
+    }
+    return backend == requested;
+}
+
+void RippleEffect::setMeshSize(int cols, int rows)
+{
+    cols = qBound(1, cols, MESH_SIZE_MAX);
+    rows = qBound(1, rows, MESH_SIZE_MAX);
+    if (cols == meshSize.x && rows == meshSize.y)
+        return;
+
+    meshSize = Point2D(cols, rows);
+    indexLayout = cols*rows > INDEX_STRIP_MAX_QUADS ? eIndexTriangles : eIndexStrip;
+
+    initPositions();
+    initTexCoords();
+    initOffsets();
+    initIndices();
+
+    if (!hasField())
+        setSimulationSize(meshSize);
+
+    if (meshMode == eMeshAdaptive)
+        initQuadTree();
+}
+
+bool RippleEffect::setMeshMode(MeshMode mode)
+{
+    if (mode == meshMode)
+        return true;
+
+    // The topology changes with every update, only the CPU vertex path follows it
+    if (mode == eMeshAdaptive && backend != eBackendVertices)
+    {
+        qWarning("RippleEffect: adaptive meshes need the vertex backend");
+        return false;
+    }
+
+    if (mode == eMeshAdaptive)
+    {
+        setVertexFormat(eVertexFloat);
+        meshMode = mode;
+        initQuadTree();
     }
     else
     {
-        for (int y = 1; y < GRID_SIZE_Y; y++)
-            for (int x = 1; x < GRID_SIZE_X; x++)
-                texCoords[y*(GRID_SIZE_X+1)+x] = texCoordsCopy[y*(GRID_SIZE_X+1)+x];
+        meshMode = mode;
+        initPositions();
+        initTexCoords();
+        initIndices();
+    }
+    return true;
+}
+
+void RippleEffect::setFieldSize(int cols, int rows)
+{
+    fieldSize = Point2D(qBound(1, cols, FIELD_SIZE_MAX), qBound(1, rows, FIELD_SIZE_MAX));
+
+    if (hasField() && (fieldSize.x != simSize.x || fieldSize.y != simSize.y))
+    {
+        setSimulationSize(fieldSize);
+        initField();
+    }
+}
+
+void RippleEffect::setKeyframeInterval(int frames)
+{
+    frames = qBound(1, frames, KEYFRAME_INTERVAL_MAX);
+    if (frames == keyframeInterval)
+        return;
+
+    resetDistortion();
+    keyframeInterval = frames;
+    frameCount = 0;
+}
+
+void RippleEffect::setMaxRipples(int count)
+{
+    ripples.setMaxRipples(count);
+}
+
+void RippleEffect::setPoolSize(int count)
+{
+    ripples.setCapacity(count);
+}
+
+void RippleEffect::setPinnedEdges(int edges)
+{
+    // Newly pinned edges go back to rest; unpinned ones are at rest already
+    if (edges & ~ripples.pinnedEdges())
+        resetDistortion();
+    ripples.setPinnedEdges(edges);
+}
+
+void RippleEffect::setOrigin(float x, float y)
+{
+    if (x == origin.x && y == origin.y)
+        return;
+
+    origin = Vector2D(x, y);
+    ripples.setOrigin(x, y);
+
+    initPositions();
+    if (meshMode == eMeshAdaptive)
+        tessellate(true);
+}
+
+void RippleEffect::setTextureRect(float x, float y, float w, float h)
+{
+    texOrigin = Vector2D(x, y);
+    texSize = Vector2D(w, h);
+}
+
+void RippleEffect::setCulled(bool culled)
+{
+    // Simulate on the next update instead of showing a stale keyframe
+    if (this->culled && !culled)
+        frameCount = keyframeFrames() - 1;
+
+    this->culled = culled;
+}
+
+void RippleEffect::setSimulationSize(const Point2D& size)
+{
+    if (size.x == simSize.x && size.y == simSize.y)
+        return;
 
+    simSize = size;
+    ripples.setGridSize(size.x, size.y);
+
+    if (compute)
+        compute->setVectors(ripples.vectors(), simSize.x, simSize.y);
+}
+
+int RippleEffect::rippleCount() const
+{
+    return ripples.count();
+}
+
+qint64 RippleEffect::evaluationCount() const
+{
+    return evaluations;
+}
+
+qint64 RippleEffect::uploadBytes() const
+{
+    return uploaded;
+}
+
+qint64 RippleEffect::uploadTime() const
+{
+    return uploadNs;
+}
+
+int RippleEffect::retiredCount() const
+{
+    return retired;
+}
+
+long RippleEffect::droppedCount() const
+{
+    return ripples.dropped();
+}
+
+int RippleEffect::vertexCount() const
+{
+    if (meshMode == eMeshAdaptive)
+        return (int) adaptiveVertices.size();
+    return (meshSize.x+1)*(meshSize.y+1);
+}
+
+bool RippleEffect::hasTextureBackend()
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context)
+        return false;
+
+    GLint units = 0;
+    glGetIntegerv(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS, &units);
+    if (units < 1)
+        return false;
+
+    if (context->isOpenGLES())
+        return context->format().majorVersion() >= 3;
+
+    return context->format().majorVersion() >= 3 ||
+           (context->hasExtension("GL_ARB_texture_rg") && context->hasExtension("GL_ARB_half_float_pixel"));
+}
+
+bool RippleEffect::hasSplatBackend()
+{
+    return hasTextureBackend() && RippleSplat::isSupported();
+}
+
+bool RippleEffect::hasComputeBackend()
+{
+    return RippleCompute::isSupported();
+}
+
+bool RippleEffect::hasField() const
+{
+    return backend == eBackendTexture || backend == eBackendSplat;
+}
+
+bool RippleEffect::hasKeyframes() const
+{
+    // Only layouts that keep the displacement apart from the vertices can
+    // be blended; the GPU backends are cheap enough to run every frame
+    return backend == eBackendTexture || (backend == eBackendVertices && vertexFormat == eVertexCompact);
+}
+
+int RippleEffect::keyframeFrames() const
+{
+    return hasKeyframes() ? keyframeInterval : 1;
+}
+
+float RippleEffect::keyframeBlend() const
+{
+    if (keyframeFrames() == 1 || keyframePeriod <= 0)
+        return 1.f;
+
+    // Real time since the last keyframe, relative to the measured keyframe period
+    return qBound(0.f, (float) (clock.nsecsElapsed() - keyframeTime) / keyframePeriod, 1.f);
+}
+
+void RippleEffect::resetDistortion()
+{
+    if (meshMode == eMeshAdaptive)
+    {
+        tessellate(false);
+        return;
+    }
+
+    if (backend == eBackendSplat)
+    {
+        splat->render(nullptr, 0);
+        return;
+    }
+    else if (backend == eBackendTexture)
+    {
+        for (int i = 0; i < (simSize.x+1)*(simSize.y+1); i++)
+            field[i] = Half2D();
+    }
+    else if (vertexFormat == eVertexCompact)
+    {
+        for (int i = 0; i < (meshSize.x+1)*(meshSize.y+1); i++)
+            offsets[i] = Short2D();
+    }
+    else if (distortMode == eDistortVertices)
+    {
+        for (int i = 0; i < (meshSize.x+1)*(meshSize.y+1); i++)
+            vertices[i] = verticesCopy[i];
+    }
+    else
+    {
+        for (int i = 0; i < (meshSize.x+1)*(meshSize.y+1); i++)
+            texCoords[i] = texCoordsCopy[i];
+    }
+
+    writeDistortion();
+
+    // Nothing to blend from after a reset
+    if (backend == eBackendTexture)
+    {
+        fieldPrevTexture->setData(QOpenGLTexture::RG, QOpenGLTexture::Float16, field);
+    }
+    else if (vertexFormat == eVertexCompact)
+    {
+        offsetPrevBuf.bind();
+        offsetPrevBuf.write(0, offsets, (meshSize.x+1)*(meshSize.y+1) * sizeof(Short2D));
+    }
+}
+
+void RippleEffect::writeDistortion()
+{
+    TRACE_ZONE("RippleEffect::writeDistortion");
+    qint64 start = clock.nsecsElapsed();
+    qint64 bytes;
+    if (backend == eBackendTexture)
+    {
+        fieldTexture->setData(QOpenGLTexture::RG, QOpenGLTexture::Float16, field);
+        bytes = (simSize.x+1)*(simSize.y+1) * sizeof(Half2D);
+    }
+    else if (vertexFormat == eVertexCompact)
+    {
+        bytes = (meshSize.x+1)*(meshSize.y+1) * sizeof(Short2D);
+        offsetBuf.bind();
+        offsetBuf.write(0, offsets, bytes);
+    }
+    else if (distortMode == eDistortVertices)
+    {
+        bytes = (meshSize.x+1)*(meshSize.y+1) * sizeof(Vector3D);
+        positionBuf.bind();
+        positionBuf.write(0, vertices, bytes);
+    }
+    else
+    {
+        bytes = (meshSize.x+1)*(meshSize.y+1) * sizeof(Vector2D);
         texCoordBuf.bind();
-        texCoordBuf.write(0, texCoords, (GRID_SIZE_X+1)*(GRID_SIZE_Y+1) * sizeof(Vector2D));
+        texCoordBuf.write(0, texCoords, bytes);
     }
-    distortMode = mode;
+    countUpload(start, bytes);
+}
+
+void RippleEffect::countUpload(qint64 start, qint64 bytes)
+{
+    uploaded += bytes;
+    uploadNs += clock.nsecsElapsed() - start;
+}
+
+RippleEffect::Short2D RippleEffect::packOffset(float x, float y) const
+{
+    return Short2D(packOffsetValue(x), packOffsetValue(y));
 }
 
 float RippleEffect::getDistance(const Vector2D& a, const Vector2D& b)
 {
-    return std::sqrtf((a.x-b.x)*(a.x-b.x) + (a.y-b.y)*(a.y-b.y));
+    return std::sqrt((a.x-b.x)*(a.x-b.x) + (a.y-b.y)*(a.y-b.y));
 }
 
 int	RippleEffect::getMaxDistance(const Vector2D& a, const Vector2D& b)
 {
     float dist = getDistance(a, Vector2D(0,0));
 
-    float temp = getDistance(a, Vector2D(GRID_SIZE_X, 0));
+    float temp = getDistance(a, Vector2D(simSize.x, 0));
     if (temp > dist)
         dist = temp;
 
-    temp = getDistance(a, Vector2D(GRID_SIZE_X, GRID_SIZE_Y));
+    temp = getDistance(a, Vector2D(simSize.x, simSize.y));
     if (temp > dist)
         dist = temp;
 
-    temp = getDistance(a, Vector2D(0, GRID_SIZE_Y));
+    temp = getDistance(a, Vector2D(0, simSize.y));
     if (temp > dist)
         dist = temp;
 
-    return (int) (dist/GRID_SIZE_X)*b.x + RIPPLE_LENGTH/6;
+    return (int) (dist/simSize.x)*b.x + RIPPLE_LENGTH/6;
 }
@@ -4,7 +4,15 @@
 #include <QOpenGLShaderProgram>
 #include <QOpenGLBuffer>
 #include <QOpenGLTexture>
-
+#include <QFloat16>
+#include <QElapsedTimer>
+#include "RippleSplat.h"
+#include "RippleCompute.h"
+#include "RippleQuadTree.h"
+#include "RippleField.h"
+
+// OpenGL side of a ripple field: the mesh, the buffers and textures the
+// displacements go to, and the backend that computes them
 class RippleEffect
 {
     struct Vector2D
@@ -22,6 +30,20 @@ class RippleEffect
         Vector3D(float x = 0, float y = 0, float z = 0) : x(x), y(y), z(z) { }
     };
 
+    struct Short2D
+    {
+        GLshort x;
+        GLshort y;
+        Short2D(GLshort x = 0, GLshort y = 0) : x(x), y(y) { }
+    };
+
+    struct Half2D
+    {
+        qfloat16 x;
+        qfloat16 y;
+        Half2D(float x = 0, float y = 0) : x(x), y(y) { }
+    };
+
     struct Point2D
     {
         int x;
@@ -29,15 +51,6 @@ class RippleEffect
         Point2D(int x = 0, int y = 0) : x(x), y(y) { }
     };
 
-    struct RippleData
-    {
-        int gx;
-        int gy;
-        int delta;
-        int duration;
-        int step;
-    };
-
 public:
 
     enum DistortMode
@@ -46,21 +59,99 @@ public:
         eDistortTexCoords
     };
 
+    enum VertexFormat
+    {
+        eVertexFloat,           // 3 float positions, 2 float texcoords
+        eVertexCompact          // 2 float positions, 16-bit texcoords and offsets
+    };
+
+    enum IndexLayout
+    {
+        eIndexStrip,            // row strips joined by degenerate triangles
+        eIndexTriangles         // triangle list in cache-friendly bands
+    };
+
+    enum Backend
+    {
+        eBackendVertices,       // simulate on the mesh, upload vertex attributes
+        eBackendTexture,        // simulate on its own grid, upload a displacement texture
+        eBackendSplat,          // render ripples into a displacement framebuffer on the GPU
+        eBackendCompute         // evaluate on the mesh in a compute shader, no CPU vertex work
+    };
+
+    enum MeshMode
+    {
+        eMeshUniform,           // fixed grid of meshSize cells
+        eMeshAdaptive           // quadtree refined around active ripples, rebuilt every update
+    };
+
     RippleEffect(QOpenGLShaderProgram *program, float w, float h, QOpenGLTexture *texure = nullptr);
+    RippleEffect(QOpenGLShaderProgram *program, float w, float h, float x, float y);  // centered at (x, y)
     virtual ~RippleEffect();
 
     void draw();
     void update();
 
     void addRipple(float x, float y, int step = 7);
+    void moveRipples(RippleEffect& target);
 
     void setDistortMode(DistortMode mode);
+    void setVertexFormat(VertexFormat format);
+    void setIndexLayout(IndexLayout layout);
+    bool setBackend(Backend backend);
+    bool setMeshMode(MeshMode mode);
+
+    void setMeshSize(int cols, int rows);
+    void setFieldSize(int cols, int rows);
+    void setKeyframeInterval(int frames);
+    void setMaxRipples(int count);
+    void setPoolSize(int count);        // live ripples before the oldest make way
+    void setPinnedEdges(int edges);     // RippleField::Edge flags, the surface border a chunk lies on
+
+    void setOrigin(float x, float y);
+    void setTextureRect(float x, float y, float w, float h);
+    void setCulled(bool culled);
+
+    int rippleCount() const;
+    qint64 evaluationCount() const;     // ripple-vertex evaluations of the last update
+    qint64 uploadBytes() const;         // buffer and texture data written by the last update
+    qint64 uploadTime() const;          // ns spent writing it
+    int vertexCount() const;
+    int retiredCount() const;           // ripples retired by the last update
+    long droppedCount() const;          // ripples the full pool dropped, in all
+
+    bool hasKeyframes() const;          // whether keyframe intervals above 1 take effect
+
+    static bool hasTextureBackend();
+    static bool hasSplatBackend();
+    static bool hasComputeBackend();
 
 private:
 
     void initPositions();
     void initTexCoords();
+    void initOffsets();
     void initIndices();
+    void initField();
+    void packInstances();
+    void splatRipples();
+    void computeRipples();
+    void initQuadTree();
+    void tessellate(bool displace);
+
+    void allocatePositions();
+    void allocateTexCoords();
+
+    void resetDistortion();
+    void writeDistortion();
+    void countUpload(qint64 start, qint64 bytes);
+
+    Short2D packOffset(float x, float y) const;
+
+    void setSimulationSize(const Point2D& size);
+    bool hasField() const;
+    int keyframeFrames() const;
+    float keyframeBlend() const;
 
     float getDistance(const Vector2D& a, const Vector2D& b);
     int	getMaxDistance(const Vector2D& a, const Vector2D& b);
@@ -68,20 +159,57 @@ private:
     QOpenGLShaderProgram *program;
     QOpenGLBuffer positionBuf;
     QOpenGLBuffer texCoordBuf;
+    QOpenGLBuffer offsetBuf;
+    QOpenGLBuffer offsetPrevBuf;
     QOpenGLBuffer indexBuf;
+    QOpenGLTexture *fieldTexture;
+    QOpenGLTexture *fieldPrevTexture;
+    RippleSplat *splat;
+    RippleCompute *compute;
 
     DistortMode distortMode;
+    VertexFormat vertexFormat;
+    IndexLayout indexLayout;
+    Backend backend;
+    MeshMode meshMode;
+    int indexCount;
+    qint64 evaluations;
+    int retired;
+    qint64 uploaded;            // bytes and ns of uploads since the last update started
+    qint64 uploadNs;
+
+    int keyframeInterval;       // display frames per simulated frame
+    int frameCount;
+    QElapsedTimer clock;
+    qint64 keyframeTime;        // when the current keyframe was simulated, in ns
+    qint64 keyframePeriod;      // measured time between the last two keyframes
 
     Vector2D imgSize;
+    Vector2D origin;            // center of the mesh, in pixels
+    Vector2D texOrigin;         // part of the image the mesh shows
     Vector2D texSize;
+    bool culled;                // outside the view, ripples advance but nothing is evaluated
 
-    std::vector<RippleData> ripples;
+    Point2D meshSize;           // render mesh, in cells
+    Point2D fieldSize;          // simulation grid of the texture and splat backends
+    Point2D simSize;            // grid the ripples are evaluated on
+
+    RippleField ripples;
+    std::vector<RippleSplat::Instance> instances;
+
+    RippleQuadTree quadTree;
+    std::vector<RippleQuadTree::Annulus> annuli;
+    std::vector<Vector3D> adaptiveVertices;
+    std::vector<Vector2D> adaptiveTexCoords;
 
     Vector3D* vertices;
     Vector3D* verticesCopy;
 
     Vector2D* texCoords;
     Vector2D* texCoordsCopy;
+
+    Short2D* offsets;
+    Half2D* field;
 };
 
 #endif // RIPPLEEFFECT_H
@@ -4,22 +4,68 @@
 #
 #-------------------------------------------------
 
-QT       += core gui opengl
+QT       += core gui opengl concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 TARGET = RippleEffect
 TEMPLATE = app
 
+# Trace zones for --trace, built with qmake CONFIG+=trace; without it
+# they compile to nothing
+trace {
+    DEFINES += RIPPLE_TRACE
+    SOURCES += FrameTrace.cpp
+}
+
 
 SOURCES +=\
     RippleEffect.cpp \
+    RippleSplat.cpp \
+    RippleCompute.cpp \
+    QualityController.cpp \
+    RippleQuadTree.cpp \
+    RippleField.cpp \
+    RippleLog.cpp \
+    RippleEmitter.cpp \
+    RippleGeometry.cpp \
+    RippleSurface.cpp \
+    RippleLayout.cpp \
+    TiledTexture.cpp \
+    TextureCodec.cpp \
+    TextureCache.cpp \
+    TextureLoader.cpp \
+    TextureManager.cpp \
+    StartupGraph.cpp \
+    FrameStats.cpp \
+    FrameTelemetry.cpp \
+    PerfHud.cpp \
     GLWidget.cpp \
     Window.cpp \
     Main.cpp
 
 HEADERS  += \
     RippleEffect.h \
+    RippleSplat.h \
+    RippleCompute.h \
+    QualityController.h \
+    RippleQuadTree.h \
+    RippleField.h \
+    RippleLog.h \
+    RippleEmitter.h \
+    RippleGeometry.h \
+    RippleSurface.h \
+    RippleLayout.h \
+    TiledTexture.h \
+    TextureCodec.h \
+    TextureCache.h \
+    TextureLoader.h \
+    TextureManager.h \
+    StartupGraph.h \
+    FrameStats.h \
+    FrameTelemetry.h \
+    FrameTrace.h \
+    PerfHud.h \
     GLWidget.h \
     Window.h \
     RippleTable.h
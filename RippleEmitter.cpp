@@ -0,0 +1,145 @@
+#include "RippleEmitter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+#define EMIT_DRAG_TURN          0.3f        // largest heading change per update, radians
+#define EMIT_RESERVE            256         // drops one update holds without allocating
+
+RippleEmitter::RippleEmitter(const Config& config, float w, float h)
+    : settings(config), width(w), height(h), frame(0), rng(config.seed), pathX(0), pathY(0), heading(0), pending(0)
+{
+    drops.reserve(std::max(EMIT_RESERVE, config.count));
+
+    std::uniform_real_distribution<float> angle(0.f, 6.2831853f);
+    heading = angle(rng);
+}
+
+RippleEmitter::Config RippleEmitter::defaults(Kind kind)
+{
+    Config config = { kind, 0.25f, 8.f, 100, 60, 7, 1 };
+    if (kind == eEmitDrag)
+        config.rate = 1.f;
+    return config;
+}
+
+bool RippleEmitter::parse(const std::string& spec, Config& config)
+{
+    std::string kind = spec.substr(0, spec.find(':'));
+    if (kind == "rain")
+        config = defaults(eEmitRain);
+    else if (kind == "drag")
+        config = defaults(eEmitDrag);
+    else if (kind == "burst")
+        config = defaults(eEmitBurst);
+    else
+        return false;
+
+    if (kind.size() == spec.size())
+        return true;
+
+    std::istringstream options(spec.substr(kind.size() + 1));
+    std::string option;
+    while (std::getline(options, option, ','))
+    {
+        size_t equals = option.find('=');
+        if (equals == std::string::npos)
+            return false;
+
+        std::string key = option.substr(0, equals);
+        const char *text = option.c_str() + equals + 1;
+        char *end = nullptr;
+        double value = std::strtod(text, &end);
+        if (end == text || *end != '\0' || value < 0)
+            return false;
+
+        if (key == "rate")
+            config.rate = (float) value;
+        else if (key == "speed")
+            config.speed = (float) value;
+        else if (key == "count")
+            config.count = (int) value;
+        else if (key == "period")
+            config.period = std::max(1, (int) value);
+        else if (key == "step")
+            config.step = std::max(1, (int) value);
+        else if (key == "seed")
+            config.seed = (unsigned) value;
+        else
+            return false;
+    }
+
+    // A Poisson distribution needs a positive mean
+    return config.kind != eEmitRain || config.rate > 0;
+}
+
+const std::vector<RippleEmitter::Drop>& RippleEmitter::next()
+{
+    drops.clear();
+    std::uniform_real_distribution<float> x(-width/2, width/2);
+    std::uniform_real_distribution<float> y(-height/2, height/2);
+
+    if (settings.kind == eEmitRain)
+    {
+        // Independent drops, so the count per update is Poisson distributed;
+        // the distribution needs a positive mean
+        if (settings.rate > 0)
+        {
+            std::poisson_distribution<int> count(settings.rate);
+            for (int i = count(rng); i > 0; i--)
+                drop(x(rng), y(rng));
+        }
+    }
+    else if (settings.kind == eEmitDrag)
+    {
+        // A path that wanders and bounces off the edges, dropping ripples
+        // evenly along it like a dragged pointer
+        std::uniform_real_distribution<float> turn(-EMIT_DRAG_TURN, EMIT_DRAG_TURN);
+        float fromX = pathX;
+        float fromY = pathY;
+        heading += turn(rng);
+        pathX += std::cos(heading) * settings.speed;
+        pathY += std::sin(heading) * settings.speed;
+        if (std::fabs(pathX) > width/2)
+        {
+            pathX = std::max(-width/2, std::min(pathX, width/2));
+            heading = 3.1415927f - heading;
+        }
+        if (std::fabs(pathY) > height/2)
+        {
+            pathY = std::max(-height/2, std::min(pathY, height/2));
+            heading = -heading;
+        }
+
+        // A drop falls where the carried rate reaches a whole drop, so the
+        // spacing stays even within an update and across updates
+        float start = pending;
+        pending += settings.rate;
+        for (int i = 1; i <= (int) pending; i++)
+        {
+            float t = (i - start) / settings.rate;
+            drop(fromX + (pathX - fromX) * t, fromY + (pathY - fromY) * t);
+        }
+        pending -= std::floor(pending);
+    }
+    else if (frame % settings.period == 0)
+    {
+        for (int i = 0; i < settings.count; i++)
+            drop(x(rng), y(rng));
+    }
+
+    frame++;
+    return drops;
+}
+
+const RippleEmitter::Config& RippleEmitter::config() const
+{
+    return settings;
+}
+
+void RippleEmitter::drop(float x, float y)
+{
+    Drop drop = { x, y, settings.step };
+    drops.push_back(drop);
+}
@@ -0,0 +1,72 @@
+#ifndef RIPPLEEMITTER_H
+#define RIPPLEEMITTER_H
+
+#include <random>
+#include <string>
+#include <vector>
+
+// Synthetic ripple load: drops to add before each update, from a seeded
+// generator so a workload repeats from run to run. Positions are surface
+// pixels, centered with y up, like RippleSurface::addRipple takes them.
+//
+// Workloads are described as "kind:key=value,...", for example
+//   rain:rate=0.5             Poisson rain, mean drops per update, above 0
+//   drag:speed=12,rate=1      a wandering drag path, pixels and drops per update
+//   burst:count=200,period=90 'count' drops at once every 'period' updates
+// with step and seed accepted by all of them.
+class RippleEmitter
+{
+public:
+
+    enum Kind
+    {
+        eEmitRain,
+        eEmitDrag,
+        eEmitBurst
+    };
+
+    struct Config
+    {
+        Kind kind;
+        float rate;             // drops per update, rain and drag
+        float speed;            // drag path, pixels per update
+        int count;              // burst size
+        int period;             // updates between bursts
+        int step;               // ripple speed
+        unsigned seed;
+    };
+
+    struct Drop
+    {
+        float x;
+        float y;
+        int step;
+    };
+
+    RippleEmitter(const Config& config, float w, float h);
+
+    static Config defaults(Kind kind);
+    static bool parse(const std::string& spec, Config& config);
+
+    // Drops for the next update; valid until the next call
+    const std::vector<Drop>& next();
+
+    const Config& config() const;
+
+private:
+    void drop(float x, float y);
+
+    Config settings;
+    float width;
+    float height;
+    unsigned frame;
+
+    std::mt19937 rng;
+    std::vector<Drop> drops;
+    float pathX;                // drag position and heading
+    float pathY;
+    float heading;
+    float pending;              // fractional drops carried to the next update
+};
+
+#endif // RIPPLEEMITTER_H
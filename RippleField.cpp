@@ -0,0 +1,236 @@
+#include "RippleField.h"
+#include <algorithm>
+#include <cmath>
+
+RippleField::RippleField(float w, float h, int cols, int rows, int capacity)
+    : width(w), height(h), originX(0), originY(0), cols(cols), rows(rows), maxRipples(0), pinned(eEdgesAll), head(0), overflow(0), poolSize(std::max(1, capacity))
+{
+    ripples.reserve(2 * poolSize);
+    table = RippleGeometry::vectors(cols, rows);
+
+    // Part of the amplitude table a wave is still visible in
+    active[0] = 0;
+    active[1] = RIPPLE_LENGTH-1;
+    while (active[0] < active[1] && std::fabs(g_ripple_amp[active[0]].amplitude) < QUADTREE_AMP_THRESHOLD)
+        active[0]++;
+    while (active[1] > active[0] && std::fabs(g_ripple_amp[active[1]].amplitude) < QUADTREE_AMP_THRESHOLD)
+        active[1]--;
+}
+
+void RippleField::addRipple(float x, float y, int step)
+{
+    x += width/2 - originX;
+    y = height - (y - originY + height/2);
+
+    // May lie outside the grid when a neighbouring chunk was hit
+    Ripple ripple =
+    {
+        (int) std::floor(x/width * cols),
+        (int) std::floor(y/height * rows),
+        0,
+        (int) std::sqrt(width*width + height*height) + RIPPLE_LENGTH,
+        step
+    };
+
+    push(ripple);
+    trim();
+}
+
+void RippleField::moveRipples(RippleField& target)
+{
+    // Hand live ripples over to another grid, at the same place on it
+    for (auto iter = ripples.begin() + head; iter != ripples.end(); ++iter)
+    {
+        Ripple ripple = *iter;
+        ripple.gx = ripple.gx * target.cols / cols;
+        ripple.gy = ripple.gy * target.rows / rows;
+        target.push(ripple);
+    }
+    target.trim();
+
+    clear();
+}
+
+void RippleField::clear()
+{
+    ripples.clear();
+    head = 0;
+}
+
+int RippleField::advance(int frames)
+{
+    // One pass that keeps the order, then the survivors move to the front
+    // over the dropped ripples
+    auto last = std::remove_if(ripples.begin() + head, ripples.end(), [](const Ripple& ripple) {
+        return ripple.delta > ripple.duration;
+    });
+    int retired = (int) (ripples.end() - last);
+    if (head > 0)
+        last = std::move(ripples.begin() + head, last, ripples.begin());
+    ripples.erase(last, ripples.end());
+    head = 0;
+
+    for (Ripple& ripple : ripples)
+        ripple.delta += ripple.step * frames;
+    return retired;
+}
+
+void RippleField::sample(float x, float y, float scale, const Instance *instances, int count, float dx, float dy, float& ox, float& oy)
+{
+    ox = 0;
+    oy = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        const Instance& instance = instances[i];
+        if (instance.amp < QUADTREE_RIPPLE_MIN)
+            continue;
+
+        // The distance and direction the vector table holds for grid points
+        float fx = (x - instance.x) / scale;
+        float fy = (y - instance.y) / scale;
+        float d = std::sqrt(fx*fx + fy*fy);
+        if (d <= 0)
+            continue;
+
+        int r = std::min(std::max((int) instance.delta - (int) (d * RIPPLE_CELL_LENGTH), 0), RIPPLE_LENGTH-1);
+        ox += fx/d * dx * g_ripple_amp[r].amplitude * instance.amp;
+        oy += fy/d * dy * g_ripple_amp[r].amplitude * instance.amp;
+    }
+}
+
+void RippleField::pack(Instance *instances) const
+{
+    for (int i = 0; i < count(); i++)
+    {
+        const Ripple& ripple = ripples[head + i];
+
+        instances[i].x = ripple.gx;
+        instances[i].y = ripple.gy;
+        instances[i].delta = ripple.delta;
+        instances[i].amp = envelope(ripple.delta);
+    }
+}
+
+void RippleField::setGridSize(int cols, int rows)
+{
+    if (cols == this->cols && rows == this->rows)
+        return;
+
+    // Keep live ripples at the same place on the new grid
+    for (auto ripple = ripples.begin() + head; ripple != ripples.end(); ++ripple)
+    {
+        ripple->gx = ripple->gx * cols / this->cols;
+        ripple->gy = ripple->gy * rows / this->rows;
+    }
+
+    this->cols = cols;
+    this->rows = rows;
+
+    // Shared by every field of this size, and often built ahead on a worker
+    table = RippleGeometry::vectors(cols, rows);
+}
+
+void RippleField::setOrigin(float x, float y)
+{
+    originX = x;
+    originY = y;
+}
+
+void RippleField::setMaxRipples(int count)
+{
+    maxRipples = std::max(0, count);
+    trim();
+}
+
+void RippleField::setCapacity(int capacity)
+{
+    capacity = std::max(1, capacity);
+    if (count() > capacity)
+        head += count() - capacity;
+
+    ripples.erase(ripples.begin(), ripples.begin() + head);
+    head = 0;
+    poolSize = capacity;
+    ripples.reserve(2 * poolSize);
+}
+
+void RippleField::setPinnedEdges(int edges)
+{
+    pinned = edges & eEdgesAll;
+}
+
+void RippleField::evaluatedRange(int& x0, int& y0, int& x1, int& y1) const
+{
+    x0 = pinned & eEdgeLeft ? 1 : 0;
+    y0 = pinned & eEdgeTop ? 1 : 0;
+    x1 = pinned & eEdgeRight ? cols-1 : cols;
+    y1 = pinned & eEdgeBottom ? rows-1 : rows;
+}
+
+int RippleField::evaluatedCount() const
+{
+    int x0, y0, x1, y1;
+    evaluatedRange(x0, y0, x1, y1);
+    return std::max(0, x1-x0+1) * std::max(0, y1-y0+1);
+}
+
+int RippleField::count() const
+{
+    return (int) ripples.size() - head;
+}
+
+int RippleField::capacity() const
+{
+    return poolSize;
+}
+
+int RippleField::pinnedEdges() const
+{
+    return pinned;
+}
+
+long RippleField::dropped() const
+{
+    return overflow;
+}
+
+int RippleField::activeBegin() const
+{
+    return active[0];
+}
+
+int RippleField::activeEnd() const
+{
+    return active[1];
+}
+
+const RIPPLE_VECTOR *RippleField::vectors() const
+{
+    return table->data();
+}
+
+void RippleField::push(const Ripple& ripple)
+{
+    // A full pool drops its oldest, weakest ripple rather than growing.
+    // Dropped ripples are only compacted away once the reserve runs out,
+    // once per pool's worth of drops.
+    if (count() >= poolSize)
+    {
+        head++;
+        overflow++;
+    }
+    if ((int) ripples.size() == 2 * poolSize)
+    {
+        ripples.erase(ripples.begin(), ripples.begin() + head);
+        head = 0;
+    }
+    ripples.push_back(ripple);
+}
+
+void RippleField::trim()
+{
+    // The oldest ripples are the weakest, drop those first
+    if (maxRipples > 0 && count() > maxRipples)
+        head += count() - maxRipples;
+}
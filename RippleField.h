@@ -0,0 +1,175 @@
+#ifndef RIPPLEFIELD_H
+#define RIPPLEFIELD_H
+
+#include <vector>
+#include "RippleTable.h"
+#include "RippleGeometry.h"
+
+// The ripple simulation without Qt or OpenGL: a pool of live ripples on a
+// grid of cols x rows cells over a w x h area, and the kernels that turn
+// them into displacements. The pool is sized up front, so adding,
+// advancing and evaluating never allocate, and a full pool drops its oldest
+// ripple in constant time; RippleEffect uploads what the kernels produce.
+class RippleField
+{
+public:
+
+    struct Ripple
+    {
+        int gx;                 // center, in grid vertices; may lie outside the grid
+        int gy;
+        int delta;              // wavefront distance
+        int duration;
+        int step;               // wavefront advance per frame
+    };
+
+    struct Instance
+    {
+        float x;                // ripple center, in grid vertices
+        float y;
+        float delta;            // wavefront distance
+        float amp;              // envelope of the whole ripple
+    };
+
+    // Grid edges held at rest. Chunks of a larger surface pin only the
+    // ones on its outer border, so waves run on across shared edges.
+    enum Edge
+    {
+        eEdgeLeft = 1,
+        eEdgeRight = 2,
+        eEdgeTop = 4,           // grid row 0
+        eEdgeBottom = 8,
+        eEdgesAll = 15
+    };
+
+    RippleField(float w, float h, int cols = GRID_SIZE_X, int rows = GRID_SIZE_Y, int capacity = RIPPLE_POOL_SIZE);
+
+    void addRipple(float x, float y, int step = 7);
+    void moveRipples(RippleField& target);
+    void clear();
+
+    // Moves every wavefront on by 'frames' simulated frames and retires
+    // the ripples that have crossed the grid; returns how many retired
+    int advance(int frames);
+
+    // Displacement of every grid vertex off the pinned edges, scaled by dx
+    // and dy. store(index, ox, oy) gets each result at index y*(cols+1)+x,
+    // so callers pack it straight into the layout they upload.
+    template <typename Store>
+    void evaluate(float dx, float dy, Store store) const;
+
+    // Displacement at a point between grid vertices. Point and instances
+    // are in cells of a grid 'scale' times finer than the reference grid;
+    // on grid vertices this matches evaluate().
+    static void sample(float x, float y, float scale, const Instance *instances, int count, float dx, float dy, float& ox, float& oy);
+
+    void pack(Instance *instances) const;   // count() entries
+
+    void setGridSize(int cols, int rows);
+    void setOrigin(float x, float y);
+    void setMaxRipples(int count);
+    void setCapacity(int capacity);         // pool size; allocates, keeps the newest ripples
+    void setPinnedEdges(int edges);         // Edge flags, eEdgesAll by default
+
+    // Grid vertices evaluate() writes, first to last inclusive
+    void evaluatedRange(int& x0, int& y0, int& x1, int& y1) const;
+    int evaluatedCount() const;
+
+    int count() const;
+    int capacity() const;
+    int pinnedEdges() const;
+    long dropped() const;       // ripples a full pool dropped to make way, since construction
+    int activeBegin() const;    // amplitude table range above QUADTREE_AMP_THRESHOLD
+    int activeEnd() const;
+    const RIPPLE_VECTOR *vectors() const;
+
+private:
+
+    static float envelope(int delta);
+
+    void push(const Ripple& ripple);
+    void trim();
+
+    float width;
+    float height;
+    float originX;              // center of the area
+    float originY;
+    int cols;
+    int rows;
+    int maxRipples;             // live ripple limit, 0 for the pool size
+    int pinned;                 // Edge flags
+    int active[2];
+
+    std::vector<Ripple> ripples;            // oldest first, reserved to twice the pool size
+    int head;                               // first live ripple, the ones before it were dropped
+    long overflow;                          // ripples dropped by a full pool
+    int poolSize;
+    RippleGeometry::Vectors table;
+};
+
+inline float RippleField::envelope(int delta)
+{
+    float amp = 1.f - (float) delta/RIPPLE_LENGTH;
+    amp *= amp;
+    if (amp < 0)
+        amp = 0;
+    return amp;
+}
+
+template <typename Store>
+void RippleField::evaluate(float dx, float dy, Store store) const
+{
+    const RIPPLE_VECTOR *vectors = table->data();
+    int x0, y0, x1, y1;
+    evaluatedRange(x0, y0, x1, y1);
+
+    for (int y = y0; y <= y1; y++)
+    {
+        for (int x = x0; x <= x1; x++)
+        {
+            float ox = 0;
+            float oy = 0;
+
+            for (auto ripple = ripples.begin() + head; ripple != ripples.end(); ++ripple)
+            {
+                int mx = x - ripple->gx;
+                int my = y - ripple->gy;
+                float sx = dx;
+                float sy = dy;
+
+                if (mx < 0)
+                {
+                    mx *= -1;
+                    sx *= -1;
+                }
+
+                if (my < 0)
+                {
+                    my *= -1;
+                    sy *= -1;
+                }
+
+                // Ripples of neighbouring chunks may lie beyond the table
+                bool inside = mx <= cols && my <= rows;
+                RIPPLE_VECTOR far;
+                if (!inside)
+                    far = makeRippleVector(mx, my, cols, rows);
+                const RIPPLE_VECTOR &vector = inside ? vectors[my*(cols+1)+mx] : far;
+
+                int r = ripple->delta - vector.r;
+                if (r < 0)
+                    r = 0;
+                else if (r > RIPPLE_LENGTH-1)
+                    r = RIPPLE_LENGTH-1;
+
+                float amp = envelope(ripple->delta);
+                ox += vector.dx * sx * g_ripple_amp[r].amplitude * amp;
+                oy += vector.dy * sy * g_ripple_amp[r].amplitude * amp;
+            }
+
+            store(y*(cols+1)+x, ox, oy);
+        }
+    }
+}
+
+#endif // RIPPLEFIELD_H
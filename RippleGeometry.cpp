@@ -0,0 +1,119 @@
+#include "RippleGeometry.h"
+#include <algorithm>
+#include <mutex>
+
+#define GEOMETRY_CACHE_SIZE     8           // tables kept of each kind
+
+struct GeometryEntry
+{
+    int cols;
+    int rows;
+    bool triangles;
+    std::shared_ptr<const void> table;
+};
+
+static std::mutex cacheMutex;
+static std::vector<GeometryEntry> vectorTables;     // most recently used last
+static std::vector<GeometryEntry> indexTables;
+
+// Looks the table up, building it on a miss. Built under the lock, so two
+// threads asking for one size build it once.
+template <typename T, typename Build>
+static std::shared_ptr<const T> lookup(std::vector<GeometryEntry>& tables, int cols, int rows, bool triangles, Build build)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    auto it = std::find_if(tables.begin(), tables.end(), [&](const GeometryEntry &e) {
+        return e.cols == cols && e.rows == rows && e.triangles == triangles;
+    });
+
+    GeometryEntry entry;
+    if (it != tables.end())
+    {
+        entry = *it;
+        tables.erase(it);
+    }
+    else
+    {
+        entry = GeometryEntry{ cols, rows, triangles, std::make_shared<const T>(build()) };
+        if (tables.size() >= GEOMETRY_CACHE_SIZE)
+            tables.erase(tables.begin());
+    }
+
+    tables.push_back(entry);
+    return std::static_pointer_cast<const T>(entry.table);
+}
+
+RippleGeometry::Vectors RippleGeometry::vectors(int cols, int rows)
+{
+    return lookup<std::vector<RIPPLE_VECTOR>>(vectorTables, cols, rows, false, [&]() {
+        std::vector<RIPPLE_VECTOR> table((cols+1)*(rows+1));
+        buildRippleVectors(table.data(), cols, rows);
+        return table;
+    });
+}
+
+RippleGeometry::Indices RippleGeometry::indices(int cols, int rows, bool triangles)
+{
+    return lookup<std::vector<unsigned short>>(indexTables, cols, rows, triangles, [&]() {
+        return buildIndices(cols, rows, triangles);
+    });
+}
+
+void RippleGeometry::prepare(int cols, int rows)
+{
+    vectors(cols, rows);
+    indices(cols, rows, cols*rows > INDEX_STRIP_MAX_QUADS);
+}
+
+std::vector<unsigned short> RippleGeometry::buildIndices(int cols, int rows, bool triangles)
+{
+    std::vector<unsigned short> indices;
+
+    if (triangles)
+    {
+        // Walk the grid in vertical bands narrow enough that the previous
+        // row of a band is still in the post-transform cache
+        indices.reserve(cols*rows*6);
+        for (int bx = 0; bx < cols; bx += INDEX_BAND_WIDTH)
+        {
+            int ex = bx + INDEX_BAND_WIDTH < cols ? bx + INDEX_BAND_WIDTH : cols;
+            for (int y = 0; y < rows; y++)
+            {
+                for (int x = bx; x < ex; x++)
+                {
+                    unsigned short tl = y*(cols+1)+x;
+                    unsigned short bl = (y+1)*(cols+1)+x;
+
+                    indices.push_back(tl);
+                    indices.push_back(bl);
+                    indices.push_back(tl+1);
+                    indices.push_back(tl+1);
+                    indices.push_back(bl);
+                    indices.push_back(bl+1);
+                }
+            }
+        }
+    }
+    else
+    {
+        // One strip per row, joined by two degenerate triangles. Each row has
+        // an even number of indices, so the winding stays the same.
+        indices.reserve((cols+1)*rows*2 + (rows-1)*2);
+        for (int y = 0; y < rows; y++)
+        {
+            if (y > 0)
+            {
+                indices.push_back(indices.back());
+                indices.push_back(y*(cols+1));
+            }
+
+            for (int x = 0; x <= cols; x++)
+            {
+                indices.push_back(y*(cols+1)+x);
+                indices.push_back((y+1)*(cols+1)+x);
+            }
+        }
+    }
+    return indices;
+}
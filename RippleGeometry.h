@@ -0,0 +1,29 @@
+#ifndef RIPPLEGEOMETRY_H
+#define RIPPLEGEOMETRY_H
+
+#include <memory>
+#include <vector>
+#include "RippleTable.h"
+
+// Tables every ripple effect of one grid size shares: the ripple vectors of
+// a simulation grid and the index buffer contents of a mesh. Each is built
+// once, on whichever thread asks first, and handed out read-only. A few of
+// the most recently used sizes are kept.
+class RippleGeometry
+{
+public:
+
+    typedef std::shared_ptr<const std::vector<RIPPLE_VECTOR>> Vectors;
+    typedef std::shared_ptr<const std::vector<unsigned short>> Indices;
+
+    static Vectors vectors(int cols, int rows);
+    static Indices indices(int cols, int rows, bool triangles);
+
+    // Builds the tables of a mesh size ahead of use, from a worker thread
+    static void prepare(int cols, int rows);
+
+private:
+    static std::vector<unsigned short> buildIndices(int cols, int rows, bool triangles);
+};
+
+#endif // RIPPLEGEOMETRY_H
@@ -0,0 +1,55 @@
+#include "RippleLayout.h"
+#include "RippleField.h"
+#include <algorithm>
+#include <cmath>
+
+RippleLayout::RippleLayout(float w, float h)
+    : width(w), height(h)
+{
+    // Equal chunks, so waves run at the same speed across chunk borders
+    numCols = std::max(1, (int) std::ceil(w / SURFACE_CHUNK_SIZE));
+    numRows = std::max(1, (int) std::ceil(h / SURFACE_CHUNK_SIZE));
+    chunkWidth = w / numCols;
+    chunkHeight = h / numRows;
+
+    // Wave distance a ripple covers before it retires, converted to pixels
+    float diagonal = std::sqrt(chunkWidth*chunkWidth + chunkHeight*chunkHeight);
+    reach = (float) ((diagonal + RIPPLE_LENGTH) / RIPPLE_CELL_LENGTH) * std::max(chunkWidth / GRID_SIZE_X, chunkHeight / GRID_SIZE_Y);
+}
+
+int RippleLayout::cols() const
+{
+    return numCols;
+}
+
+int RippleLayout::rows() const
+{
+    return numRows;
+}
+
+int RippleLayout::count() const
+{
+    return numCols * numRows;
+}
+
+RippleLayout::Chunk RippleLayout::chunk(int index) const
+{
+    int col = index % numCols;
+    int row = index / numCols;
+
+    // Only the surface's outer border stays at rest, waves cross the seams
+    int pinned = (col == 0 ? RippleField::eEdgeLeft : 0) | (col == numCols-1 ? RippleField::eEdgeRight : 0) |
+                 (row == 0 ? RippleField::eEdgeTop : 0) | (row == numRows-1 ? RippleField::eEdgeBottom : 0);
+
+    Chunk chunk = { col, row, -width/2 + col * chunkWidth, height/2 - (row + 1) * chunkHeight, chunkWidth, chunkHeight,
+                    -width/2 + (col + 0.5f) * chunkWidth, height/2 - (row + 0.5f) * chunkHeight, pinned };
+    return chunk;
+}
+
+bool RippleLayout::reaches(int index, float x, float y) const
+{
+    Chunk chunk = this->chunk(index);
+    float dx = std::max(0.f, std::max(chunk.left - x, x - (chunk.left + chunk.width)));
+    float dy = std::max(0.f, std::max(chunk.bottom - y, y - (chunk.bottom + chunk.height)));
+    return dx*dx + dy*dy <= reach*reach;
+}
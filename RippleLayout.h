@@ -0,0 +1,47 @@
+#ifndef RIPPLELAYOUT_H
+#define RIPPLELAYOUT_H
+
+// How a ripple surface of w x h pixels splits into equal chunks of at most
+// SURFACE_CHUNK_SIZE pixels, without Qt. RippleSurface builds its chunks on
+// it and replay_bench replays logs on it, so both simulate the same thing.
+// Chunks run left to right, top to bottom; positions are surface pixels,
+// centered on (0, 0) with y up.
+class RippleLayout
+{
+public:
+
+    struct Chunk
+    {
+        int col;
+        int row;                // 0 at the top
+        float left;
+        float bottom;
+        float width;            // the same for every chunk
+        float height;
+        float x;                // center
+        float y;
+        int pinned;             // RippleField edges on the surface border
+    };
+
+    RippleLayout(float w, float h);
+
+    int cols() const;
+    int rows() const;
+    int count() const;
+
+    Chunk chunk(int index) const;
+
+    // Whether a ripple dropped at (x, y) can get to the chunk before it retires
+    bool reaches(int index, float x, float y) const;
+
+private:
+    float width;
+    float height;
+    int numCols;
+    int numRows;
+    float chunkWidth;
+    float chunkHeight;
+    float reach;                // farthest a ripple travels in its lifetime, in pixels
+};
+
+#endif // RIPPLELAYOUT_H
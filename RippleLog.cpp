@@ -0,0 +1,154 @@
+#include "RippleLog.h"
+#include <cstring>
+
+#define RIPPLE_LOG_MAGIC        "RPLG"
+#define RIPPLE_LOG_VERSION      1
+#define RIPPLE_LOG_HEADER_SIZE  16
+#define RIPPLE_LOG_EVENT_SIZE   20
+
+static void putU32(unsigned char *out, unsigned value)
+{
+    out[0] = value & 0xff;
+    out[1] = (value >> 8) & 0xff;
+    out[2] = (value >> 16) & 0xff;
+    out[3] = (value >> 24) & 0xff;
+}
+
+static unsigned getU32(const unsigned char *in)
+{
+    return in[0] | (in[1] << 8) | (in[2] << 16) | ((unsigned) in[3] << 24);
+}
+
+static void putF32(unsigned char *out, float value)
+{
+    unsigned bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putU32(out, bits);
+}
+
+static float getF32(const unsigned char *in)
+{
+    unsigned bits = getU32(in);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+RippleLog::RippleLog() : file(nullptr), w(0), h(0)
+{
+}
+
+RippleLog::~RippleLog()
+{
+    close();
+}
+
+bool RippleLog::create(const char *fileName, float width, float height)
+{
+    close();
+    file = std::fopen(fileName, "wb");
+    if (!file)
+        return false;
+
+    w = width;
+    h = height;
+
+    unsigned char header[RIPPLE_LOG_HEADER_SIZE];
+    std::memcpy(header, RIPPLE_LOG_MAGIC, 4);
+    putU32(header + 4, RIPPLE_LOG_VERSION);
+    putF32(header + 8, w);
+    putF32(header + 12, h);
+    if (std::fwrite(header, sizeof(header), 1, file) != 1 || std::fflush(file) != 0)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void RippleLog::append(const Event& event)
+{
+    if (!file)
+        return;
+
+    // Settings are small enums and slider values, a byte each
+    unsigned char record[RIPPLE_LOG_EVENT_SIZE];
+    putU32(record, event.frame);
+    putU32(record + 4, event.time);
+    putF32(record + 8, event.x);
+    putF32(record + 12, event.y);
+    record[16] = (unsigned char) event.step;
+    record[17] = (unsigned char) event.texture;
+    record[18] = (unsigned char) event.distort;
+    record[19] = 0;
+
+    std::fwrite(record, sizeof(record), 1, file);
+    std::fflush(file);
+}
+
+void RippleLog::close()
+{
+    if (file)
+        std::fclose(file);
+    file = nullptr;
+}
+
+bool RippleLog::isOpen() const
+{
+    return file != nullptr;
+}
+
+bool RippleLog::load(const char *fileName)
+{
+    close();
+    list.clear();
+
+    FILE *in = std::fopen(fileName, "rb");
+    if (!in)
+        return false;
+
+    unsigned char header[RIPPLE_LOG_HEADER_SIZE];
+    if (std::fread(header, sizeof(header), 1, in) != 1 || std::memcmp(header, RIPPLE_LOG_MAGIC, 4) != 0 ||
+        getU32(header + 4) != RIPPLE_LOG_VERSION)
+    {
+        std::fclose(in);
+        return false;
+    }
+    w = getF32(header + 8);
+    h = getF32(header + 12);
+
+    // A log cut short by a crash keeps its complete records
+    unsigned char record[RIPPLE_LOG_EVENT_SIZE];
+    while (std::fread(record, sizeof(record), 1, in) == 1)
+    {
+        Event event =
+        {
+            getU32(record),
+            getU32(record + 4),
+            getF32(record + 8),
+            getF32(record + 12),
+            record[16],
+            record[17],
+            record[18]
+        };
+        list.push_back(event);
+    }
+
+    std::fclose(in);
+    return true;
+}
+
+float RippleLog::width() const
+{
+    return w;
+}
+
+float RippleLog::height() const
+{
+    return h;
+}
+
+const std::vector<RippleLog::Event>& RippleLog::events() const
+{
+    return list;
+}
@@ -0,0 +1,50 @@
+#ifndef RIPPLELOG_H
+#define RIPPLELOG_H
+
+#include <cstdio>
+#include <vector>
+
+// Binary log of addRipple calls, for reproducing a session's ripple load.
+// Each event holds the update it landed before, so replaying the log
+// through the same calls gives the same displacements at any speed.
+// Little endian: "RPLG", version, surface width and height, then one
+// RIPPLE_LOG_EVENT_SIZE byte record per ripple.
+class RippleLog
+{
+public:
+
+    struct Event
+    {
+        unsigned frame;         // updates run before the ripple was added
+        unsigned time;          // ms since recording started
+        float x;                // surface pixels, centered with y up
+        float y;
+        int step;               // ripple speed
+        int texture;            // settings the ripple was added with
+        int distort;
+    };
+
+    RippleLog();
+    virtual ~RippleLog();
+
+    // Recording; events are flushed as they come, so a crash loses none
+    bool create(const char *fileName, float w, float h);
+    void append(const Event& event);
+    void close();
+    bool isOpen() const;
+
+    // Replay; reads the whole log into events()
+    bool load(const char *fileName);
+
+    float width() const;
+    float height() const;
+    const std::vector<Event>& events() const;
+
+private:
+    FILE *file;
+    float w;
+    float h;
+    std::vector<Event> list;
+};
+
+#endif // RIPPLELOG_H
@@ -0,0 +1,223 @@
+#include "RippleQuadTree.h"
+#include <algorithm>
+#include <cmath>
+
+RippleQuadTree::RippleQuadTree() : coarse(0), fine(0), cells(1)
+{
+    setDepth(0, 0);
+}
+
+void RippleQuadTree::setDepth(int coarse, int fine)
+{
+    this->fine = std::max(0, fine);
+    this->coarse = std::min(std::max(0, coarse), this->fine);
+    cells = 1 << this->fine;
+
+    depths.assign(cells*cells, 0);
+    vertexIds.assign((cells+1)*(cells+1), -1);
+}
+
+void RippleQuadTree::build(const std::vector<Annulus>& annuli)
+{
+    leaves.clear();
+    subdivide(Node{ 0, 0, cells, 0 }, annuli);
+
+    // Split coarse leaves until neighbours are at most one level apart
+    while (balance())
+        ;
+
+    triangulate();
+}
+
+int RippleQuadTree::size() const
+{
+    return cells;
+}
+
+int RippleQuadTree::leafCount() const
+{
+    return (int) leaves.size();
+}
+
+const std::vector<RippleQuadTree::Point>& RippleQuadTree::vertices() const
+{
+    return points;
+}
+
+const std::vector<unsigned short>& RippleQuadTree::indices() const
+{
+    return triangles;
+}
+
+void RippleQuadTree::subdivide(const Node& node, const std::vector<Annulus>& annuli)
+{
+    bool split = node.depth < coarse;
+    for (size_t i = 0; i < annuli.size() && !split && node.depth < fine; i++)
+        split = intersects(node, annuli[i]);
+
+    if (!split)
+    {
+        leaves.push_back(node);
+        fill(node);
+        return;
+    }
+
+    int half = node.size/2;
+    subdivide(Node{ node.x, node.y, half, node.depth+1 }, annuli);
+    subdivide(Node{ node.x+half, node.y, half, node.depth+1 }, annuli);
+    subdivide(Node{ node.x, node.y+half, half, node.depth+1 }, annuli);
+    subdivide(Node{ node.x+half, node.y+half, half, node.depth+1 }, annuli);
+}
+
+bool RippleQuadTree::intersects(const Node& node, const Annulus& annulus) const
+{
+    // Nearest and farthest point of the patch from the ripple's center
+    float nx = std::min(std::max(annulus.x, (float) node.x), (float) (node.x + node.size));
+    float ny = std::min(std::max(annulus.y, (float) node.y), (float) (node.y + node.size));
+    float fx = std::max(std::fabs(annulus.x - node.x), std::fabs(annulus.x - (node.x + node.size)));
+    float fy = std::max(std::fabs(annulus.y - node.y), std::fabs(annulus.y - (node.y + node.size)));
+
+    float nearest = std::sqrt((annulus.x-nx)*(annulus.x-nx) + (annulus.y-ny)*(annulus.y-ny));
+    float farthest = std::sqrt(fx*fx + fy*fy);
+    return farthest >= annulus.inner && nearest <= annulus.outer;
+}
+
+bool RippleQuadTree::balance()
+{
+    bool split = false;
+    for (size_t i = 0; i < leaves.size(); )
+    {
+        Node node = leaves[i];
+
+        bool unbalanced = false;
+        for (int k = 0; k < node.size && !unbalanced; k++)
+        {
+            unbalanced = depthAt(node.x-1, node.y+k) > node.depth+1 ||
+                         depthAt(node.x+node.size, node.y+k) > node.depth+1 ||
+                         depthAt(node.x+k, node.y-1) > node.depth+1 ||
+                         depthAt(node.x+k, node.y+node.size) > node.depth+1;
+        }
+
+        if (!unbalanced)
+        {
+            i++;
+            continue;
+        }
+
+        // The children take this slot and are checked in turn
+        int half = node.size/2;
+        Node children[] = {
+            { node.x, node.y, half, node.depth+1 },
+            { node.x+half, node.y, half, node.depth+1 },
+            { node.x, node.y+half, half, node.depth+1 },
+            { node.x+half, node.y+half, half, node.depth+1 }
+        };
+
+        leaves[i] = children[0];
+        for (int c = 1; c < 4; c++)
+            leaves.push_back(children[c]);
+        for (const Node& child : children)
+            fill(child);
+
+        split = true;
+    }
+    return split;
+}
+
+bool RippleQuadTree::hasFinerNeighbour(const Node& node, int side) const
+{
+    // Balanced leaves are split along a whole edge or not at all, so one
+    // cell across the edge tells
+    switch (side)
+    {
+    case 0:  return depthAt(node.x-1, node.y) > node.depth;
+    case 1:  return depthAt(node.x, node.y+node.size) > node.depth;
+    case 2:  return depthAt(node.x+node.size, node.y) > node.depth;
+    default: return depthAt(node.x, node.y-1) > node.depth;
+    }
+}
+
+void RippleQuadTree::fill(const Node& node)
+{
+    for (int y = node.y; y < node.y + node.size; y++)
+        for (int x = node.x; x < node.x + node.size; x++)
+            depths[y*cells+x] = node.depth;
+}
+
+int RippleQuadTree::depthAt(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= cells || y >= cells)
+        return -1;
+
+    return depths[y*cells+x];
+}
+
+void RippleQuadTree::triangulate()
+{
+    points.clear();
+    triangles.clear();
+    std::fill(vertexIds.begin(), vertexIds.end(), -1);
+
+    for (const Node& node : leaves)
+    {
+        int x = node.x;
+        int y = node.y;
+        int s = node.size;
+        int h = s/2;
+
+        bool finer[4];
+        bool stitched = false;
+        for (int side = 0; side < 4; side++)
+            stitched |= finer[side] = hasFinerNeighbour(node, side);
+
+        // Grid rows run top to bottom, triangles wind the same way as the
+        // uniform mesh
+        if (!stitched)
+        {
+            unsigned short tl = vertex(x, y);
+            unsigned short bl = vertex(x, y+s);
+            unsigned short tr = vertex(x+s, y);
+            unsigned short br = vertex(x+s, y+s);
+
+            unsigned short quad[] = { tl, bl, tr, tr, bl, br };
+            triangles.insert(triangles.end(), quad, quad + 6);
+            continue;
+        }
+
+        // Fan around the center, through the midpoint of every edge that
+        // borders a finer leaf
+        unsigned short ring[8];
+        int count = 0;
+        ring[count++] = vertex(x, y);
+        if (finer[0])
+            ring[count++] = vertex(x, y+h);
+        ring[count++] = vertex(x, y+s);
+        if (finer[1])
+            ring[count++] = vertex(x+h, y+s);
+        ring[count++] = vertex(x+s, y+s);
+        if (finer[2])
+            ring[count++] = vertex(x+s, y+h);
+        ring[count++] = vertex(x+s, y);
+        if (finer[3])
+            ring[count++] = vertex(x+h, y);
+
+        unsigned short center = vertex(x+h, y+h);
+        for (int i = 0; i < count; i++)
+        {
+            triangles.push_back(center);
+            triangles.push_back(ring[i]);
+            triangles.push_back(ring[(i+1) % count]);
+        }
+    }
+}
+
+unsigned short RippleQuadTree::vertex(int x, int y)
+{
+    int &id = vertexIds[y*(cells+1)+x];
+    if (id < 0)
+    {
+        id = (int) points.size();
+        points.push_back(Point{ x, y });
+    }
+    return (unsigned short) id;
+}
@@ -0,0 +1,72 @@
+#ifndef RIPPLEQUADTREE_H
+#define RIPPLEQUADTREE_H
+
+#include <vector>
+
+// Square quadtree of mesh patches over the image, in cells of its finest
+// level. Patches touching a ripple's active annulus are split down to the
+// finest level, calm ones stay at the coarse level. Neighbouring leaves
+// differ by at most one level, and a leaf next to a finer one is drawn as a
+// fan through its edge midpoints, so the mesh has no T-junction cracks.
+class RippleQuadTree
+{
+public:
+
+    struct Point
+    {
+        int x;
+        int y;
+    };
+
+    struct Annulus
+    {
+        float x;                // center, in finest cells
+        float y;
+        float inner;            // radii, in finest cells
+        float outer;
+    };
+
+    RippleQuadTree();
+
+    void setDepth(int coarse, int fine);
+    void build(const std::vector<Annulus>& annuli);
+
+    int size() const;
+    int leafCount() const;
+    int depthAt(int x, int y) const;    // of the leaf over finest cell (x, y), -1 outside
+
+    const std::vector<Point>& vertices() const;
+    const std::vector<unsigned short>& indices() const;
+
+private:
+
+    struct Node
+    {
+        int x;
+        int y;
+        int size;
+        int depth;
+    };
+
+    void subdivide(const Node& node, const std::vector<Annulus>& annuli);
+    bool intersects(const Node& node, const Annulus& annulus) const;
+    bool balance();
+    bool hasFinerNeighbour(const Node& node, int side) const;
+    void fill(const Node& node);
+
+    void triangulate();
+    unsigned short vertex(int x, int y);
+
+    int coarse;
+    int fine;
+    int cells;                  // finest cells across
+
+    std::vector<Node> leaves;
+    std::vector<int> depths;    // depth of the leaf covering each finest cell
+    std::vector<int> vertexIds; // per finest grid vertex, -1 when unused
+
+    std::vector<Point> points;
+    std::vector<unsigned short> triangles;
+};
+
+#endif // RIPPLEQUADTREE_H
@@ -0,0 +1,171 @@
+#include "RippleSplat.h"
+#include "RippleTable.h"
+#include <QOpenGLContext>
+
+RippleSplat::RippleSplat(int cols, int rows)
+    : instanceBuf(QOpenGLBuffer::VertexBuffer), ampTexture(nullptr), fbo(nullptr), cols(cols), rows(rows)
+{
+    initializeOpenGLFunctions();
+
+    // Cacheable, so later starts load the linked binary from Qt's shader cache
+    if (!program.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/splat_vshader.glsl") ||
+        !program.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/splat_fshader.glsl") ||
+        !program.link())
+    {
+        qWarning("RippleSplat: failed to build the splat program");
+    }
+
+    // Unit quad, stretched per instance by the vertex shader
+    const GLfloat corners[] = { -1.f, -1.f, 1.f, -1.f, -1.f, 1.f, 1.f, 1.f };
+    quadBuf.create();
+    quadBuf.bind();
+    quadBuf.allocate(corners, sizeof(corners));
+
+    instanceBuf.create();
+    instanceBuf.setUsagePattern(QOpenGLBuffer::StreamDraw);
+
+    // Amplitude table, looked up by distance behind the wavefront
+    ampTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
+    ampTexture->setFormat(QOpenGLTexture::R32F);
+    ampTexture->setSize(RIPPLE_LENGTH, 1);
+    ampTexture->setMinMagFilters(QOpenGLTexture::Nearest, QOpenGLTexture::Nearest);
+    ampTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
+    ampTexture->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::Float32);
+    ampTexture->setData(QOpenGLTexture::Red, QOpenGLTexture::Float32, g_ripple_amp);
+
+    initFramebuffer();
+}
+
+RippleSplat::~RippleSplat()
+{
+    quadBuf.destroy();
+    instanceBuf.destroy();
+    delete ampTexture;
+    delete fbo;
+}
+
+void RippleSplat::initFramebuffer()
+{
+    delete fbo;
+
+    // One texel per grid vertex, the same layout as the field texture
+    QOpenGLFramebufferObjectFormat format;
+    format.setAttachment(QOpenGLFramebufferObject::NoAttachment);
+    format.setInternalTextureFormat(GL_RG16F);
+    fbo = new QOpenGLFramebufferObject(cols+1, rows+1, format);
+
+    glBindTexture(GL_TEXTURE_2D, fbo->texture());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    render(nullptr, 0);
+}
+
+void RippleSplat::resize(int cols, int rows)
+{
+    if (cols == this->cols && rows == this->rows)
+        return;
+
+    this->cols = cols;
+    this->rows = rows;
+    initFramebuffer();
+}
+
+void RippleSplat::render(const Instance *instances, int count, int pinned)
+{
+    GLint viewport[4];
+    GLfloat clearColor[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+
+    fbo->bind();
+    glViewport(0, 0, cols+1, rows+1);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if (count > 0)
+    {
+        // Pinned edges stay at rest, like on the CPU path; texel rows run
+        // in grid order, row 0 first
+        int x0 = pinned & RippleField::eEdgeLeft ? 1 : 0;
+        int y0 = pinned & RippleField::eEdgeTop ? 1 : 0;
+        int x1 = pinned & RippleField::eEdgeRight ? cols : cols+1;
+        int y1 = pinned & RippleField::eEdgeBottom ? rows : rows+1;
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(x0, y0, x1-x0, y1-y0);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+
+        program.bind();
+        ampTexture->bind(2, QOpenGLTexture::ResetTextureUnit);
+        program.setUniformValue("amplitude", 2);
+        program.setUniformValue("field_size", QVector2D(cols, rows));
+        program.setUniformValue("cell_scale", QVector2D((float) GRID_SIZE_X/cols, (float) GRID_SIZE_Y/rows));
+        program.setUniformValue("cell_length", (GLfloat) RIPPLE_CELL_LENGTH);
+        program.setUniformValue("ripple_length", (GLfloat) RIPPLE_LENGTH);
+
+        quadBuf.bind();
+        int cornerLocation = program.attributeLocation("a_corner");
+        program.enableAttributeArray(cornerLocation);
+        program.setAttributeBuffer(cornerLocation, GL_FLOAT, 0, 2);
+
+        // The whole ripple state goes up as one small buffer per frame
+        instanceBuf.bind();
+        instanceBuf.allocate(instances, count * sizeof(Instance));
+        int rippleLocation = program.attributeLocation("a_ripple");
+        program.enableAttributeArray(rippleLocation);
+        program.setAttributeBuffer(rippleLocation, GL_FLOAT, 0, 4, sizeof(Instance));
+        glVertexAttribDivisor(rippleLocation, 1);
+
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+
+        // Divisors are global state, leave them as the main pass expects
+        glVertexAttribDivisor(rippleLocation, 0);
+        program.disableAttributeArray(rippleLocation);
+        program.disableAttributeArray(cornerLocation);
+        instanceBuf.release();
+        program.release();
+
+        glDisable(GL_BLEND);
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    fbo->release();
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+    if (depthTest)
+        glEnable(GL_DEPTH_TEST);
+    if (cullFace)
+        glEnable(GL_CULL_FACE);
+}
+
+GLuint RippleSplat::texture() const
+{
+    return fbo->texture();
+}
+
+bool RippleSplat::isValid() const
+{
+    return program.isLinked() && fbo->isValid();
+}
+
+bool RippleSplat::isSupported()
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context)
+        return false;
+
+    // Instanced arrays and a blendable half float color buffer
+    if (context->isOpenGLES())
+        return context->format().majorVersion() >= 3 &&
+               (context->hasExtension("GL_EXT_color_buffer_half_float") || context->hasExtension("GL_EXT_color_buffer_float"));
+
+    return context->format().version() >= qMakePair(3, 3);
+}
@@ -0,0 +1,45 @@
+#ifndef RIPPLESPLAT_H
+#define RIPPLESPLAT_H
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLBuffer>
+#include <QOpenGLTexture>
+#include <QOpenGLFramebufferObject>
+#include "RippleField.h"
+
+// Renders every live ripple as an instanced quad covering its wavefront,
+// summing the displacements into a floating point framebuffer that the
+// main pass samples like the field texture.
+class RippleSplat : protected QOpenGLExtraFunctions
+{
+public:
+
+    typedef RippleField::Instance Instance;
+
+    RippleSplat(int cols, int rows);
+    virtual ~RippleSplat();
+
+    void resize(int cols, int rows);
+    void render(const Instance *instances, int count, int pinned = RippleField::eEdgesAll);    // pinned: RippleField::Edge flags
+
+    GLuint texture() const;
+    bool isValid() const;
+
+    static bool isSupported();
+
+private:
+
+    void initFramebuffer();
+
+    QOpenGLShaderProgram program;
+    QOpenGLBuffer quadBuf;
+    QOpenGLBuffer instanceBuf;
+    QOpenGLTexture *ampTexture;
+    QOpenGLFramebufferObject *fbo;
+
+    int cols;
+    int rows;
+};
+
+#endif // RIPPLESPLAT_H
@@ -0,0 +1,216 @@
+#include "RippleSurface.h"
+
+RippleSurface::RippleSurface(QOpenGLShaderProgram *program, float w, float h)
+    : layout(w, h), viewport(-w/2, -h/2, w, h), culling(true), visible(0)
+{
+    int cols = layout.cols();
+    int rows = layout.rows();
+    for (int i = 0; i < layout.count(); i++)
+    {
+        // Placed before the first upload, which then needs no redo
+        RippleLayout::Chunk place = layout.chunk(i);
+        RippleEffect *chunk = new RippleEffect(program, place.width, place.height, place.x, place.y);
+        chunk->setTextureRect((float) place.col / cols, (float) (rows - place.row - 1) / rows, 1.f / cols, 1.f / rows);
+        chunk->setPinnedEdges(place.pinned);
+        chunks.push_back(chunk);
+    }
+}
+
+RippleSurface::~RippleSurface()
+{
+    for (RippleEffect *chunk : chunks)
+        delete chunk;
+}
+
+void RippleSurface::draw()
+{
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        if (isVisible((int) i))
+            chunks[i]->draw();
+    }
+}
+
+void RippleSurface::update()
+{
+    visible = 0;
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        bool shown = isVisible((int) i);
+        chunks[i]->setCulled(!shown);
+        chunks[i]->update();
+        if (shown)
+            visible++;
+    }
+}
+
+void RippleSurface::addRipple(float x, float y, int step)
+{
+    // Every chunk the wave can reach gets its own copy
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        if (layout.reaches((int) i, x, y))
+            chunks[i]->addRipple(x, y, step);
+    }
+}
+
+void RippleSurface::moveRipples(RippleSurface& target)
+{
+    // Surfaces of one size share the chunk layout
+    for (size_t i = 0; i < chunks.size() && i < target.chunks.size(); i++)
+        chunks[i]->moveRipples(*target.chunks[i]);
+}
+
+void RippleSurface::setViewport(const QRectF& rect)
+{
+    viewport = rect;
+}
+
+void RippleSurface::setCulling(bool enabled)
+{
+    culling = enabled;
+}
+
+void RippleSurface::setDistortMode(RippleEffect::DistortMode mode)
+{
+    for (RippleEffect *chunk : chunks)
+        chunk->setDistortMode(mode);
+}
+
+void RippleSurface::setVertexFormat(RippleEffect::VertexFormat format)
+{
+    for (RippleEffect *chunk : chunks)
+        chunk->setVertexFormat(format);
+}
+
+bool RippleSurface::setBackend(RippleEffect::Backend backend)
+{
+    bool result = true;
+    for (RippleEffect *chunk : chunks)
+        result &= chunk->setBackend(backend);
+    return result;
+}
+
+bool RippleSurface::setMeshMode(RippleEffect::MeshMode mode)
+{
+    bool result = true;
+    for (RippleEffect *chunk : chunks)
+        result &= chunk->setMeshMode(mode);
+    return result;
+}
+
+void RippleSurface::setMeshSize(int cols, int rows)
+{
+    for (RippleEffect *chunk : chunks)
+        chunk->setMeshSize(cols, rows);
+}
+
+void RippleSurface::setFieldSize(int cols, int rows)
+{
+    for (RippleEffect *chunk : chunks)
+        chunk->setFieldSize(cols, rows);
+}
+
+void RippleSurface::setKeyframeInterval(int frames)
+{
+    for (RippleEffect *chunk : chunks)
+        chunk->setKeyframeInterval(frames);
+}
+
+void RippleSurface::setMaxRipples(int count)
+{
+    for (RippleEffect *chunk : chunks)
+        chunk->setMaxRipples(count);
+}
+
+void RippleSurface::setPoolSize(int count)
+{
+    for (RippleEffect *chunk : chunks)
+        chunk->setPoolSize(count);
+}
+
+bool RippleSurface::hasKeyframes() const
+{
+    // Chunks share their settings
+    return chunks.front()->hasKeyframes();
+}
+
+int RippleSurface::chunkCount() const
+{
+    return (int) chunks.size();
+}
+
+int RippleSurface::visibleCount() const
+{
+    return visible;
+}
+
+int RippleSurface::rippleCount() const
+{
+    int count = 0;
+    for (RippleEffect *chunk : chunks)
+        count += chunk->rippleCount();
+    return count;
+}
+
+qint64 RippleSurface::evaluationCount() const
+{
+    qint64 count = 0;
+    for (RippleEffect *chunk : chunks)
+        count += chunk->evaluationCount();
+    return count;
+}
+
+qint64 RippleSurface::uploadBytes() const
+{
+    qint64 bytes = 0;
+    for (RippleEffect *chunk : chunks)
+        bytes += chunk->uploadBytes();
+    return bytes;
+}
+
+qint64 RippleSurface::uploadTime() const
+{
+    qint64 ns = 0;
+    for (RippleEffect *chunk : chunks)
+        ns += chunk->uploadTime();
+    return ns;
+}
+
+int RippleSurface::vertexCount() const
+{
+    int count = 0;
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        if (isVisible((int) i))
+            count += chunks[i]->vertexCount();
+    }
+    return count;
+}
+
+int RippleSurface::retiredCount() const
+{
+    int count = 0;
+    for (RippleEffect *chunk : chunks)
+        count += chunk->retiredCount();
+    return count;
+}
+
+long RippleSurface::droppedCount() const
+{
+    long count = 0;
+    for (RippleEffect *chunk : chunks)
+        count += chunk->droppedCount();
+    return count;
+}
+
+QRectF RippleSurface::chunkRect(int index) const
+{
+    RippleLayout::Chunk chunk = layout.chunk(index);
+    return QRectF(chunk.left, chunk.bottom, chunk.width, chunk.height);
+}
+
+bool RippleSurface::isVisible(int index) const
+{
+    return !culling || viewport.intersects(chunkRect(index));
+}
@@ -0,0 +1,66 @@
+#ifndef RIPPLESURFACE_H
+#define RIPPLESURFACE_H
+
+#include <QRectF>
+#include <vector>
+#include "RippleEffect.h"
+#include "RippleLayout.h"
+
+// A ripple surface of any size, split into equal chunks of at most
+// SURFACE_CHUNK_SIZE pixels as RippleLayout lays them out. Each chunk is a RippleEffect with its own mesh,
+// so the GLushort index limit applies per chunk only. Neighbouring chunks
+// displace the edge they share alike; only the surface border stays at
+// rest. Chunks outside the viewport keep their ripples moving but skip the
+// simulation and draw call.
+class RippleSurface
+{
+public:
+    RippleSurface(QOpenGLShaderProgram *program, float w, float h);
+    virtual ~RippleSurface();
+
+    void draw();
+    void update();
+
+    void addRipple(float x, float y, int step = 7);
+    void moveRipples(RippleSurface& target);
+
+    // Visible part of the surface, centered on (0, 0) with y up like the meshes
+    void setViewport(const QRectF& rect);
+    void setCulling(bool enabled);
+
+    void setDistortMode(RippleEffect::DistortMode mode);
+    void setVertexFormat(RippleEffect::VertexFormat format);
+    bool setBackend(RippleEffect::Backend backend);
+    bool setMeshMode(RippleEffect::MeshMode mode);
+
+    void setMeshSize(int cols, int rows);
+    void setFieldSize(int cols, int rows);
+    void setKeyframeInterval(int frames);
+    void setMaxRipples(int count);
+    void setPoolSize(int count);
+
+    bool hasKeyframes() const;
+
+    int chunkCount() const;
+    int visibleCount() const;
+    int rippleCount() const;            // summed over chunks, a ripple near a border counts in each
+    qint64 evaluationCount() const;     // ripple-vertex evaluations of the last update
+    qint64 uploadBytes() const;         // written by the last update
+    qint64 uploadTime() const;          // ns
+    int vertexCount() const;            // of the chunks drawn
+    int retiredCount() const;           // by the last update, counted per chunk like rippleCount
+    long droppedCount() const;          // by full chunk pools, in all
+
+private:
+    QRectF chunkRect(int index) const;
+    bool isVisible(int index) const;
+
+    RippleLayout layout;
+    std::vector<RippleEffect*> chunks;
+
+    QRectF viewport;
+    bool culling;
+    int visible;                // chunks simulated by the last update
+};
+
+#endif // RIPPLESURFACE_H
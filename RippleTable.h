@@ -3,12 +3,34 @@
 
 #pragma GCC diagnostic ignored "-Wmissing-braces"
 
+#include <cmath>
+
 #define GRID_SIZE_X             32
 #define GRID_SIZE_Y             32
 
 #define RIPPLE_LENGTH           2048
+#define RIPPLE_CELL_LENGTH      (800.0/31)  // wave distance across one cell of a 32x32 grid
+
+#define SURFACE_CHUNK_SIZE      512         // largest chunk of a ripple surface, in pixels
+
+#define MESH_SIZE_MAX           255         // (255+1)^2 vertices still fit GLushort indices
+#define FIELD_SIZE_MAX          1024        // simulation grid of the texture backend
+#define KEYFRAME_INTERVAL_MAX   8           // display frames per simulated frame
+#define RIPPLE_POOL_SIZE        1024        // live ripples per effect, the oldest make way
+#define RIPPLE_POOL_SIZE_SPLAT  16384       // splat cost follows covered texels, not the ripple count
+
+#define INDEX_BAND_WIDTH        6           // quads per band of the triangle list layout, two rows fit a 16 entry cache
+#define INDEX_STRIP_MAX_QUADS   4096        // larger grids default to the triangle list layout
 
-typedef struct RIPPLE_VECTOR    RIPPLE_VECTOR;		// precomputed displacement vector table
+#define RIPPLE_AMP_MAX          0.1f        // largest |amplitude| in g_ripple_amp
+#define RIPPLE_OFFSET_RANGE     (RIPPLE_POOL_SIZE * RIPPLE_AMP_MAX)     // a full pool's peaks summed, in texture units
+
+#define QUADTREE_DEPTH_COARSE   2           // 4x4 patches over calm water
+#define QUADTREE_DEPTH_MAX      7           // 128x128 finest cells, well inside GLushort indices
+#define QUADTREE_AMP_THRESHOLD  0.005f      // table amplitude that counts as an active wave
+#define QUADTREE_RIPPLE_MIN     0.05f       // fading ripples below this no longer refine or displace
+
+typedef struct RIPPLE_VECTOR    RIPPLE_VECTOR;		// displacement vector table, built per grid size
 typedef struct RIPPLE_AMP       RIPPLE_AMP;		// precomputed ripple amplitude table
 
 struct RIPPLE_VECTOR
@@ -23,1033 +45,46 @@ struct RIPPLE_AMP
     float amplitude;
 };
 
-RIPPLE_VECTOR g_ripple_vector[GRID_SIZE_X][GRID_SIZE_Y] =
+// Unit direction and wave distance of the grid offset (mx, my) on a grid of
+// cols x rows cells. Finer grids cover the same distance with shorter cells.
+inline RIPPLE_VECTOR makeRippleVector(int mx, int my, int cols, int rows)
 {
-    0, 0, 0,
-    0, 1, 25,
-    0, 1, 51,
-    0, 1, 77,
-    0, 1, 103,
-    0, 1, 129,
-    0, 1, 154,
-    0, 1, 180,
-    0, 1, 206,
-    0, 1, 232,
-    0, 1, 258,
-    0, 1, 283,
-    0, 1, 309,
-    0, 1, 335,
-    0, 1, 361,
-    0, 1, 387,
-    0, 1, 412,
-    0, 1, 438,
-    0, 1, 464,
-    0, 1, 490,
-    0, 1, 516,
-    0, 1, 541,
-    0, 1, 567,
-    0, 1, 593,
-    0, 1, 619,
-    0, 1, 645,
-    0, 1, 670,
-    0, 1, 696,
-    0, 1, 722,
-    0, 1, 748,
-    0, 1, 774,
-    0, 1, 800,
-    1, 0, 25,
-    0.707107, 0.707107, 36,
-    0.447214, 0.894427, 57,
-    0.316228, 0.948683, 81,
-    0.242536, 0.970143, 106,
-    0.196116, 0.980581, 131,
-    0.164399, 0.986394, 156,
-    0.141421, 0.989949, 182,
-    0.124035, 0.992278, 208,
-    0.110432, 0.993884, 233,
-    0.0995037, 0.995037, 259,
-    0.0905357, 0.995893, 285,
-    0.0830455, 0.996546, 310,
-    0.0766965, 0.997055, 336,
-    0.071247, 0.997459, 362,
-    0.066519, 0.997785, 387,
-    0.0623783, 0.998053, 413,
-    0.058722, 0.998274, 439,
-    0.05547, 0.99846, 465,
-    0.0525588, 0.998618, 491,
-    0.0499376, 0.998752, 516,
-    0.0475651, 0.998868, 542,
-    0.0454077, 0.998969, 568,
-    0.0434372, 0.999056, 594,
-    0.0416305, 0.999133, 619,
-    0.039968, 0.999201, 645,
-    0.0384331, 0.999261, 671,
-    0.0370117, 0.999315, 697,
-    0.0356915, 0.999363, 723,
-    0.0344623, 0.999406, 748,
-    0.0333148, 0.999445, 774,
-    0.0322413, 0.99948, 800,
-    1, 0, 51,
-    0.894427, 0.447214, 57,
-    0.707107, 0.707107, 72,
-    0.5547, 0.83205, 93,
-    0.447214, 0.894427, 115,
-    0.371391, 0.928477, 138,
-    0.316228, 0.948683, 163,
-    0.274721, 0.961524, 187,
-    0.242536, 0.970143, 212,
-    0.21693 , 0.976187, 237,
-    0.196116, 0.980581, 263,
-    0.178885, 0.98387, 288,
-    0.164399, 0.986394, 313,
-    0.152057, 0.988372, 339,
-    0.141421, 0.989949, 364,
-    0.132164, 0.991228, 390,
-    0.124035, 0.992278, 416,
-    0.116841, 0.993151, 441,
-    0.110432, 0.993884, 467,
-    0.104685, 0.994505, 493,
-    0.0995037, 0.995037, 518,
-    0.0948091, 0.995495, 544,
-    0.0905357, 0.995893, 570,
-    0.0866296, 0.996241, 595,
-    0.0830455, 0.996546, 621,
-    0.0797452, 0.996815, 647,
-    0.0766965, 0.997055, 672,
-    0.0738717, 0.997268, 698,
-    0.071247, 0.997459, 724,
-    0.0688021, 0.99763, 750,
-    0.066519, 0.997785, 775,
-    0.0643823, 0.997925, 801,
-    1, 0, 77,
-    0.948683, 0.316228, 81,
-    0.83205, 0.5547, 93,
-    0.707107, 0.707107, 109,
-    0.6, 0.8, 129,
-    0.514496, 0.857493, 150,
-    0.447214, 0.894427, 173,
-    0.393919, 0.919145, 196,
-    0.351123, 0.936329, 220,
-    0.316228, 0.948683, 244,
-    0.287348, 0.957826, 269,
-    0.263117, 0.964764, 294,
-    0.242536, 0.970142, 319,
-    0.22486, 0.974391, 344,
-    0.209529, 0.977802, 369,
-    0.196116, 0.980581, 394,
-    0.184289, 0.982872, 420,
-    0.173785, 0.984784, 445,
-    0.164399, 0.986394, 470,
-    0.155963, 0.987763, 496,
-    0.14834, 0.988936, 521,
-    0.141421, 0.989949, 547,
-    0.135113, 0.99083, 572,
-    0.129339, 0.9916, 598,
-    0.124035, 0.992278, 624,
-    0.119145, 0.992877, 649,
-    0.114624, 0.993409, 675,
-    0.110432, 0.993884, 701,
-    0.106533, 0.994309, 726,
-    0.102899, 0.994692, 752,
-    0.0995037, 0.995037, 778,
-    0.0963242, 0.99535, 803,
-    1, 0, 103,
-    0.970143, 0.242536, 106,
-    0.894427, 0.447214, 115,
-    0.8, 0.6, 129,
-    0.707107, 0.707107, 145,
-    0.624695, 0.780869, 165,
-    0.5547, 0.83205, 186,
-    0.496139, 0.868243, 208,
-    0.447214, 0.894427, 230,
-    0.406138, 0.913812, 254,
-    0.371391, 0.928477, 277,
-    0.341743, 0.939793, 302,
-    0.316228, 0.948683, 326,
-    0.294086, 0.955779, 351,
-    0.274721, 0.961524, 375,
-    0.257663, 0.966235, 400,
-    0.242536, 0.970143, 425,
-    0.229039, 0.973417, 450,
-    0.21693, 0.976187, 475,
-    0.20601, 0.97855, 501,
-    0.196116, 0.980581, 526,
-    0.187112, 0.982339, 551,
-    0.178885, 0.98387, 577,
-    0.171341, 0.985212, 602,
-    0.164399, 0.986394, 627,
-    0.15799, 0.987441, 653,
-    0.152057, 0.988372, 678,
-    0.146549, 0.989204, 704,
-    0.141421, 0.989949, 729,
-    0.136637, 0.990621, 755,
-    0.132164, 0.991228, 781,
-    0.127971, 0.991778, 806,
-    1, 0, 129,
-    0.980581, 0.196116, 131,
-    0.928477, 0.371391, 138,
-    0.857493, 0.514496, 150,
-    0.780869, 0.624695, 165,
-    0.707107, 0.707107, 182,
-    0.640184, 0.768221, 201,
-    0.581238, 0.813733, 221,
-    0.529999, 0.847998, 243,
-    0.485643, 0.874157, 265,
-    0.447214, 0.894427, 288,
-    0.413803, 0.910366, 311,
-    0.384615, 0.923077, 335,
-    0.358979, 0.933346, 359,
-    0.336336, 0.941742, 383,
-    0.316228, 0.948683, 408,
-    0.298275, 0.95448, 432,
-    0.282166, 0.959365, 457,
-    0.267644, 0.963518, 482,
-    0.254493, 0.967075, 507,
-    0.242536, 0.970142, 532,
-    0.231621, 0.972806, 557,
-    0.221621, 0.975133, 582,
-    0.21243, 0.977176, 607,
-    0.203954, 0.97898, 632,
-    0.196116, 0.980581, 657,
-    0.188847, 0.982006, 683,
-    0.182089, 0.983282, 708,
-    0.175791, 0.984428, 734,
-    0.169907, 0.98546, 759,
-    0.164399, 0.986394, 784,
-    0.159232, 0.987241, 810,
-    1, 0, 154,
-    0.986394, 0.164399, 156,
-    0.948683, 0.316228, 163,
-    0.894427, 0.447214, 173,
-    0.83205, 0.5547, 186,
-    0.768221, 0.640184, 201,
-    0.707107, 0.707107, 218,
-    0.650791, 0.759257, 237,
-    0.6, 0.8, 258,
-    0.5547, 0.83205, 279,
-    0.514496, 0.857493, 300,
-    0.478852, 0.877896, 323,
-    0.447214, 0.894427, 346,
-    0.419058, 0.907959, 369,
-    0.393919, 0.919145, 393,
-    0.371391, 0.928477, 416,
-    0.351123, 0.936329, 440,
-    0.33282, 0.94299, 465,
-    0.316228, 0.948683, 489,
-    0.301131, 0.953583, 514,
-    0.287348, 0.957826, 538,
-    0.274721, 0.961524, 563,
-    0.263117, 0.964764, 588,
-    0.252422, 0.967617, 613,
-    0.242536, 0.970142, 638,
-    0.233373, 0.972387, 663,
-    0.22486, 0.974391, 688,
-    0.21693, 0.976187, 713,
-    0.209529, 0.977802, 738,
-    0.202606, 0.97926, 764,
-    0.196116, 0.980581, 789,
-    0.190022, 0.98178, 814,
-    1, 0, 180,
-    0.989949, 0.141421, 182,
-    0.961524, 0.274721, 187,
-    0.919145, 0.393919, 196,
-    0.868243, 0.496139, 208,
-    0.813733, 0.581238, 221,
-    0.759257, 0.650791, 237,
-    0.707107, 0.707107, 255,
-    0.658505, 0.752577, 274,
-    0.613941, 0.789352, 294,
-    0.573462, 0.819232, 315,
-    0.536875, 0.843661, 336,
-    0.503871, 0.863779, 358,
-    0.4741, 0.880471, 381,
-    0.447214, 0.894427, 403,
-    0.422885, 0.906183, 427,
-    0.400819, 0.916157, 450,
-    0.38075, 0.924678, 474,
-    0.362446, 0.932005, 498,
-    0.345705, 0.938343, 522,
-    0.33035, 0.943858, 546,
-    0.316228, 0.948683, 571,
-    0.303204, 0.952926, 595,
-    0.291162, 0.956674, 620,
-    0.28, 0.96, 645,
-    0.26963, 0.962964, 669,
-    0.259973, 0.965616, 694,
-    0.250962, 0.967997, 719,
-    0.242536, 0.970142, 744,
-    0.234641, 0.972082, 769,
-    0.22723, 0.973841, 794,
-    0.220261, 0.975441, 820,
-    1, 0, 206,
-    0.992278, 0.124035, 208,
-    0.970143, 0.242536, 212,
-    0.936329, 0.351123, 220,
-    0.894427, 0.447214, 230,
-    0.847998, 0.529999, 243,
-    0.8, 0.6, 258,
-    0.752577, 0.658505, 274,
-    0.707107, 0.707107, 291,
-    0.664364, 0.747409, 310,
-    0.624695, 0.780869, 330,
-    0.588172, 0.808736, 351,
-    0.5547, 0.83205, 372,
-    0.524097, 0.851658, 393,
-    0.496139, 0.868243, 416,
-    0.470588, 0.882353, 438,
-    0.447214, 0.894427, 461,
-    0.425797, 0.904819, 484,
-    0.406138, 0.913812, 508,
-    0.388057, 0.921635, 532,
-    0.371391, 0.928477, 555,
-    0.355995, 0.934488, 579,
-    0.341743, 0.939793, 604,
-    0.328521, 0.944497, 628,
-    0.316228, 0.948683, 652,
-    0.304776, 0.952424, 677,
-    0.294086, 0.955779, 702,
-    0.284088, 0.958798, 726,
-    0.274721, 0.961524, 751,
-    0.265929, 0.963993, 776,
-    0.257663, 0.966235, 801,
-    0.249878, 0.968277, 826,
-    1, 0, 232,
-    0.993884, 0.110432, 233,
-    0.976187, 0.21693, 237,
-    0.948683, 0.316228, 244,
-    0.913812, 0.406138, 254,
-    0.874157, 0.485643, 265,
-    0.83205, 0.5547, 279,
-    0.789352, 0.613941, 294,
-    0.747409, 0.664364, 310,
-    0.707107, 0.707107, 328,
-    0.668965, 0.743294, 347,
-    0.633238, 0.773957, 366,
-    0.6, 0.8, 387,
-    0.56921, 0.822192, 408,
-    0.540758, 0.841179, 429,
-    0.514496, 0.857493, 451,
-    0.490261, 0.871575, 473,
-    0.467888, 0.883788, 496,
-    0.447214, 0.894427, 519,
-    0.428086, 0.903738, 542,
-    0.410365, 0.911922, 565,
-    0.393919, 0.919145, 589,
-    0.378633, 0.925547, 613,
-    0.364399, 0.931243, 637,
-    0.351123, 0.936329, 661,
-    0.338719, 0.940887, 685,
-    0.327111, 0.944986, 710,
-    0.316228, 0.948683, 734,
-    0.306009, 0.952029, 758,
-    0.296399, 0.955064, 783,
-    0.287348, 0.957826, 808,
-    0.27881, 0.960346, 833,
-    1, 0, 258,
-    0.995037, 0.0995037, 259,
-    0.980581, 0.196116, 263,
-    0.957826, 0.287348, 269,
-    0.928477, 0.371391, 277,
-    0.894427, 0.447214, 288,
-    0.857493, 0.514496, 300,
-    0.819232, 0.573462, 315,
-    0.780869, 0.624695, 330,
-    0.743294, 0.668965, 347,
-    0.707107, 0.707107, 364,
-    0.672673, 0.73994, 383,
-    0.640184, 0.768221, 403,
-    0.609711, 0.792624, 423,
-    0.581238, 0.813733, 443,
-    0.5547, 0.83205, 465,
-    0.529999, 0.847998, 486,
-    0.50702, 0.861934, 508,
-    0.485643, 0.874157, 531,
-    0.465746, 0.884918, 554,
-    0.447214, 0.894427, 577,
-    0.429934, 0.902861, 600,
-    0.413803, 0.910366, 623,
-    0.398726, 0.91707, 647,
-    0.384615, 0.923077, 670,
-    0.371391, 0.928477, 694,
-    0.358979, 0.933346, 718,
-    0.347314, 0.937749, 743,
-    0.336336, 0.941742, 767,
-    0.325991, 0.945373, 791,
-    0.316228, 0.948683, 816,
-    0.307003, 0.951709, 840,
-    1, 0, 283,
-    0.995893, 0.0905357, 285,
-    0.98387, 0.178885, 288,
-    0.964764, 0.263117, 294,
-    0.939793, 0.341743, 302,
-    0.910366, 0.413803, 311,
-    0.877896, 0.478852, 323,
-    0.843661, 0.536875, 336,
-    0.808736, 0.588172, 351,
-    0.773957, 0.633238, 366,
-    0.73994, 0.672673, 383,
-    0.707107, 0.707107, 401,
-    0.675725, 0.737154, 420,
-    0.645942, 0.763386, 439,
-    0.617822, 0.786318, 459,
-    0.591364, 0.806405, 480,
-    0.566529, 0.824042, 501,
-    0.543251, 0.83957, 522,
-    0.52145, 0.853282, 544,
-    0.501036, 0.865426, 566,
-    0.481919, 0.876216, 589,
-    0.464007, 0.885832, 611,
-    0.447214, 0.894427, 634,
-    0.431455, 0.902134, 657,
-    0.416655, 0.909065, 681,
-    0.402739, 0.915315, 704,
-    0.38964, 0.920967, 728,
-    0.377297, 0.926092, 752,
-    0.365652, 0.930751, 776,
-    0.354654, 0.934998, 800,
-    0.344255, 0.938876, 824,
-    0.33441, 0.942428, 848,
-    1, 0, 309,
-    0.996546, 0.0830455, 310,
-    0.986394, 0.164399, 313,
-    0.970142, 0.242536, 319,
-    0.948683, 0.316228, 326,
-    0.923077, 0.384615, 335,
-    0.894427, 0.447214, 346,
-    0.863779, 0.503871, 358,
-    0.83205, 0.5547, 372,
-    0.8, 0.6, 387,
-    0.768221, 0.640184, 403,
-    0.737154, 0.675725, 420,
-    0.707107, 0.707107, 437,
-    0.67828, 0.734803, 456,
-    0.650791, 0.759257, 475,
-    0.624695, 0.780869, 495,
-    0.6, 0.8, 516,
-    0.576683, 0.816968, 536,
-    0.5547, 0.83205, 558,
-    0.533993, 0.845489, 579,
-    0.514496, 0.857493, 601,
-    0.496139, 0.868243, 624,
-    0.478852, 0.877896, 646,
-    0.462566, 0.886585, 669,
-    0.447214, 0.894427, 692,
-    0.432731, 0.901523, 715,
-    0.419058, 0.907959, 738,
-    0.406138, 0.913812, 762,
-    0.393919, 0.919145, 786,
-    0.382352, 0.924017, 809,
-    0.371391, 0.928477, 833,
-    0.360994, 0.932568, 857,
-    1, 0, 335,
-    0.997055, 0.0766965, 336,
-    0.988372, 0.152057, 339,
-    0.974391, 0.22486, 344,
-    0.955779, 0.294086, 351,
-    0.933346, 0.358979, 359,
-    0.907959, 0.419058, 369,
-    0.880471, 0.4741, 381,
-    0.851658, 0.524097, 393,
-    0.822192, 0.56921, 408,
-    0.792624, 0.609711, 423,
-    0.763386, 0.645942, 439,
-    0.734803, 0.67828, 456,
-    0.707107, 0.707107, 474,
-    0.680451, 0.732794, 493,
-    0.654931, 0.755689, 512,
-    0.630593, 0.776114, 532,
-    0.60745, 0.794358, 552,
-    0.585491, 0.810679, 572,
-    0.564684, 0.825307, 594,
-    0.544988, 0.838444, 615,
-    0.526355, 0.850265, 637,
-    0.508729, 0.860927, 659,
-    0.492057, 0.870563, 681,
-    0.476283, 0.879292, 704,
-    0.461353, 0.887217, 727,
-    0.447214, 0.894427, 750,
-    0.433816, 0.901002, 773,
-    0.421111, 0.907009, 796,
-    0.409056, 0.912509, 820,
-    0.397607, 0.917556, 843,
-    0.386727, 0.922194, 867,
-    1, 0, 361,
-    0.997459, 0.071247, 362,
-    0.989949, 0.141421, 364,
-    0.977802, 0.209529, 369,
-    0.961524, 0.274721, 375,
-    0.941742, 0.336336, 383,
-    0.919145, 0.393919, 393,
-    0.894427, 0.447214, 403,
-    0.868243, 0.496139, 416,
-    0.841179, 0.540758, 429,
-    0.813733, 0.581238, 443,
-    0.786318, 0.617822, 459,
-    0.759257, 0.650791, 475,
-    0.732794, 0.680451, 493,
-    0.707107, 0.707107, 510,
-    0.682318, 0.731055, 529,
-    0.658505, 0.752577, 548,
-    0.635707, 0.77193, 568,
-    0.613941, 0.789352, 588,
-    0.593199, 0.805056, 609,
-    0.573462, 0.819232, 630,
-    0.5547, 0.83205, 651,
-    0.536875, 0.843661, 672,
-    0.519947, 0.854199, 694,
-    0.503871, 0.863779, 717,
-    0.488603, 0.872506, 739,
-    0.4741, 0.880471, 762,
-    0.460317, 0.887755, 784,
-    0.447214, 0.894427, 807,
-    0.434749, 0.900552, 831,
-    0.422885, 0.906183, 854,
-    0.411587, 0.911371, 877,
-    1, 0, 387,
-    0.997785, 0.066519, 387,
-    0.991228, 0.132164, 390,
-    0.980581, 0.196116, 394,
-    0.966235, 0.257663, 400,
-    0.948683, 0.316228, 408,
-    0.928477, 0.371391, 416,
-    0.906183, 0.422885, 427,
-    0.882353, 0.470588, 438,
-    0.857493, 0.514496, 451,
-    0.83205, 0.5547, 465,
-    0.806405, 0.591364, 480,
-    0.780869, 0.624695, 495,
-    0.755689, 0.654931, 512,
-    0.731055, 0.682318, 529,
-    0.707107, 0.707107, 547,
-    0.683941, 0.729537, 565,
-    0.661622, 0.749838, 585,
-    0.640184, 0.768221, 604,
-    0.619644, 0.784883, 624,
-    0.6, 0.8, 645,
-    0.581238, 0.813733, 665,
-    0.563337, 0.826227, 687,
-    0.546268, 0.837611, 708,
-    0.529999, 0.847998, 730,
-    0.514496, 0.857493, 752,
-    0.499722, 0.866186, 774,
-    0.485643, 0.874157, 797,
-    0.472221, 0.88148, 819,
-    0.459423, 0.888218, 842,
-    0.447214, 0.894427, 865,
-    0.435561, 0.900159, 888,
-    1, 0, 412,
-    0.998053, 0.0623783, 413,
-    0.992278, 0.124035, 416,
-    0.982872, 0.184289, 420,
-    0.970143, 0.242536, 425,
-    0.95448, 0.298275, 432,
-    0.936329, 0.351123, 440,
-    0.916157, 0.400819, 450,
-    0.894427, 0.447214, 461,
-    0.871575, 0.490261, 473,
-    0.847998, 0.529999, 486,
-    0.824042, 0.566529, 501,
-    0.8, 0.6, 516,
-    0.776114, 0.630593, 532,
-    0.752577, 0.658505, 548,
-    0.729537, 0.683941, 565,
-    0.707107, 0.707107, 583,
-    0.685365, 0.7282, 602,
-    0.664364, 0.747409, 621,
-    0.644136, 0.764911, 641,
-    0.624695, 0.780869, 660,
-    0.606043, 0.795432, 681,
-    0.588172, 0.808736, 702,
-    0.571064, 0.820905, 723,
-    0.5547, 0.83205, 744,
-    0.539054, 0.842271, 765,
-    0.524097, 0.851658, 787,
-    0.509802, 0.860291, 809,
-    0.496139, 0.868243, 832,
-    0.483077, 0.875578, 854,
-    0.470588, 0.882353, 877,
-    0.458643, 0.888621, 900,
-    1, 0, 438,
-    0.998274, 0.058722, 439,
-    0.993151, 0.116841, 441,
-    0.984784, 0.173785, 445,
-    0.973417, 0.229039, 450,
-    0.959365, 0.282166, 457,
-    0.94299, 0.33282, 465,
-    0.924678, 0.38075, 474,
-    0.904819, 0.425797, 484,
-    0.883788, 0.467888, 496,
-    0.861934, 0.50702, 508,
-    0.83957, 0.543251, 522,
-    0.816968, 0.576683, 536,
-    0.794358, 0.60745, 552,
-    0.77193, 0.635707, 568,
-    0.749838, 0.661622, 585,
-    0.7282, 0.685365, 602,
-    0.707107, 0.707107, 620,
-    0.686624, 0.727013, 638,
-    0.666795, 0.745241, 657,
-    0.647648, 0.761939, 677,
-    0.629198, 0.777245, 697,
-    0.611448, 0.791285, 717,
-    0.594391, 0.804176, 738,
-    0.578017, 0.816024, 758,
-    0.56231, 0.826927, 780,
-    0.547249, 0.83697, 801,
-    0.532813, 0.846233, 823,
-    0.518978, 0.854788, 845,
-    0.505719, 0.862698, 867,
-    0.493013, 0.870022, 889,
-    0.480833, 0.876812, 912,
-    1, 0, 464,
-    0.99846, 0.05547, 465,
-    0.993884, 0.110432, 467,
-    0.986394, 0.164399, 470,
-    0.976187, 0.21693, 475,
-    0.963518, 0.267644, 482,
-    0.948683, 0.316228, 489,
-    0.932005, 0.362446, 498,
-    0.913812, 0.406138, 508,
-    0.894427, 0.447214, 519,
-    0.874157, 0.485643, 531,
-    0.853282, 0.52145, 544,
-    0.83205, 0.5547, 558,
-    0.810679, 0.585491, 572,
-    0.789352, 0.613941, 588,
-    0.768221, 0.640184, 604,
-    0.747409, 0.664364, 621,
-    0.727013, 0.686624, 638,
-    0.707107, 0.707107, 656,
-    0.687745, 0.725953, 675,
-    0.668965, 0.743294, 694,
-    0.650791, 0.759257, 713,
-    0.633238, 0.773957, 733,
-    0.616308, 0.787505, 753,
-    0.6, 0.8, 774,
-    0.584305, 0.811534, 794,
-    0.56921, 0.822192, 816,
-    0.5547, 0.83205, 837,
-    0.540758, 0.841179, 859,
-    0.527363, 0.84964, 880,
-    0.514496, 0.857493, 902,
-    0.502136, 0.864789, 925,
-    1, 0, 490,
-    0.998618, 0.0525588, 491,
-    0.994505, 0.104685, 493,
-    0.987763, 0.155963, 496,
-    0.97855, 0.20601, 501,
-    0.967075, 0.254493, 507,
-    0.953583, 0.301131, 514,
-    0.938343, 0.345705, 522,
-    0.921635, 0.388057, 532,
-    0.903738, 0.428086, 542,
-    0.884918, 0.465746, 554,
-    0.865426, 0.501036, 566,
-    0.845489, 0.533993, 579,
-    0.825307, 0.564684, 594,
-    0.805056, 0.593199, 609,
-    0.784883, 0.619644, 624,
-    0.764911, 0.644136, 641,
-    0.745241, 0.666795, 657,
-    0.725953, 0.687745, 675,
-    0.707107, 0.707107, 693,
-    0.688749, 0.724999, 711,
-    0.670913, 0.741536, 730,
-    0.65362, 0.756823, 750,
-    0.636881, 0.770962, 769,
-    0.620703, 0.784046, 789,
-    0.605083, 0.796162, 810,
-    0.590017, 0.807391, 831,
-    0.575493, 0.817806, 852,
-    0.561501, 0.827476, 873,
-    0.548026, 0.836461, 894,
-    0.535052, 0.844819, 916,
-    0.522562, 0.852601, 938,
-    1, 0, 516,
-    0.998752, 0.0499376, 516,
-    0.995037, 0.0995037, 518,
-    0.988936, 0.14834, 521,
-    0.980581, 0.196116, 526,
-    0.970142, 0.242536, 532,
-    0.957826, 0.287348, 538,
-    0.943858, 0.33035, 546,
-    0.928477, 0.371391, 555,
-    0.911922, 0.410365, 565,
-    0.894427, 0.447214, 577,
-    0.876216, 0.481919, 589,
-    0.857493, 0.514496, 601,
-    0.838444, 0.544988, 615,
-    0.819232, 0.573462, 630,
-    0.8, 0.6, 645,
-    0.780869, 0.624695, 660,
-    0.761939, 0.647648, 677,
-    0.743294, 0.668965, 694,
-    0.724999, 0.688749, 711,
-    0.707107, 0.707107, 729,
-    0.689655, 0.724138, 748,
-    0.672673, 0.73994, 767,
-    0.656179, 0.754606, 786,
-    0.640184, 0.768221, 806,
-    0.624695, 0.780869, 826,
-    0.609711, 0.792624, 846,
-    0.595228, 0.803557, 867,
-    0.581238, 0.813733, 887,
-    0.567733, 0.823213, 909,
-    0.5547, 0.83205, 930,
-    0.542127, 0.840297, 952,
-    1, 0, 541,
-    0.998868, 0.0475651, 542,
-    0.995495, 0.0948091, 544,
-    0.989949, 0.141421, 547,
-    0.982339, 0.187112, 551,
-    0.972806, 0.231621, 557,
-    0.961524, 0.274721, 563,
-    0.948683, 0.316228, 571,
-    0.934488, 0.355995, 579,
-    0.919145, 0.393919, 589,
-    0.902861, 0.429934, 600,
-    0.885832, 0.464007, 611,
-    0.868243, 0.496139, 624,
-    0.850265, 0.526355, 637,
-    0.83205, 0.5547, 651,
-    0.813733, 0.581238, 665,
-    0.795432, 0.606043, 681,
-    0.777245, 0.629198, 697,
-    0.759257, 0.650791, 713,
-    0.741536, 0.670913, 730,
-    0.724138, 0.689655, 748,
-    0.707107, 0.707107, 766,
-    0.690476, 0.723356, 784,
-    0.674269, 0.738486, 803,
-    0.658505, 0.752577, 822,
-    0.643192, 0.765705, 842,
-    0.628337, 0.777941, 862,
-    0.613941, 0.789352, 882,
-    0.6, 0.8, 903,
-    0.58651, 0.809942, 924,
-    0.573462, 0.819232, 945,
-    0.560848, 0.827919, 966,
-    1, 0, 567,
-    0.998969, 0.0454077, 568,
-    0.995893, 0.0905357, 570,
-    0.99083, 0.135113, 572,
-    0.98387, 0.178885, 577,
-    0.975133, 0.221621, 582,
-    0.964764, 0.263117, 588,
-    0.952926, 0.303204, 595,
-    0.939793, 0.341743, 604,
-    0.925547, 0.378633, 613,
-    0.910366, 0.413803, 623,
-    0.894427, 0.447214, 634,
-    0.877896, 0.478852, 646,
-    0.860927, 0.508729, 659,
-    0.843661, 0.536875, 672,
-    0.826227, 0.563337, 687,
-    0.808736, 0.588172, 702,
-    0.791285, 0.611448, 717,
-    0.773957, 0.633238, 733,
-    0.756823, 0.65362, 750,
-    0.73994, 0.672673, 767,
-    0.723356, 0.690476, 784,
-    0.707107, 0.707107, 802,
-    0.691223, 0.722642, 821,
-    0.675725, 0.737154, 840,
-    0.660628, 0.750713, 859,
-    0.645942, 0.763386, 878,
-    0.631673, 0.775235, 898,
-    0.617822, 0.786318, 918,
-    0.604386, 0.796691, 939,
-    0.591364, 0.806405, 960,
-    0.578747, 0.815507, 980,
-    1, 0, 593,
-    0.999056, 0.0434372, 594,
-    0.996241, 0.0866296, 595,
-    0.9916, 0.129339, 598,
-    0.985212, 0.171341, 602,
-    0.977176, 0.21243, 607,
-    0.967617, 0.252422, 613,
-    0.956674, 0.291162, 620,
-    0.944497, 0.328521, 628,
-    0.931243, 0.364399, 637,
-    0.91707, 0.398726, 647,
-    0.902134, 0.431455, 657,
-    0.886585, 0.462566, 669,
-    0.870563, 0.492057, 681,
-    0.854199, 0.519947, 694,
-    0.837611, 0.546268, 708,
-    0.820905, 0.571064, 723,
-    0.804176, 0.594391, 738,
-    0.787505, 0.616308, 753,
-    0.770962, 0.636881, 769,
-    0.754606, 0.656179, 786,
-    0.738486, 0.674269, 803,
-    0.722642, 0.691223, 821,
-    0.707107, 0.707107, 839,
-    0.691905, 0.721988, 857,
-    0.677056, 0.735931, 876,
-    0.662574, 0.748996, 895,
-    0.648466, 0.761243, 915,
-    0.634739, 0.772726, 935,
-    0.621395, 0.783498, 955,
-    0.608432, 0.793606, 975,
-    0.595847, 0.803098, 996,
-    1, 0, 619,
-    0.999133, 0.0416305, 619,
-    0.996546, 0.0830455, 621,
-    0.992278, 0.124035, 624,
-    0.986394, 0.164399, 627,
-    0.97898, 0.203954, 632,
-    0.970142, 0.242536, 638,
-    0.96, 0.28, 645,
-    0.948683, 0.316228, 652,
-    0.936329, 0.351123, 661,
-    0.923077, 0.384615, 670,
-    0.909065, 0.416655, 681,
-    0.894427, 0.447214, 692,
-    0.879292, 0.476283, 704,
-    0.863779, 0.503871, 717,
-    0.847998, 0.529999, 730,
-    0.83205, 0.5547, 744,
-    0.816024, 0.578017, 758,
-    0.8, 0.6, 774,
-    0.784046, 0.620703, 789,
-    0.768221, 0.640184, 806,
-    0.752577, 0.658505, 822,
-    0.737154, 0.675725, 840,
-    0.721988, 0.691905, 857,
-    0.707107, 0.707107, 875,
-    0.692532, 0.721387, 894,
-    0.67828, 0.734803, 913,
-    0.664364, 0.747409, 932,
-    0.650791, 0.759257, 951,
-    0.637568, 0.770394, 971,
-    0.624695, 0.780869, 991,
-    0.612173, 0.790724, 1011,
-    1, 0, 645,
-    0.999201, 0.039968, 645,
-    0.996815, 0.0797452, 647,
-    0.992877, 0.119145, 649,
-    0.987441, 0.15799, 653,
-    0.980581, 0.196116, 657,
-    0.972387, 0.233373, 663,
-    0.962964, 0.26963, 669,
-    0.952424, 0.304776, 677,
-    0.940887, 0.338719, 685,
-    0.928477, 0.371391, 694,
-    0.915315, 0.402739, 704,
-    0.901523, 0.432731, 715,
-    0.887217, 0.461353, 727,
-    0.872506, 0.488603, 739,
-    0.857493, 0.514496, 752,
-    0.842271, 0.539054, 765,
-    0.826927, 0.56231, 780,
-    0.811534, 0.584305, 794,
-    0.796162, 0.605083, 810,
-    0.780869, 0.624695, 826,
-    0.765705, 0.643192, 842,
-    0.750713, 0.660628, 859,
-    0.735931, 0.677056, 876,
-    0.721387, 0.692532, 894,
-    0.707107, 0.707107, 912,
-    0.693109, 0.720833, 930,
-    0.679408, 0.733761, 949,
-    0.666016, 0.745938, 968,
-    0.65294, 0.75741, 988,
-    0.640184, 0.768221, 1007,
-    0.627752, 0.778413, 1027,
-    1, 0, 670,
-    0.999261, 0.0384331, 671,
-    0.997055, 0.0766965, 672,
-    0.993409, 0.114624, 675,
-    0.988372, 0.152057, 678,
-    0.982006, 0.188847, 683,
-    0.974391, 0.22486, 688,
-    0.965616, 0.259973, 694,
-    0.955779, 0.294086, 702,
-    0.944986, 0.327111, 710,
-    0.933346, 0.358979, 718,
-    0.920967, 0.38964, 728,
-    0.907959, 0.419058, 738,
-    0.894427, 0.447214, 750,
-    0.880471, 0.4741, 762,
-    0.866186, 0.499722, 774,
-    0.851658, 0.524097, 787,
-    0.83697, 0.547249, 801,
-    0.822192, 0.56921, 816,
-    0.807391, 0.590017, 831,
-    0.792624, 0.609711, 846,
-    0.777941, 0.628337, 862,
-    0.763386, 0.645942, 878,
-    0.748996, 0.662574, 895,
-    0.734803, 0.67828, 913,
-    0.720833, 0.693109, 930,
-    0.707107, 0.707107, 948,
-    0.693642, 0.72032, 967,
-    0.680451, 0.732794, 986,
-    0.667545, 0.744569, 1005,
-    0.654931, 0.755689, 1024,
-    0.642612, 0.766192, 1044,
-    1, 0, 696,
-    0.999315, 0.0370117, 697,
-    0.997268, 0.0738717, 698,
-    0.993884, 0.110432, 701,
-    0.989204, 0.146549, 704,
-    0.983282, 0.182089, 708,
-    0.976187, 0.21693, 713,
-    0.967997, 0.250962, 719,
-    0.958798, 0.284088, 726,
-    0.948683, 0.316228, 734,
-    0.937749, 0.347314, 743,
-    0.926092, 0.377297, 752,
-    0.913812, 0.406138, 762,
-    0.901002, 0.433816, 773,
-    0.887755, 0.460317, 784,
-    0.874157, 0.485643, 797,
-    0.860291, 0.509802, 809,
-    0.846233, 0.532813, 823,
-    0.83205, 0.5547, 837,
-    0.817806, 0.575493, 852,
-    0.803557, 0.595228, 867,
-    0.789352, 0.613941, 882,
-    0.775235, 0.631673, 898,
-    0.761243, 0.648466, 915,
-    0.747409, 0.664364, 932,
-    0.733761, 0.679408, 949,
-    0.72032, 0.693642, 967,
-    0.707107, 0.707107, 985,
-    0.694136, 0.719844, 1003,
-    0.681419, 0.731894, 1022,
-    0.668965, 0.743294, 1041,
-    0.656781, 0.754082, 1060,
-    1, 0, 722,
-    0.999363, 0.0356915, 723,
-    0.997459, 0.071247, 724,
-    0.994309, 0.106533, 726,
-    0.989949, 0.141421, 729,
-    0.984428, 0.175791, 734,
-    0.977802, 0.209529, 738,
-    0.970142, 0.242536, 744,
-    0.961524, 0.274721, 751,
-    0.952029, 0.306009, 758,
-    0.941742, 0.336336, 767,
-    0.930751, 0.365652, 776,
-    0.919145, 0.393919, 786,
-    0.907009, 0.421111, 796,
-    0.894427, 0.447214, 807,
-    0.88148, 0.472221, 819,
-    0.868243, 0.496139, 832,
-    0.854788, 0.518978, 845,
-    0.841179, 0.540758, 859,
-    0.827476, 0.561501, 873,
-    0.813733, 0.581238, 887,
-    0.8, 0.6, 903,
-    0.786318, 0.617822, 918,
-    0.772726, 0.634739, 935,
-    0.759257, 0.650791, 951,
-    0.745938, 0.666016, 968,
-    0.732794, 0.680451, 986,
-    0.719844, 0.694136, 1003,
-    0.707107, 0.707107, 1021,
-    0.694595, 0.719401, 1040,
-    0.682318, 0.731055, 1059,
-    0.670286, 0.742103, 1078,
-    1, 0, 748,
-    0.999406, 0.0344623, 748,
-    0.99763, 0.0688021, 750,
-    0.994692, 0.102899, 752,
-    0.990621, 0.136637, 755,
-    0.98546, 0.169907, 759,
-    0.97926, 0.202606, 764,
-    0.972082, 0.234641, 769,
-    0.963993, 0.265929, 776,
-    0.955064, 0.296399, 783,
-    0.945373, 0.325991, 791,
-    0.934998, 0.354654, 800,
-    0.924017, 0.382352, 809,
-    0.912509, 0.409056, 820,
-    0.900552, 0.434749, 831,
-    0.888218, 0.459423, 842,
-    0.875578, 0.483077, 854,
-    0.862698, 0.505719, 867,
-    0.84964, 0.527363, 880,
-    0.836461, 0.548026, 894,
-    0.823213, 0.567733, 909,
-    0.809942, 0.58651, 924,
-    0.796691, 0.604386, 939,
-    0.783498, 0.621395, 955,
-    0.770394, 0.637568, 971,
-    0.75741, 0.65294, 988,
-    0.744569, 0.667545, 1005,
-    0.731894, 0.681419, 1022,
-    0.719401, 0.694595, 1040,
-    0.707107, 0.707107, 1058,
-    0.695022, 0.718988, 1076,
-    0.683157, 0.730271, 1095,
-    1, 0, 774,
-    0.999445, 0.0333148, 774,
-    0.997785, 0.066519, 775,
-    0.995037, 0.0995037, 778,
-    0.991228, 0.132164, 781,
-    0.986394, 0.164399, 784,
-    0.980581, 0.196116, 789,
-    0.973841, 0.22723, 794,
-    0.966235, 0.257663, 801,
-    0.957826, 0.287348, 808,
-    0.948683, 0.316228, 816,
-    0.938876, 0.344255, 824,
-    0.928477, 0.371391, 833,
-    0.917556, 0.397607, 843,
-    0.906183, 0.422885, 854,
-    0.894427, 0.447214, 865,
-    0.882353, 0.470588, 877,
-    0.870022, 0.493013, 889,
-    0.857493, 0.514496, 902,
-    0.844819, 0.535052, 916,
-    0.83205, 0.5547, 930,
-    0.819232, 0.573462, 945,
-    0.806405, 0.591364, 960,
-    0.793606, 0.608432, 975,
-    0.780869, 0.624695, 991,
-    0.768221, 0.640184, 1007,
-    0.755689, 0.654931, 1024,
-    0.743294, 0.668965, 1041,
-    0.731055, 0.682318, 1059,
-    0.718988, 0.695022, 1076,
-    0.707107, 0.707107, 1094,
-    0.695421, 0.718602, 1113,
-    1, 0, 800,
-    0.99948, 0.0322413, 800,
-    0.997925, 0.0643823, 801,
-    0.99535, 0.0963242, 803,
-    0.991778, 0.127971, 806,
-    0.987241, 0.159232, 810,
-    0.98178, 0.190022, 814,
-    0.975441, 0.220261, 820,
-    0.968277, 0.249878, 826,
-    0.960346, 0.27881, 833,
-    0.951709, 0.307003, 840,
-    0.942428, 0.33441, 848,
-    0.932568, 0.360994, 857,
-    0.922194, 0.386727, 867,
-    0.911371, 0.411587, 877,
-    0.900159, 0.435561, 888,
-    0.888621, 0.458643, 900,
-    0.876812, 0.480833, 912,
-    0.864789, 0.502136, 925,
-    0.852601, 0.522562, 938,
-    0.840297, 0.542127, 952,
-    0.827919, 0.560848, 966,
-    0.815507, 0.578747, 980,
-    0.803098, 0.595847, 996,
-    0.790724, 0.612173, 1011,
-    0.778413, 0.627752, 1027,
-    0.766192, 0.642612, 1044,
-    0.754082, 0.656781, 1060,
-    0.742103, 0.670286, 1078,
-    0.730271, 0.683157, 1095,
-    0.718602, 0.695421, 1113,
-    0.707107, 0.707107, 1131
-};
+    double fx = mx * (double) GRID_SIZE_X/cols;
+    double fy = my * (double) GRID_SIZE_Y/rows;
+    double d = std::sqrt(fx*fx + fy*fy);
+
+    RIPPLE_VECTOR v;
+    v.dx = d > 0 ? (float) (fx/d) : 0.f;
+    v.dy = d > 0 ? (float) (fy/d) : 0.f;
+    v.r = (int) (d * RIPPLE_CELL_LENGTH);
+    return v;
+}
+
+// Compact offset component: signed 16 bits over +/-RIPPLE_OFFSET_RANGE,
+// read back as the shader's normalized short. Every ripple adds at most
+// RIPPLE_AMP_MAX, so a pool of RIPPLE_POOL_SIZE never reaches the clamp,
+// and rounding moves an offset at most 0.8 px on the largest chunk. Splat pools are larger but never
+// use compact offsets.
+inline short packOffsetValue(float value)
+{
+    float q = std::fmin(std::fmax(value / RIPPLE_OFFSET_RANGE, -1.f), 1.f) * 32767;
+    return (short) std::lround(q);
+}
+
+inline float unpackOffsetValue(short value)
+{
+    return std::fmax(value / 32767.f, -1.f) * RIPPLE_OFFSET_RANGE;
+}
+
+// Fills a (cols+1) x (rows+1) table, indexed [my*(cols+1)+mx], with the
+// vector of every offset within the grid. A 32x32 grid reproduces the
+// original precomputed table.
+inline void buildRippleVectors(RIPPLE_VECTOR *table, int cols, int rows)
+{
+    for (int my = 0; my <= rows; my++)
+        for (int mx = 0; mx <= cols; mx++)
+            table[my*(cols+1)+mx] = makeRippleVector(mx, my, cols, rows);
+}
 
 const RIPPLE_AMP g_ripple_amp[ RIPPLE_LENGTH ] =
 {
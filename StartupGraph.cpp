@@ -0,0 +1,133 @@
+#include "StartupGraph.h"
+#include <QtConcurrent>
+
+Q_LOGGING_CATEGORY(lcStartup, "ripple.startup")
+
+#define TIMELINE_WIDTH          48          // columns of the timeline bars
+
+StartupGraph::StartupGraph()
+{
+}
+
+int StartupGraph::add(const QString& name, Thread thread, const std::function<void()>& work, const std::vector<int>& after)
+{
+    tasks.push_back(Task{ name, thread, work, after, false, false, 0, 0 });
+    return (int) tasks.size() - 1;
+}
+
+void StartupGraph::run()
+{
+    clock.start();
+
+    int remaining = (int) tasks.size();
+    int running = 0;
+    while (remaining > 0)
+    {
+        // Hand every ready worker task to the pool first, so they overlap
+        // the GL task that runs next
+        for (size_t i = 0; i < tasks.size(); i++)
+        {
+            Task &task = tasks[i];
+            if (task.started || task.thread != eThreadWorker || !isReady(task))
+                continue;
+
+            task.started = true;
+            running++;
+            QtConcurrent::run([this, i]() {
+                Task &task = tasks[i];
+                task.begin = clock.nsecsElapsed();
+                task.work();
+                task.end = clock.nsecsElapsed();
+
+                QMutexLocker lock(&mutex);
+                completed.push_back((int) i);
+                finished.release();
+            });
+        }
+
+        Task *next = nullptr;
+        for (Task &task : tasks)
+        {
+            if (!task.started && task.thread == eThreadGL && isReady(task))
+            {
+                next = &task;
+                break;
+            }
+        }
+
+        if (next)
+        {
+            next->started = true;
+            next->begin = clock.nsecsElapsed();
+            next->work();
+            next->end = clock.nsecsElapsed();
+            next->done = true;
+            remaining--;
+        }
+        else if (running > 0)
+        {
+            // Nothing to do on this thread until a worker task finishes
+            finished.acquire();
+            collect();
+            running--;
+            remaining--;
+        }
+        else
+        {
+            qWarning("StartupGraph: %d tasks wait on each other", remaining);
+            break;
+        }
+
+        while (finished.tryAcquire())
+        {
+            collect();
+            running--;
+            remaining--;
+        }
+    }
+}
+
+void StartupGraph::timeline() const
+{
+    double total = elapsed();
+    for (const Task &task : tasks)
+    {
+        double begin = task.begin / 1e6;
+        double end = task.end / 1e6;
+
+        QByteArray bar(TIMELINE_WIDTH, ' ');
+        int from = total > 0 ? qMin((int) (begin / total * TIMELINE_WIDTH), TIMELINE_WIDTH-1) : 0;
+        int to = total > 0 ? qMax((int) (end / total * TIMELINE_WIDTH + 0.5), from+1) : TIMELINE_WIDTH;
+        for (int i = from; i < to; i++)
+            bar[i] = '#';
+
+        qCInfo(lcStartup, "%-16s %-6s %8.1f %8.1f ms |%s|", qPrintable(task.name),
+               task.thread == eThreadGL ? "gl" : "worker", begin, end, bar.constData());
+    }
+    qCInfo(lcStartup, "startup graph done after %.1f ms", total);
+}
+
+double StartupGraph::elapsed() const
+{
+    qint64 end = 0;
+    for (const Task &task : tasks)
+        end = qMax(end, task.end);
+    return end / 1e6;
+}
+
+bool StartupGraph::isReady(const Task& task) const
+{
+    for (int index : task.after)
+    {
+        if (!tasks[index].done)
+            return false;
+    }
+    return true;
+}
+
+void StartupGraph::collect()
+{
+    QMutexLocker lock(&mutex);
+    tasks[completed.back()].done = true;
+    completed.pop_back();
+}
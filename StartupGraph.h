@@ -0,0 +1,62 @@
+#ifndef STARTUPGRAPH_H
+#define STARTUPGRAPH_H
+
+#include <QLoggingCategory>
+#include <QElapsedTimer>
+#include <QSemaphore>
+#include <QMutex>
+#include <QString>
+#include <functional>
+#include <vector>
+
+Q_DECLARE_LOGGING_CATEGORY(lcStartup)
+
+// Small dependency graph for start-up work. Worker tasks go to the thread
+// pool as soon as the tasks they follow are done; GL tasks run on the
+// calling thread, which holds the context, first ready first in the order
+// they were added. run() returns once every task has finished, timeline()
+// logs when each one ran to the "ripple.startup" category.
+class StartupGraph
+{
+public:
+
+    enum Thread
+    {
+        eThreadWorker,
+        eThreadGL
+    };
+
+    StartupGraph();
+
+    int add(const QString& name, Thread thread, const std::function<void()>& work, const std::vector<int>& after = std::vector<int>());
+    void run();
+
+    void timeline() const;
+    double elapsed() const;     // ms from run() until the last task ended
+
+private:
+
+    struct Task
+    {
+        QString name;
+        Thread thread;
+        std::function<void()> work;
+        std::vector<int> after;
+        bool started;
+        bool done;
+        qint64 begin;           // ns since run()
+        qint64 end;
+    };
+
+    bool isReady(const Task& task) const;
+    void collect();
+
+    std::vector<Task> tasks;
+    QElapsedTimer clock;
+
+    QSemaphore finished;        // released by every worker task
+    QMutex mutex;
+    std::vector<int> completed; // worker tasks not collected yet
+};
+
+#endif // STARTUPGRAPH_H
@@ -0,0 +1,112 @@
+#include "TextureCache.h"
+#include "TextureCodec.h"
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QFile>
+#include <QDir>
+#include <cstring>
+
+#define TEXTURE_CACHE_VERSION   1           // bump when the encoders change
+#define KTX_HEADER_SIZE         64
+#define KTX_ENDIANNESS          0x04030201
+#define KTX_GL_RGB              0x1907
+#define KTX_SIZE_MAX            32768       // past any GL texture limit, keeps level sizes in an int
+
+static const char ktxIdentifier[12] = { '\xAB', 'K', 'T', 'X', ' ', '1', '1', '\xBB', '\r', '\n', '\x1A', '\n' };
+
+QString TextureCache::path(const QByteArray& source, QOpenGLTexture::TextureFormat format)
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/textures";
+    QString hash = QString::fromLatin1(QCryptographicHash::hash(source, QCryptographicHash::Sha1).toHex());
+    return QString("%1/%2-%3-v%4.ktx").arg(dir).arg(hash).arg((int) format, 0, 16).arg(TEXTURE_CACHE_VERSION);
+}
+
+bool TextureCache::read(const QString& path, Levels *levels)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QByteArray data = file.readAll();
+    if (data.size() < KTX_HEADER_SIZE || std::memcmp(data.constData(), ktxIdentifier, sizeof(ktxIdentifier)) != 0)
+    {
+        qWarning("TextureCache: %s is not a KTX file", qPrintable(path));
+        return false;
+    }
+
+    // Written by us, so in our byte order and without key/value data
+    quint32 header[13];
+    std::memcpy(header, data.constData() + sizeof(ktxIdentifier), sizeof(header));
+    if (header[0] != KTX_ENDIANNESS || header[12] != 0)
+        return false;
+
+    // Anything but the full chain of one 2D image, as write stores it,
+    // is a miss and gets encoded again
+    int width = (int) qMin<quint32>(header[6], KTX_SIZE_MAX + 1);
+    int height = (int) qMin<quint32>(header[7], KTX_SIZE_MAX + 1);
+    quint32 count = 1;
+    while ((qMax(width, height) >> count) > 0)
+        count++;
+    if (header[5] != KTX_GL_RGB || width < 1 || height < 1 || width > KTX_SIZE_MAX || height > KTX_SIZE_MAX ||
+        header[8] != 0 || header[9] != 0 || header[10] != 1 || header[11] != count)
+    {
+        qWarning("TextureCache: %s does not hold a full mip chain", qPrintable(path));
+        return false;
+    }
+
+    levels->format = (QOpenGLTexture::TextureFormat) header[4];
+    levels->width = width;
+    levels->height = height;
+    levels->data.clear();
+
+    int offset = KTX_HEADER_SIZE;
+    for (quint32 level = 0; level < count; level++)
+    {
+        quint32 size;
+        if (offset + 4 > data.size())
+            return false;
+        std::memcpy(&size, data.constData() + offset, 4);
+        offset += 4;
+
+        int expected = TextureCodec::levelSize(qMax(1, width >> level), qMax(1, height >> level));
+        if (size != (quint32) expected || offset + (qint64) size > data.size())
+        {
+            qWarning("TextureCache: level %u of %s is %u bytes, %d expected", level, qPrintable(path), size, expected);
+            return false;
+        }
+        levels->data.push_back(data.mid(offset, (int) size));
+        offset += (size + 3) & ~3u;
+    }
+    return true;
+}
+
+bool TextureCache::write(const QString& path, const Levels& levels)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    // Written aside and renamed, so a crash never leaves half a file behind
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning("TextureCache: could not write %s", qPrintable(path));
+        return false;
+    }
+
+    quint32 header[13] = {
+        KTX_ENDIANNESS, 0, 1, 0, (quint32) levels.format, KTX_GL_RGB,
+        (quint32) levels.width, (quint32) levels.height, 0, 0, 1, (quint32) levels.data.size(), 0
+    };
+    file.write(ktxIdentifier, sizeof(ktxIdentifier));
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    // Blocks are 8 bytes, so levels need no padding
+    for (const QByteArray &level : levels.data)
+    {
+        quint32 size = (quint32) level.size();
+        file.write(reinterpret_cast<const char*>(&size), 4);
+        file.write(level);
+    }
+    return file.commit();
+}
@@ -0,0 +1,29 @@
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#include <QOpenGLTexture>
+#include <QByteArray>
+#include <QString>
+#include <vector>
+
+// On-disk cache of block compressed mip chains in KTX 1.1 files. Entries
+// are keyed by a hash of the source file's bytes and the target format, so
+// an edited image or another GPU family simply misses.
+class TextureCache
+{
+public:
+
+    struct Levels
+    {
+        QOpenGLTexture::TextureFormat format;
+        int width;
+        int height;
+        std::vector<QByteArray> data;   // largest level first
+    };
+
+    static QString path(const QByteArray& source, QOpenGLTexture::TextureFormat format);
+    static bool read(const QString& path, Levels *levels);
+    static bool write(const QString& path, const Levels& levels);
+};
+
+#endif // TEXTURECACHE_H
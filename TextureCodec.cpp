@@ -0,0 +1,254 @@
+#include "TextureCodec.h"
+#include <climits>
+#include <cstring>
+
+// ETC intensity modifiers, the small and the large step of each table
+static const int etcTables[8][2] = {
+    { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+};
+
+static inline int to565(const int rgb[3])
+{
+    return ((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3);
+}
+
+static inline void from565(int c, int rgb[3])
+{
+    int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+static inline int clamp255(int v)
+{
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+QByteArray TextureCodec::encode(const QImage& image, QOpenGLTexture::TextureFormat format)
+{
+    int w = image.width();
+    int h = image.height();
+    QByteArray data(levelSize(w, h), 0);
+    quint8 *out = reinterpret_cast<quint8*>(data.data());
+
+    // Blocks run left to right, top to bottom, like the image rows
+    quint8 block[16*4];
+    for (int by = 0; by < h; by += 4)
+    {
+        for (int bx = 0; bx < w; bx += 4)
+        {
+            for (int y = 0; y < 4; y++)
+            {
+                const quint8 *row = image.constScanLine(qMin(by + y, h-1));
+                for (int x = 0; x < 4; x++)
+                    std::memcpy(&block[(y*4+x)*4], &row[qMin(bx + x, w-1)*4], 4);
+            }
+
+            if (format == QOpenGLTexture::RGB_DXT1)
+                encodeBC1(block, out);
+            else
+                encodeETC2(block, out);
+            out += 8;
+        }
+    }
+    return data;
+}
+
+int TextureCodec::levelSize(int width, int height)
+{
+    return ((width + 3) / 4) * ((height + 3) / 4) * 8;
+}
+
+void TextureCodec::encodeBC1(const quint8 *block, quint8 *out)
+{
+    int lo[3] = { 255, 255, 255 };
+    int hi[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; i++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            lo[c] = qMin(lo[c], (int) block[i*4+c]);
+            hi[c] = qMax(hi[c], (int) block[i*4+c]);
+        }
+    }
+
+    // Inset the bounding box, so the end points sit inside the cluster
+    for (int c = 0; c < 3; c++)
+    {
+        int inset = (hi[c] - lo[c]) >> 4;
+        lo[c] += inset;
+        hi[c] -= inset;
+    }
+
+    // c0 > c1 selects the four colour mode; equal end points leave every index at 0
+    int c0 = to565(hi);
+    int c1 = to565(lo);
+    quint32 indices = 0;
+    if (c0 != c1)
+    {
+        int palette[4][3];
+        from565(c0, palette[0]);
+        from565(c1, palette[1]);
+        for (int c = 0; c < 3; c++)
+        {
+            palette[2][c] = (2*palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2*palette[1][c]) / 3;
+        }
+
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0, bestError = INT_MAX;
+            for (int j = 0; j < 4; j++)
+            {
+                int error = 0;
+                for (int c = 0; c < 3; c++)
+                {
+                    int d = block[i*4+c] - palette[j][c];
+                    error += d*d;
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = j;
+                }
+            }
+            indices |= (quint32) best << (2*i);
+        }
+    }
+
+    // Little endian
+    out[0] = c0 & 0xff;
+    out[1] = c0 >> 8;
+    out[2] = c1 & 0xff;
+    out[3] = c1 >> 8;
+    for (int i = 0; i < 4; i++)
+        out[4+i] = (indices >> (8*i)) & 0xff;
+}
+
+void TextureCodec::encodeETC2(const quint8 *block, quint8 *out)
+{
+    int bestError = INT_MAX;
+    quint32 bestHigh = 0, bestLow = 0;
+
+    // Split into left and right halves, then top and bottom; keep the better
+    for (int flip = 0; flip < 2; flip++)
+    {
+        int sum[2][3] = { { 0, 0, 0 }, { 0, 0, 0 } };
+        for (int y = 0; y < 4; y++)
+        {
+            for (int x = 0; x < 4; x++)
+            {
+                int half = flip ? y / 2 : x / 2;
+                for (int c = 0; c < 3; c++)
+                    sum[half][c] += block[(y*4+x)*4+c];
+            }
+        }
+
+        // Differential mode when the halves are close, individual otherwise
+        int q[2][3];
+        bool diff = true;
+        for (int c = 0; c < 3; c++)
+        {
+            q[0][c] = ((sum[0][c] + 4) / 8 * 31 + 127) / 255;
+            q[1][c] = ((sum[1][c] + 4) / 8 * 31 + 127) / 255;
+            int d = q[1][c] - q[0][c];
+            diff &= d >= -4 && d <= 3;
+        }
+
+        int base[2][3];
+        for (int half = 0; half < 2; half++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                if (!diff)
+                    q[half][c] = ((sum[half][c] + 4) / 8 * 15 + 127) / 255;
+                base[half][c] = diff ? (q[half][c] << 3) | (q[half][c] >> 2) : q[half][c] * 17;
+            }
+        }
+
+        int table[2];
+        quint32 bits = 0;
+        int error = fitHalf(block, flip, 0, base[0], &table[0], &bits) + fitHalf(block, flip, 1, base[1], &table[1], &bits);
+        if (error >= bestError)
+            continue;
+
+        quint32 high = 0;
+        if (diff)
+        {
+            for (int c = 0; c < 3; c++)
+                high |= (quint32) (q[0][c] << 3 | ((q[1][c] - q[0][c]) & 7)) << (24 - 8*c);
+        }
+        else
+        {
+            for (int c = 0; c < 3; c++)
+                high |= (quint32) (q[0][c] << 4 | q[1][c]) << (24 - 8*c);
+        }
+        high |= table[0] << 5 | table[1] << 2 | (diff ? 2 : 0) | flip;
+
+        bestError = error;
+        bestHigh = high;
+        bestLow = bits;
+    }
+
+    // Big endian
+    for (int i = 0; i < 4; i++)
+    {
+        out[i] = (bestHigh >> (24 - 8*i)) & 0xff;
+        out[4+i] = (bestLow >> (24 - 8*i)) & 0xff;
+    }
+}
+
+int TextureCodec::fitHalf(const quint8 *block, int flip, int half, const int base[3], int *table, quint32 *bits)
+{
+    // Pixel indices are numbered down the columns; the high bit of each
+    // goes to the upper 16 bits. Index 0 and 1 add the small and large
+    // step, 2 and 3 subtract them.
+    int bestError = INT_MAX;
+    quint32 bestBits = 0;
+    for (int t = 0; t < 8; t++)
+    {
+        const int modifiers[4] = { etcTables[t][0], etcTables[t][1], -etcTables[t][0], -etcTables[t][1] };
+        int error = 0;
+        quint32 tableBits = 0;
+        for (int y = 0; y < 4; y++)
+        {
+            for (int x = 0; x < 4; x++)
+            {
+                if ((flip ? y / 2 : x / 2) != half)
+                    continue;
+
+                const quint8 *pixel = &block[(y*4+x)*4];
+                int best = 0, pixelError = INT_MAX;
+                for (int j = 0; j < 4; j++)
+                {
+                    int e = 0;
+                    for (int c = 0; c < 3; c++)
+                    {
+                        int d = clamp255(base[c] + modifiers[j]) - pixel[c];
+                        e += d*d;
+                    }
+                    if (e < pixelError)
+                    {
+                        pixelError = e;
+                        best = j;
+                    }
+                }
+
+                int i = x*4 + y;
+                tableBits |= (quint32) (best >> 1) << (16 + i) | (quint32) (best & 1) << i;
+                error += pixelError;
+            }
+        }
+
+        if (error < bestError)
+        {
+            bestError = error;
+            bestBits = tableBits;
+            *table = t;
+        }
+    }
+
+    *bits |= bestBits;
+    return bestError;
+}
@@ -0,0 +1,25 @@
+#ifndef TEXTURECODEC_H
+#define TEXTURECODEC_H
+
+#include <QOpenGLTexture>
+#include <QByteArray>
+#include <QImage>
+
+// Block compression of RGBA8888 images into the GPU formats the texture
+// cache stores. Both formats code 4x4 pixel blocks in 8 bytes; edge pixels
+// are repeated where the size is not a multiple of 4, alpha is dropped.
+// ETC2 blocks are written in the ETC1 subset, which every ETC2 decoder
+// reads the same.
+class TextureCodec
+{
+public:
+    static QByteArray encode(const QImage& image, QOpenGLTexture::TextureFormat format);
+    static int levelSize(int width, int height);
+
+private:
+    static void encodeBC1(const quint8 *block, quint8 *out);
+    static void encodeETC2(const quint8 *block, quint8 *out);
+    static int fitHalf(const quint8 *block, int flip, int half, const int base[3], int *table, quint32 *bits);
+};
+
+#endif // TEXTURECODEC_H
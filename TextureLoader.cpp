@@ -0,0 +1,187 @@
+#include "TextureLoader.h"
+#include "TextureCodec.h"
+#include "FrameTrace.h"
+#include <QOpenGLContext>
+#include <QFile>
+#include <QtConcurrent>
+
+TextureLoader::TextureLoader()
+    : pixelBuffer(QOpenGLBuffer::PixelUnpackBuffer), compressed(QOpenGLTexture::NoFormat)
+{
+    initializeOpenGLFunctions();
+
+    // Pixel buffers are core from OpenGL 2.1 and OpenGL ES 3.0
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    QSurfaceFormat format = context->format();
+    bool supported = context->isOpenGLES() ? format.majorVersion() >= 3
+                   : format.version() >= qMakePair(2, 1) || context->hasExtension("GL_ARB_pixel_buffer_object");
+
+    if (supported)
+    {
+        pixelBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+        if (!pixelBuffer.create())
+            qWarning("TextureLoader: could not create a pixel buffer, uploading directly");
+    }
+
+    // BC1 where desktop drivers decode it natively, ETC2 on OpenGL ES 3
+    // and on desktops with ES 3 compatibility
+    if (context->hasExtension("GL_EXT_texture_compression_s3tc"))
+        compressed = QOpenGLTexture::RGB_DXT1;
+    else if (context->isOpenGLES() ? format.majorVersion() >= 3
+             : format.version() >= qMakePair(4, 3) || context->hasExtension("GL_ARB_ES3_compatibility"))
+        compressed = QOpenGLTexture::RGB8_ETC2;
+}
+
+TextureLoader::~TextureLoader()
+{
+    pixelBuffer.destroy();
+}
+
+qint64 TextureLoader::Data::byteCount() const
+{
+    qint64 count = 0;
+    for (const QByteArray &level : levels.data)
+        count += level.size();
+
+    // A full mip chain adds a third
+    if (!image.isNull())
+        count = (qint64) image.width() * image.height() * 4 * 4 / 3;
+    return count;
+}
+
+QOpenGLTexture::TextureFormat TextureLoader::compression() const
+{
+    return compressed;
+}
+
+QFuture<TextureLoader::Data> TextureLoader::decode(const QString& fileName) const
+{
+    return QtConcurrent::run(&TextureLoader::decodeImage, fileName, compressed);
+}
+
+QOpenGLTexture *TextureLoader::upload(const Data& data)
+{
+    TRACE_ZONE("TextureLoader::upload");
+    if (!data.levels.data.empty())
+        return uploadLevels(data.levels);
+    if (data.image.isNull())
+        return nullptr;
+
+    const QImage &image = data.image;
+    QOpenGLTexture *texture = new QOpenGLTexture(QOpenGLTexture::Target2D);
+    texture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+    texture->setSize(image.width(), image.height());
+    texture->setMipLevels(texture->maximumMipLevels());
+    texture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+
+    if (!pixelBuffer.isCreated())
+    {
+        texture->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, image.constBits());
+        texture->generateMipMaps();
+        return texture;
+    }
+
+    // Fresh storage each time, so the driver never waits for the previous
+    // transfer; the texture then sources from the buffer asynchronously
+    pixelBuffer.bind();
+    pixelBuffer.allocate(image.constBits(), image.bytesPerLine() * image.height());
+
+    texture->bind();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width(), image.height(), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    texture->release();
+
+    pixelBuffer.release();
+    texture->generateMipMaps();
+    return texture;
+}
+
+QOpenGLTexture *TextureLoader::uploadLevels(const TextureCache::Levels& levels)
+{
+    QOpenGLTexture *texture = new QOpenGLTexture(QOpenGLTexture::Target2D);
+    texture->setFormat(levels.format);
+    texture->setSize(levels.width, levels.height);
+    texture->setMipLevels((int) levels.data.size());
+    texture->create();
+    texture->bind();
+
+    // Each level as stored, through the pixel buffer when there is one
+    for (size_t level = 0; level < levels.data.size(); level++)
+    {
+        const QByteArray &bytes = levels.data[level];
+        const void *pixels = bytes.constData();
+        if (pixelBuffer.isCreated())
+        {
+            pixelBuffer.bind();
+            pixelBuffer.allocate(bytes.constData(), bytes.size());
+            pixels = nullptr;
+        }
+
+        glCompressedTexImage2D(GL_TEXTURE_2D, (GLint) level, levels.format,
+                               qMax(1, levels.width >> level), qMax(1, levels.height >> level), 0, bytes.size(), pixels);
+    }
+
+    if (pixelBuffer.isCreated())
+        pixelBuffer.release();
+    texture->release();
+    return texture;
+}
+
+TextureLoader::Data TextureLoader::decodeImage(const QString& fileName, QOpenGLTexture::TextureFormat compression)
+{
+    TRACE_ZONE("TextureLoader::decodeImage");
+    Data data;
+    data.levels.format = compression;
+    data.levels.width = 0;
+    data.levels.height = 0;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qWarning("TextureLoader: could not open %s", qPrintable(fileName));
+        return data;
+    }
+    QByteArray source = file.readAll();
+
+    // Cached levels skip the JPEG decode entirely
+    QString path;
+    if (compression != QOpenGLTexture::NoFormat)
+    {
+        path = TextureCache::path(source, compression);
+        if (TextureCache::read(path, &data.levels) && data.levels.format == compression)
+            return data;
+        data.levels.data.clear();
+    }
+
+    // Converted here as well, so the GL thread only copies
+    QImage image = QImage::fromData(source).convertToFormat(QImage::Format_RGBA8888);
+    if (image.isNull())
+    {
+        qWarning("TextureLoader: could not decode %s", qPrintable(fileName));
+        return data;
+    }
+
+    if (compression == QOpenGLTexture::NoFormat)
+    {
+        data.image = image;
+        return data;
+    }
+
+    // First load: compress every level, each filtered down from the one
+    // above, and store the chain for the next start
+    data.levels.format = compression;
+    data.levels.width = image.width();
+    data.levels.height = image.height();
+    for (;;)
+    {
+        data.levels.data.push_back(TextureCodec::encode(image, compression));
+        if (image.width() == 1 && image.height() == 1)
+            break;
+
+        image = image.scaled(qMax(1, image.width() / 2), qMax(1, image.height() / 2), Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                     .convertToFormat(QImage::Format_RGBA8888);
+    }
+
+    TextureCache::write(path, data.levels);
+    return data;
+}
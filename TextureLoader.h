@@ -0,0 +1,49 @@
+#ifndef TEXTURELOADER_H
+#define TEXTURELOADER_H
+
+#include <QOpenGLFunctions>
+#include <QOpenGLBuffer>
+#include <QOpenGLTexture>
+#include <QFuture>
+#include <QImage>
+#include "TextureCache.h"
+
+// Moves image loading off the GUI thread. Files are decoded on the worker
+// pool; the finished image is uploaded on the GL thread through a pixel
+// buffer object, so the copy into video memory does not block the draw
+// calls that follow. Images keep their rows top to bottom, the shaders
+// flip the texture coordinates instead.
+//
+// Where the GL takes block compressed textures, the first load transcodes
+// the whole mip chain and stores it in the TextureCache; later loads read
+// the compressed levels back without decoding the JPEG at all.
+class TextureLoader : protected QOpenGLFunctions
+{
+public:
+
+    struct Data
+    {
+        QImage image;                   // without block compression
+        TextureCache::Levels levels;    // compressed mip chain otherwise
+
+        qint64 byteCount() const;
+    };
+
+    TextureLoader();
+    virtual ~TextureLoader();
+
+    QOpenGLTexture::TextureFormat compression() const;
+
+    QFuture<Data> decode(const QString& fileName) const;
+    QOpenGLTexture *upload(const Data& data);
+
+private:
+    static Data decodeImage(const QString& fileName, QOpenGLTexture::TextureFormat compression);
+
+    QOpenGLTexture *uploadLevels(const TextureCache::Levels& levels);
+
+    QOpenGLBuffer pixelBuffer;  // not created when pixel buffers are unsupported
+    QOpenGLTexture::TextureFormat compressed;   // NoFormat without block compression
+};
+
+#endif // TEXTURELOADER_H
@@ -0,0 +1,217 @@
+#include "TextureManager.h"
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(lcTextures, "ripple.textures")
+
+TextureManager::TextureManager(qint64 budget, qint64 tileBudget)
+    : budget(budget), tileBudget(tileBudget), residentBytes(0), current(-1), frame(0), hits(0), misses(0), evictions(0)
+{
+    QImage image(1, 1, QImage::Format_RGBA8888);
+    image.fill(QColor(16, 40, 64));
+    placeholder = new QOpenGLTexture(image, QOpenGLTexture::DontGenerateMipMaps);
+}
+
+TextureManager::~TextureManager()
+{
+    // Decodes still running finish on their own, their results are dropped
+    for (int i = 0; i < count(); i++)
+        release(i);
+    delete placeholder;
+}
+
+void TextureManager::setPlaylist(const QStringList& files)
+{
+    for (int i = 0; i < count(); i++)
+        release(i);
+
+    entries.assign(files.size(), Entry{ QString(), nullptr, nullptr, QFuture<TextureLoader::Data>(), false, false, 0, -1 });
+    for (int i = 0; i < files.size(); i++)
+        entries[i].fileName = files[i];
+    current = -1;
+}
+
+void TextureManager::setBudget(qint64 bytes)
+{
+    budget = bytes;
+    evict();
+}
+
+int TextureManager::count() const
+{
+    return (int) entries.size();
+}
+
+void TextureManager::update()
+{
+    frame++;
+    if (entries.empty())
+        return;
+
+    // At most one upload per frame, the shown entry first
+    int first = qMax(current, 0);
+    for (int j = 0; j < count(); j++)
+    {
+        int i = (first + j) % count();
+        Entry &entry = entries[i];
+        if (!entry.decoding || !entry.data.isFinished())
+            continue;
+
+        TextureLoader::Data data = entry.data.result();
+        entry.texture = loader.upload(data);
+        entry.data = QFuture<TextureLoader::Data>();
+        entry.decoding = false;
+        if (!entry.texture)
+        {
+            entry.failed = true;
+            continue;
+        }
+
+        // Set trilinear filtering mode for texture minification, so the
+        // surface shown smaller than the image samples a matching mip
+        entry.texture->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
+
+        // Set bilinear filtering mode for texture magnification
+        entry.texture->setMagnificationFilter(QOpenGLTexture::Linear);
+
+        // Wrap texture coordinates by repeating
+        // f.ex. texture coordinate (1.1, 1.2) is same as (0.1, 0.2)
+        entry.texture->setWrapMode(QOpenGLTexture::Repeat);
+
+        entry.bytes = data.byteCount();
+        residentBytes += entry.bytes;
+        break;
+    }
+
+    evict();
+}
+
+void TextureManager::bind(int index, const QRectF& rect, QOpenGLShaderProgram *program)
+{
+    if (entries.empty())
+    {
+        placeholder->bind();
+        program->setUniformValue("tiled", false);
+        return;
+    }
+
+    index = qBound(0, index, count()-1);
+    if (index != current)
+    {
+        // Each switch counts once
+        if (isResident(index))
+            hits++;
+        else
+            misses++;
+        current = index;
+
+        qCInfo(lcTextures, "showing %d %s: %d hits, %d misses, %d resident, %.1f of %.1f MB",
+               index, qPrintable(entries[index].fileName), hits, misses, stats().resident,
+               residentBytes / 1048576.0, budget / 1048576.0);
+    }
+
+    prefetch(index);
+
+    Entry &entry = entries[index];
+    if (entry.tiled)
+    {
+        // Stream in the tiles under the view, then bind the tile cache
+        entry.tiled->request(rect);
+        entry.tiled->update();
+    }
+
+    if (entry.tiled && entry.tiled->isReady())
+    {
+        entry.tiled->bind(program);
+    }
+    else
+    {
+        QOpenGLTexture *texture = entry.texture ? entry.texture : placeholder;
+        texture->bind();
+        program->setUniformValue("tiled", false);
+    }
+}
+
+void TextureManager::prefetch(int index)
+{
+    if (entries.empty())
+        return;
+
+    // The entry and the one after it, so stepping through the playlist
+    // finds the next one resident
+    index = qBound(0, index, count()-1);
+    int next = (index + 1) % count();
+    entries[index].lastUsed = frame;
+    entries[next].lastUsed = frame;
+    load(index);
+    load(next);
+}
+
+TextureManager::Stats TextureManager::stats() const
+{
+    Stats stats = { hits, misses, evictions, 0, residentBytes, budget };
+    for (int i = 0; i < count(); i++)
+        stats.resident += isResident(i);
+    return stats;
+}
+
+void TextureManager::load(int index)
+{
+    Entry &entry = entries[index];
+    if (entry.texture || entry.tiled || entry.decoding || entry.failed)
+        return;
+
+    // Posters beyond the texture size limit or the tile budget are streamed in tiles
+    if (TiledTexture::needsTiles(entry.fileName, tileBudget))
+    {
+        entry.tiled = new TiledTexture(entry.fileName, tileBudget);
+        entry.bytes = entry.tiled->memoryUsage();
+        residentBytes += entry.bytes;
+        return;
+    }
+
+    entry.data = loader.decode(entry.fileName);
+    entry.decoding = true;
+}
+
+void TextureManager::release(int index)
+{
+    Entry &entry = entries[index];
+    delete entry.texture;
+    delete entry.tiled;
+    residentBytes -= entry.bytes;
+
+    entry.texture = nullptr;
+    entry.tiled = nullptr;
+    entry.data = QFuture<TextureLoader::Data>();
+    entry.decoding = false;
+    entry.bytes = 0;
+}
+
+void TextureManager::evict()
+{
+    // The shown entry and the prefetched one always stay
+    int next = current >= 0 ? (current + 1) % count() : -1;
+    while (residentBytes > budget)
+    {
+        int oldest = -1;
+        for (int i = 0; i < count(); i++)
+        {
+            if (i == current || i == next || entries[i].bytes == 0)
+                continue;
+            if (oldest < 0 || entries[i].lastUsed < entries[oldest].lastUsed)
+                oldest = i;
+        }
+        if (oldest < 0)
+            break;
+
+        qCDebug(lcTextures, "evicting %d %s, %.1f MB", oldest, qPrintable(entries[oldest].fileName), entries[oldest].bytes / 1048576.0);
+        release(oldest);
+        evictions++;
+    }
+}
+
+bool TextureManager::isResident(int index) const
+{
+    const Entry &entry = entries[index];
+    return entry.texture || (entry.tiled && entry.tiled->isReady());
+}
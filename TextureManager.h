@@ -0,0 +1,79 @@
+#ifndef TEXTUREMANAGER_H
+#define TEXTUREMANAGER_H
+
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+#include <QStringList>
+#include <QFuture>
+#include <QRectF>
+#include <vector>
+#include "TextureLoader.h"
+#include "TiledTexture.h"
+
+// Playlist of background images, loaded on first use. Showing an entry also
+// starts loading the one after it, so stepping through the playlist finds it
+// resident. Uploaded images stay in video memory up to a budget, least
+// recently used out first. Hits, misses and evictions are logged to the
+// "ripple.textures" category.
+class TextureManager
+{
+public:
+
+    struct Stats
+    {
+        int hits;               // entries resident when they were shown
+        int misses;             // entries shown with the placeholder first
+        int evictions;
+        int resident;
+        qint64 residentBytes;
+        qint64 budget;
+    };
+
+    TextureManager(qint64 budget, qint64 tileBudget);
+    virtual ~TextureManager();
+
+    // Both may delete textures, so the context has to be current
+    void setPlaylist(const QStringList& files);
+    void setBudget(qint64 bytes);
+    int count() const;
+
+    void prefetch(int index);
+    void update();
+    void bind(int index, const QRectF& rect, QOpenGLShaderProgram *program);
+
+    Stats stats() const;
+
+private:
+
+    struct Entry
+    {
+        QString fileName;
+        QOpenGLTexture *texture;
+        TiledTexture *tiled;    // images too large to upload whole
+        QFuture<TextureLoader::Data> data;
+        bool decoding;
+        bool failed;
+        qint64 bytes;
+        int lastUsed;           // frame the entry was last shown or prefetched in
+    };
+
+    void load(int index);
+    void release(int index);
+    void evict();
+    bool isResident(int index) const;
+
+    std::vector<Entry> entries;
+    TextureLoader loader;
+    QOpenGLTexture *placeholder;        // shown until an entry has arrived
+
+    qint64 budget;
+    qint64 tileBudget;          // tile cache of each tiled image
+    qint64 residentBytes;
+    int current;
+    int frame;
+    int hits;
+    int misses;
+    int evictions;
+};
+
+#endif // TEXTUREMANAGER_H
@@ -0,0 +1,311 @@
+#include "TiledTexture.h"
+#include "FrameTrace.h"
+#include <QOpenGLContext>
+#include <QImageReader>
+#include <QtConcurrent>
+#include <cmath>
+
+#define TILE_SIZE               256         // image pixels per tile
+#define TILE_BORDER             1           // repeated edge pixels, so bilinear filtering stays inside a slot
+#define TILE_SLOT               (TILE_SIZE + 2*TILE_BORDER)
+#define TILE_FALLBACK_SIZE      1024        // longest side of the low resolution copy
+#define TILE_FADE_FRAMES        15
+#define TILE_MAX_PENDING        8           // decodes in flight
+
+TiledTexture::TiledTexture(const QString& fileName, qint64 budget)
+    : fileName(fileName), cols(0), rows(0), slotCols(0), slotRows(0), frame(0), pageTableDirty(false),
+      cache(nullptr), pages(nullptr), fallback(nullptr)
+{
+    initializeOpenGLFunctions();
+
+    // Only the header is read here
+    QImageReader reader(fileName);
+    imageSize = reader.size();
+    if (imageSize.isEmpty())
+    {
+        qWarning("TiledTexture: could not read %s", qPrintable(fileName));
+        return;
+    }
+
+    cols = (imageSize.width() + TILE_SIZE-1) / TILE_SIZE;
+    rows = (imageSize.height() + TILE_SIZE-1) / TILE_SIZE;
+    tiles.resize(cols*rows, Tile{ -1, -1, 0.f, false, QFuture<QImage>() });
+    pageTable.assign(cols*rows*4, 0);
+
+    // As many slots as the budget holds, laid out in a square within the
+    // texture size limit and the 8 bit slot coordinates of the page table
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    int count = (int) qBound((qint64) 1, budget / (TILE_SLOT*TILE_SLOT*4), (qint64) cols*rows);
+    slotCols = qMin(qMin((int) std::ceil(std::sqrt((double) count)), maxSize / TILE_SLOT), 255);
+    slotRows = qMin(qMin((count + slotCols-1) / slotCols, maxSize / TILE_SLOT), 255);
+    slotTiles.assign(slotCols*slotRows, -1);
+
+    cache = new QOpenGLTexture(QOpenGLTexture::Target2D);
+    cache->setFormat(QOpenGLTexture::RGBA8_UNorm);
+    cache->setSize(slotCols*TILE_SLOT, slotRows*TILE_SLOT);
+    cache->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
+    cache->setWrapMode(QOpenGLTexture::ClampToEdge);
+    cache->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+
+    pages = new QOpenGLTexture(QOpenGLTexture::Target2D);
+    pages->setFormat(QOpenGLTexture::RGBA8_UNorm);
+    pages->setSize(cols, rows);
+    pages->setMinMagFilters(QOpenGLTexture::Nearest, QOpenGLTexture::Nearest);
+    pages->setWrapMode(QOpenGLTexture::ClampToEdge);
+    pages->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+    pages->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, pageTable.data());
+
+    // The low resolution copy is decoded on the worker pool as well; tiles
+    // are only shown once it has arrived
+    fallbackImage = QtConcurrent::run(&TiledTexture::decodeFallback, fileName,
+                                      imageSize.scaled(TILE_FALLBACK_SIZE, TILE_FALLBACK_SIZE, Qt::KeepAspectRatio));
+}
+
+TiledTexture::~TiledTexture()
+{
+    // Decodes still running finish on their own, their results are dropped
+    delete cache;
+    delete pages;
+    delete fallback;
+}
+
+bool TiledTexture::needsTiles(const QString& fileName, qint64 budget)
+{
+    QSize size = QImageReader(fileName).size();
+
+    GLint maxSize = 0;
+    QOpenGLContext::currentContext()->functions()->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+
+    return size.width() > maxSize || size.height() > maxSize || (qint64) size.width() * size.height() * 4 > budget;
+}
+
+void TiledTexture::request(const QRectF& rect)
+{
+    if (!isValid())
+        return;
+
+    // Texture coordinates run bottom to top, tiles top to bottom
+    int x0 = qBound(0, (int) (rect.left() * imageSize.width()) / TILE_SIZE, cols-1);
+    int x1 = qBound(0, (int) (rect.right() * imageSize.width()) / TILE_SIZE, cols-1);
+    int y0 = qBound(0, (int) ((1 - rect.bottom()) * imageSize.height()) / TILE_SIZE, rows-1);
+    int y1 = qBound(0, (int) ((1 - rect.top()) * imageSize.height()) / TILE_SIZE, rows-1);
+
+    for (int y = y0; y <= y1; y++)
+    {
+        for (int x = x0; x <= x1; x++)
+        {
+            int index = y*cols+x;
+            Tile &tile = tiles[index];
+            tile.lastUsed = frame;
+
+            if (tile.slot >= 0 || tile.pending || (int) loading.size() >= TILE_MAX_PENDING)
+                continue;
+
+            tile.pending = true;
+            tile.image = QtConcurrent::run(&TiledTexture::decodeTile, fileName, QRect(x*TILE_SIZE, y*TILE_SIZE, TILE_SIZE, TILE_SIZE));
+            loading.push_back(index);
+        }
+    }
+}
+
+void TiledTexture::update()
+{
+    TRACE_ZONE("TiledTexture::update");
+    if (!isValid())
+        return;
+
+    if (!fallback && fallbackImage.isFinished())
+    {
+        QImage image = fallbackImage.result();
+        fallbackImage = QFuture<QImage>();
+        if (image.isNull())
+        {
+            qWarning("TiledTexture: could not decode %s", qPrintable(fileName));
+            image = QImage(1, 1, QImage::Format_RGBA8888);
+            image.fill(Qt::black);
+        }
+
+        fallback = new QOpenGLTexture(image, QOpenGLTexture::DontGenerateMipMaps);
+        fallback->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
+        fallback->setWrapMode(QOpenGLTexture::ClampToEdge);
+    }
+
+    // Upload finished tiles into free or least recently used slots
+    for (size_t i = 0; i < loading.size(); )
+    {
+        int index = loading[i];
+        Tile &tile = tiles[index];
+        if (!tile.image.isFinished())
+        {
+            i++;
+            continue;
+        }
+
+        QImage image = tile.image.result();
+        tile.image = QFuture<QImage>();
+        tile.pending = false;
+        loading.erase(loading.begin() + i);
+
+        int slot = image.isNull() ? -1 : acquireSlot();
+        if (slot < 0)
+            continue;
+
+        slotTiles[slot] = index;
+        tile.slot = slot;
+        tile.fade = 0.f;
+
+        cache->bind();
+        glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % slotCols) * TILE_SLOT, (slot / slotCols) * TILE_SLOT,
+                        TILE_SLOT, TILE_SLOT, GL_RGBA, GL_UNSIGNED_BYTE, image.constBits());
+        cache->release();
+        writeEntry(index);
+    }
+
+    // Fade new tiles in over the low resolution copy
+    for (int index : slotTiles)
+    {
+        if (index < 0 || tiles[index].fade >= 1.f)
+            continue;
+
+        tiles[index].fade = qMin(1.f, tiles[index].fade + 1.f / TILE_FADE_FRAMES);
+        writeEntry(index);
+    }
+
+    if (pageTableDirty)
+    {
+        pages->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, pageTable.data());
+        pageTableDirty = false;
+    }
+
+    frame++;
+}
+
+void TiledTexture::bind(QOpenGLShaderProgram *program)
+{
+    if (!isReady())
+    {
+        program->setUniformValue("tiled", false);
+        return;
+    }
+
+    // The cache takes the image's unit, the ripple fields keep 1 and 2
+    cache->bind(0, QOpenGLTexture::ResetTextureUnit);
+    pages->bind(3, QOpenGLTexture::ResetTextureUnit);
+    fallback->bind(4, QOpenGLTexture::ResetTextureUnit);
+
+    float width = slotCols*TILE_SLOT;
+    float height = slotRows*TILE_SLOT;
+    program->setUniformValue("tiled", true);
+    program->setUniformValue("page_table", 3);
+    program->setUniformValue("fallback", 4);
+    program->setUniformValue("tile_count", QVector2D(cols, rows));
+    program->setUniformValue("tile_scale", QVector2D((float) imageSize.width() / TILE_SIZE, (float) imageSize.height() / TILE_SIZE));
+    program->setUniformValue("atlas_slot", QVector2D(TILE_SLOT / width, TILE_SLOT / height));
+    program->setUniformValue("atlas_border", QVector2D(TILE_BORDER / width, TILE_BORDER / height));
+    program->setUniformValue("atlas_tile", QVector2D(TILE_SIZE / width, TILE_SIZE / height));
+}
+
+bool TiledTexture::isValid() const
+{
+    return cache != nullptr;
+}
+
+bool TiledTexture::isReady() const
+{
+    return fallback != nullptr;
+}
+
+int TiledTexture::residentCount() const
+{
+    int count = 0;
+    for (int index : slotTiles)
+        count += index >= 0;
+    return count;
+}
+
+int TiledTexture::pendingCount() const
+{
+    return (int) loading.size();
+}
+
+qint64 TiledTexture::memoryUsage() const
+{
+    // Tile cache, page table and the low resolution copy
+    QSize small = imageSize.scaled(TILE_FALLBACK_SIZE, TILE_FALLBACK_SIZE, Qt::KeepAspectRatio);
+    return ((qint64) slotCols*slotRows*TILE_SLOT*TILE_SLOT + cols*rows + (qint64) small.width()*small.height()) * 4;
+}
+
+QImage TiledTexture::decodeTile(const QString& fileName, const QRect& rect)
+{
+    TRACE_ZONE("TiledTexture::decodeTile");
+    // Decode only the tile and its border; JPEG skips the rest of the scan
+    QImageReader reader(fileName);
+    QRect bounds(QPoint(0, 0), reader.size());
+    QRect clip = rect.adjusted(-TILE_BORDER, -TILE_BORDER, TILE_BORDER, TILE_BORDER).intersected(bounds);
+    reader.setClipRect(clip);
+
+    QImage region = reader.read().convertToFormat(QImage::Format_RGBA8888);
+    if (region.isNull())
+        return QImage();
+
+    // Repeat edge pixels into the border and past the image's right and bottom
+    QImage slot(TILE_SLOT, TILE_SLOT, QImage::Format_RGBA8888);
+    for (int y = 0; y < TILE_SLOT; y++)
+    {
+        int sy = qBound(0, rect.y() - TILE_BORDER + y - clip.y(), region.height()-1);
+        const quint32 *src = reinterpret_cast<const quint32*>(region.constScanLine(sy));
+        quint32 *dst = reinterpret_cast<quint32*>(slot.scanLine(y));
+
+        for (int x = 0; x < TILE_SLOT; x++)
+            dst[x] = src[qBound(0, rect.x() - TILE_BORDER + x - clip.x(), region.width()-1)];
+    }
+    return slot;
+}
+
+QImage TiledTexture::decodeFallback(const QString& fileName, const QSize& size)
+{
+    TRACE_ZONE("TiledTexture::decodeFallback");
+    // A lower mip of the whole image; JPEG decodes it scaled, without the
+    // full size pass. Rows stay top to bottom like the tiles.
+    QImageReader reader(fileName);
+    reader.setScaledSize(size);
+    return reader.read().convertToFormat(QImage::Format_RGBA8888);
+}
+
+int TiledTexture::acquireSlot()
+{
+    int oldest = -1;
+    for (size_t slot = 0; slot < slotTiles.size(); slot++)
+    {
+        int index = slotTiles[slot];
+        if (index < 0)
+            return (int) slot;
+
+        // Tiles requested this frame are in view and stay
+        if (tiles[index].lastUsed < frame && (oldest < 0 || tiles[index].lastUsed < tiles[slotTiles[oldest]].lastUsed))
+            oldest = (int) slot;
+    }
+
+    if (oldest >= 0)
+    {
+        int index = slotTiles[oldest];
+        tiles[index].slot = -1;
+        tiles[index].fade = 0.f;
+        writeEntry(index);
+        slotTiles[oldest] = -1;
+    }
+    return oldest;
+}
+
+void TiledTexture::writeEntry(int index)
+{
+    const Tile &tile = tiles[index];
+    GLubyte *entry = &pageTable[index*4];
+
+    entry[0] = tile.slot >= 0 ? (GLubyte) (tile.slot % slotCols) : 0;
+    entry[1] = tile.slot >= 0 ? (GLubyte) (tile.slot / slotCols) : 0;
+    entry[2] = (GLubyte) qRound(tile.fade * 255);
+    entry[3] = tile.slot >= 0 ? 255 : 0;
+    pageTableDirty = true;
+}
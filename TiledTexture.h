@@ -0,0 +1,72 @@
+#ifndef TILEDTEXTURE_H
+#define TILEDTEXTURE_H
+
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+#include <QFuture>
+#include <QImage>
+#include <QRectF>
+#include <vector>
+
+// Virtual texture for images too large to upload whole. The image is cut
+// into tiles that are decoded on worker threads when first requested, and
+// kept in a cache texture sized by a memory budget, least recently used out
+// first. A page table maps image tiles to cache slots; a small copy of the
+// whole image stands in for tiles that have not arrived, and new tiles fade
+// in over it.
+class TiledTexture : protected QOpenGLFunctions
+{
+public:
+    TiledTexture(const QString& fileName, qint64 budget);
+    virtual ~TiledTexture();
+
+    static bool needsTiles(const QString& fileName, qint64 budget);
+
+    void request(const QRectF& rect);
+    void update();
+    void bind(QOpenGLShaderProgram *program);
+
+    bool isValid() const;
+    bool isReady() const;       // the low resolution copy has been uploaded
+    int residentCount() const;
+    int pendingCount() const;
+    qint64 memoryUsage() const; // bytes of video memory
+
+private:
+    struct Tile
+    {
+        int slot;               // cache slot, -1 when not resident
+        int lastUsed;           // frame the tile was last requested in
+        float fade;             // 0 when just uploaded, 1 when fully shown
+        bool pending;
+        QFuture<QImage> image;
+    };
+
+    static QImage decodeTile(const QString& fileName, const QRect& rect);
+    static QImage decodeFallback(const QString& fileName, const QSize& size);
+
+    int acquireSlot();
+    void writeEntry(int index);
+
+    QString fileName;
+    QSize imageSize;
+    int cols;                   // image tiles
+    int rows;
+    int slotCols;               // cache layout
+    int slotRows;
+    int frame;
+
+    std::vector<Tile> tiles;
+    std::vector<int> slotTiles; // tile held by each slot, -1 when free
+    std::vector<int> loading;   // tiles being decoded
+    std::vector<GLubyte> pageTable;
+    bool pageTableDirty;
+
+    QOpenGLTexture *cache;
+    QOpenGLTexture *pages;
+    QOpenGLTexture *fallback;
+    QFuture<QImage> fallbackImage;
+};
+
+#endif // TILEDTEXTURE_H
@@ -3,6 +3,8 @@
 #include "GLWidget.h"
 #include <QSpinBox>
 #include <QSlider>
+#include <QCheckBox>
+#include <QShortcut>
 
 
 Window::Window(QWidget *parent) :
@@ -21,6 +23,29 @@ Window::Window(QWidget *parent) :
     QObject::connect(findChild<QRadioButton*>("imageRadioButton1"), SIGNAL(clicked()), this, SLOT(imageRadio1Clicked()));
     QObject::connect(findChild<QRadioButton*>("imageRadioButton2"), SIGNAL(clicked()), this, SLOT(imageRadio2Clicked()));
     QObject::connect(findChild<QRadioButton*>("imageRadioButton3"), SIGNAL(clicked()), this, SLOT(imageRadio3Clicked()));
+    QObject::connect(new QShortcut(QKeySequence(Qt::Key_PageDown), this), SIGNAL(activated()), findChild<GLWidget*>("glWidget"), SLOT(nextImage()));
+    QObject::connect(new QShortcut(QKeySequence(Qt::Key_PageUp), this), SIGNAL(activated()), findChild<GLWidget*>("glWidget"), SLOT(previousImage()));
+
+    QObject::connect(findChild<QRadioButton*>("formatFloat"), SIGNAL(clicked()), this, SLOT(formatRadio1Clicked()));
+    QObject::connect(findChild<QRadioButton*>("formatCompact"), SIGNAL(clicked()), this, SLOT(formatRadio2Clicked()));
+
+    QObject::connect(findChild<QRadioButton*>("backendVertices"), SIGNAL(clicked()), this, SLOT(backendRadio1Clicked()));
+    QObject::connect(findChild<QRadioButton*>("backendTexture"), SIGNAL(clicked()), this, SLOT(backendRadio2Clicked()));
+    QObject::connect(findChild<QRadioButton*>("backendSplat"), SIGNAL(clicked()), this, SLOT(backendRadio3Clicked()));
+    QObject::connect(findChild<QRadioButton*>("backendCompute"), SIGNAL(clicked()), this, SLOT(backendRadio4Clicked()));
+
+    QObject::connect(findChild<QSpinBox*>("meshSpinBox"), SIGNAL(valueChanged(int)), findChild<GLWidget*>("glWidget"), SLOT(setMeshSize(int)));
+    QObject::connect(findChild<QSpinBox*>("fieldSpinBox"), SIGNAL(valueChanged(int)), findChild<GLWidget*>("glWidget"), SLOT(setFieldSize(int)));
+    QObject::connect(findChild<QSpinBox*>("keyframeSpinBox"), SIGNAL(valueChanged(int)), findChild<GLWidget*>("glWidget"), SLOT(setKeyframeInterval(int)));
+    QObject::connect(findChild<QCheckBox*>("meshAdaptive"), SIGNAL(toggled(bool)), findChild<GLWidget*>("glWidget"), SLOT(setAdaptiveMesh(bool)));
+
+    QObject::connect(findChild<QSpinBox*>("scaleSpinBox"), SIGNAL(valueChanged(int)), findChild<QSlider*>("scaleSlider"), SLOT(setValue(int)));
+    QObject::connect(findChild<QSlider*>("scaleSlider"), SIGNAL(valueChanged(int)), findChild<QSpinBox*>("scaleSpinBox"), SLOT(setValue(int)));
+    QObject::connect(findChild<QSlider*>("scaleSlider"), SIGNAL(valueChanged(int)), findChild<GLWidget*>("glWidget"), SLOT(setRenderScale(int)));
+    QObject::connect(findChild<GLWidget*>("glWidget"), SIGNAL(renderScaleChanged(int)), findChild<QSlider*>("scaleSlider"), SLOT(setValue(int)));
+    QObject::connect(findChild<QCheckBox*>("scaleDynamic"), SIGNAL(toggled(bool)), findChild<GLWidget*>("glWidget"), SLOT(setDynamicScale(bool)));
+    QObject::connect(findChild<QCheckBox*>("qualityAdaptive"), SIGNAL(toggled(bool)), findChild<GLWidget*>("glWidget"), SLOT(setAdaptiveQuality(bool)));
+    QObject::connect(findChild<QCheckBox*>("hudVisible"), SIGNAL(toggled(bool)), findChild<GLWidget*>("glWidget"), SLOT(setHudVisible(bool)));
 }
 
 Window::~Window()
@@ -52,3 +77,33 @@ void Window::imageRadio3Clicked()
 {
     findChild<GLWidget*>("glWidget")->setTexture(2);
 }
+
+void Window::formatRadio1Clicked()
+{
+    findChild<GLWidget*>("glWidget")->setVertexFormat(0);
+}
+
+void Window::formatRadio2Clicked()
+{
+    findChild<GLWidget*>("glWidget")->setVertexFormat(1);
+}
+
+void Window::backendRadio1Clicked()
+{
+    findChild<GLWidget*>("glWidget")->setBackend(0);
+}
+
+void Window::backendRadio2Clicked()
+{
+    findChild<GLWidget*>("glWidget")->setBackend(1);
+}
+
+void Window::backendRadio3Clicked()
+{
+    findChild<GLWidget*>("glWidget")->setBackend(2);
+}
+
+void Window::backendRadio4Clicked()
+{
+    findChild<GLWidget*>("glWidget")->setBackend(3);
+}
@@ -25,6 +25,14 @@ public slots:
     void imageRadio1Clicked();
     void imageRadio2Clicked();
     void imageRadio3Clicked();
+
+    void formatRadio1Clicked();
+    void formatRadio2Clicked();
+
+    void backendRadio1Clicked();
+    void backendRadio2Clicked();
+    void backendRadio3Clicked();
+    void backendRadio4Clicked();
 };
 
 #endif // WINDOW_H
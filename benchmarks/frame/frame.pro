@@ -0,0 +1,39 @@
+#-------------------------------------------------
+#
+# End-to-end frame benchmark: update, upload, draw
+# and glFinish offscreen, on Mesa's llvmpipe
+#
+#-------------------------------------------------
+
+QT       += core gui opengl
+
+CONFIG   += console c++11
+CONFIG   -= app_bundle
+
+TARGET = frame_bench
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES +=\
+    main.cpp \
+    ../../RippleEffect.cpp \
+    ../../RippleSplat.cpp \
+    ../../RippleCompute.cpp \
+    ../../RippleQuadTree.cpp \
+    ../../RippleField.cpp \
+    ../../RippleGeometry.cpp \
+    ../../RippleEmitter.cpp
+
+HEADERS  += \
+    ../../RippleEffect.h \
+    ../../RippleSplat.h \
+    ../../RippleCompute.h \
+    ../../RippleQuadTree.h \
+    ../../RippleField.h \
+    ../../RippleGeometry.h \
+    ../../RippleEmitter.h \
+    ../../RippleTable.h
+
+RESOURCES += \
+    ../../Resources.qrc
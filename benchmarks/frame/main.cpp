@@ -0,0 +1,342 @@
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+#include <QOpenGLTimerQuery>
+#include <QImage>
+#include <QElapsedTimer>
+#include <QMatrix4x4>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "RippleEffect.h"
+#include "RippleEmitter.h"
+#include "RippleTable.h"
+
+#define VIEW_SIZE               512         // one surface chunk, as the widget shows at zoom 1
+#define WARMUP_FRAMES           200         // about one ripple lifetime at step 14
+#define FRAMES                  300
+
+#ifndef GL_VERTEX_SHADER_INVOCATIONS_ARB
+#define GL_VERTEX_SHADER_INVOCATIONS_ARB 0x82F0
+#endif
+
+// A scripted workload on one configuration of the effect, as a
+// RippleEmitter spec. The live ripple count settles within the warm-up, at
+// about 200 times the rain rate for step 14. Scenarios use the index layout
+// their mesh size picks by default, the -strip ones force row strips.
+struct Scenario
+{
+    const char *name;
+    RippleEffect::Backend backend;
+    RippleEffect::VertexFormat format;
+    int mesh;                   // cells, and simulation grid of the field backends
+    RippleEffect::IndexLayout layout;
+    int keyframes;              // display frames per simulated frame
+    int pool;                   // live ripples before the oldest make way
+    const char *workload;
+};
+
+static const Scenario scenarios[] =
+{
+    { "rain",           RippleEffect::eBackendVertices, RippleEffect::eVertexFloat,   32,  RippleEffect::eIndexStrip,     1, RIPPLE_POOL_SIZE,       "rain:rate=0.25,step=14" },
+    { "storm",          RippleEffect::eBackendVertices, RippleEffect::eVertexFloat,   128, RippleEffect::eIndexTriangles, 1, RIPPLE_POOL_SIZE,       "rain:rate=2,step=14" },
+    { "storm-strip",    RippleEffect::eBackendVertices, RippleEffect::eVertexFloat,   128, RippleEffect::eIndexStrip,     1, RIPPLE_POOL_SIZE,       "rain:rate=2,step=14" },
+    { "fine",           RippleEffect::eBackendVertices, RippleEffect::eVertexFloat,   255, RippleEffect::eIndexTriangles, 1, RIPPLE_POOL_SIZE,       "rain:rate=2,step=14" },
+    { "fine-strip",     RippleEffect::eBackendVertices, RippleEffect::eVertexFloat,   255, RippleEffect::eIndexStrip,     1, RIPPLE_POOL_SIZE,       "rain:rate=2,step=14" },
+    { "storm-compact",  RippleEffect::eBackendVertices, RippleEffect::eVertexCompact, 128, RippleEffect::eIndexTriangles, 1, RIPPLE_POOL_SIZE,       "rain:rate=2,step=14" },
+    { "keyframes-2",    RippleEffect::eBackendVertices, RippleEffect::eVertexCompact, 128, RippleEffect::eIndexTriangles, 2, RIPPLE_POOL_SIZE,       "rain:rate=2,step=14" },
+    { "keyframes-4",    RippleEffect::eBackendVertices, RippleEffect::eVertexCompact, 128, RippleEffect::eIndexTriangles, 4, RIPPLE_POOL_SIZE,       "rain:rate=2,step=14" },
+    { "keyframes-8",    RippleEffect::eBackendVertices, RippleEffect::eVertexCompact, 128, RippleEffect::eIndexTriangles, 8, RIPPLE_POOL_SIZE,       "rain:rate=2,step=14" },
+    { "drag",           RippleEffect::eBackendVertices, RippleEffect::eVertexFloat,   128, RippleEffect::eIndexTriangles, 1, RIPPLE_POOL_SIZE,       "drag:speed=12,rate=1,step=14" },
+    { "burst",          RippleEffect::eBackendVertices, RippleEffect::eVertexFloat,   128, RippleEffect::eIndexTriangles, 1, RIPPLE_POOL_SIZE,       "burst:count=100,period=60,step=14" },
+    { "texture",        RippleEffect::eBackendTexture,  RippleEffect::eVertexFloat,   128, RippleEffect::eIndexTriangles, 1, RIPPLE_POOL_SIZE,       "rain:rate=2,step=14" },
+    { "compute",        RippleEffect::eBackendCompute,  RippleEffect::eVertexFloat,   128, RippleEffect::eIndexTriangles, 1, RIPPLE_POOL_SIZE,       "rain:rate=2,step=14" },
+    { "splat-256",      RippleEffect::eBackendSplat,    RippleEffect::eVertexFloat,   128, RippleEffect::eIndexTriangles, 1, RIPPLE_POOL_SIZE_SPLAT, "rain:rate=1.3,step=14" },
+    { "splat-1024",     RippleEffect::eBackendSplat,    RippleEffect::eVertexFloat,   128, RippleEffect::eIndexTriangles, 1, RIPPLE_POOL_SIZE_SPLAT, "rain:rate=6,step=14" },
+    { "splat-4096",     RippleEffect::eBackendSplat,    RippleEffect::eVertexFloat,   128, RippleEffect::eIndexTriangles, 1, RIPPLE_POOL_SIZE_SPLAT, "rain:rate=21,step=14" },
+    { "splat-10k",      RippleEffect::eBackendSplat,    RippleEffect::eVertexFloat,   128, RippleEffect::eIndexTriangles, 1, RIPPLE_POOL_SIZE_SPLAT, "rain:rate=51,step=14" }
+};
+
+// Per-frame phases, in ms. update is the CPU simulation without its
+// buffer and texture writes, which upload holds; draw only submits, finish
+// waits for the GPU to drain.
+struct Frame
+{
+    double update;
+    double upload;
+    double draw;
+    double finish;
+    double gpu;                 // timer query around the draw, -1 without one
+    double invocations;         // vertex shader runs per mesh vertex, -1 without the statistics query
+    double total;
+};
+
+struct Result
+{
+    const char *name;
+    double update;              // means
+    double upload;
+    double draw;
+    double finish;
+    double gpu;
+    double invocations;
+    double p50;                 // frame time percentiles
+    double p95;
+    double p99;
+    long dropped;               // ripples the full pool dropped
+};
+
+static double percentile(std::vector<double> values, double p)
+{
+    std::sort(values.begin(), values.end());
+    size_t index = std::min(values.size() - 1, (size_t) (p * (values.size() - 1) + 0.5));
+    return values[index];
+}
+
+static bool run(const Scenario& scenario, const char *workload, QOpenGLShaderProgram& program, QOpenGLTexture& texture, int frames, Result& result)
+{
+    RippleEmitter::Config config;
+    if (!RippleEmitter::parse(workload, config))
+        return false;
+
+    QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
+
+    RippleEffect effect(&program, VIEW_SIZE, VIEW_SIZE);
+    effect.setMeshSize(scenario.mesh, scenario.mesh);
+    effect.setFieldSize(scenario.mesh, scenario.mesh);
+    effect.setIndexLayout(scenario.layout);
+    if (!effect.setBackend(scenario.backend))
+        return false;
+    effect.setVertexFormat(scenario.format);
+    effect.setKeyframeInterval(scenario.keyframes);
+    effect.setPoolSize(scenario.pool);
+
+    QOpenGLTimerQuery query;
+    bool timed = query.create();
+
+    // Vertex shader runs show how well the index layout uses the
+    // post-transform cache, where the driver counts them
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    QOpenGLExtraFunctions *ef = context->extraFunctions();
+    GLuint statistics = 0;
+    if (context->hasExtension("GL_ARB_pipeline_statistics_query"))
+        ef->glGenQueries(1, &statistics);
+    double vertices = (scenario.mesh + 1) * (scenario.mesh + 1);
+
+    // Seeded, so every run sees the same drops
+    RippleEmitter emitter(config, VIEW_SIZE, VIEW_SIZE);
+
+    QMatrix4x4 projection;
+    projection.ortho(0, VIEW_SIZE, 0, VIEW_SIZE, -1, 1000);
+    QMatrix4x4 matrix;
+    matrix.translate(VIEW_SIZE/2, VIEW_SIZE/2, 0);
+
+    std::vector<Frame> samples;
+    QElapsedTimer clock;
+    for (int frame = 0; frame < WARMUP_FRAMES + frames; frame++)
+    {
+        for (const RippleEmitter::Drop& drop : emitter.next())
+            effect.addRipple(drop.x, drop.y, drop.step);
+
+        Frame sample;
+        clock.start();
+        effect.update();
+        sample.upload = effect.uploadTime() / 1e6;
+        sample.update = clock.nsecsElapsed() / 1e6 - sample.upload;
+
+        clock.start();
+        if (timed)
+            query.begin();
+        f->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        program.bind();
+        texture.bind();
+        program.setUniformValue("mvp_matrix", projection * matrix);
+        program.setUniformValue("texture", 0);
+        program.setUniformValue("tiled", false);
+        if (statistics)
+            ef->glBeginQuery(GL_VERTEX_SHADER_INVOCATIONS_ARB, statistics);
+        effect.draw();
+        if (statistics)
+            ef->glEndQuery(GL_VERTEX_SHADER_INVOCATIONS_ARB);
+        if (timed)
+            query.end();
+        sample.draw = clock.nsecsElapsed() / 1e6;
+
+        clock.start();
+        f->glFinish();
+        sample.finish = clock.nsecsElapsed() / 1e6;
+
+        // Done after glFinish, so reading it never stalls
+        sample.gpu = timed ? query.waitForResult() / 1e6 : -1;
+        sample.invocations = -1;
+        if (statistics)
+        {
+            GLuint count = 0;
+            ef->glGetQueryObjectuiv(statistics, GL_QUERY_RESULT, &count);
+            sample.invocations = count / vertices;
+        }
+        sample.total = sample.update + sample.upload + sample.draw + sample.finish;
+
+        if (frame >= WARMUP_FRAMES)
+            samples.push_back(sample);
+    }
+
+    if (statistics)
+        ef->glDeleteQueries(1, &statistics);
+
+    result = Result{ scenario.name, 0, 0, 0, 0, 0, 0, 0, 0, 0, effect.droppedCount() };
+    std::vector<double> totals;
+    for (const Frame& sample : samples)
+    {
+        result.update += sample.update / samples.size();
+        result.upload += sample.upload / samples.size();
+        result.draw += sample.draw / samples.size();
+        result.finish += sample.finish / samples.size();
+        result.gpu += sample.gpu / samples.size();
+        result.invocations += sample.invocations / samples.size();
+        totals.push_back(sample.total);
+    }
+    result.p50 = percentile(totals, 0.50);
+    result.p95 = percentile(totals, 0.95);
+    result.p99 = percentile(totals, 0.99);
+    return true;
+}
+
+static bool writeJson(const char *fileName, const char *renderer, int frames, const std::vector<Result>& results)
+{
+    FILE *file = std::fopen(fileName, "w");
+    if (!file)
+        return false;
+
+    std::fprintf(file, "{\n  \"benchmark\": \"frame\",\n  \"renderer\": \"%s\",\n  \"frames\": %d,\n  \"results\": [\n", renderer, frames);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result& r = results[i];
+        std::fprintf(file, "    { \"name\": \"%s\", \"update_ms\": %.4f, \"upload_ms\": %.4f, \"draw_ms\": %.4f, \"finish_ms\": %.4f, \"gpu_ms\": %.4f, \"vs_per_vertex\": %.4f, "
+                           "\"p50_ms\": %.4f, \"p95_ms\": %.4f, \"p99_ms\": %.4f, \"dropped\": %ld }%s\n",
+                     r.name, r.update, r.upload, r.draw, r.finish, r.gpu, r.invocations, r.p50, r.p95, r.p99, r.dropped, i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    return std::fclose(file) == 0;
+}
+
+// frame_bench [--hardware] [--frames N] [--filter name] [--emit spec] [--json file]
+// Runs on Mesa's software rasterizer unless --hardware is given, so results
+// compare across machines. vs/vertex is vertex shader runs per mesh
+// vertex, -1 where GL_ARB_pipeline_statistics_query is missing; compare
+// storm with storm-strip for the index layouts. Without a display, run it under xvfb-run.
+// --emit replaces every scenario's workload, to find where a backend
+// falls over.
+int main(int argc, char *argv[])
+{
+    bool hardware = false;
+    int frames = FRAMES;
+    const char *filter = nullptr;
+    const char *json = nullptr;
+    const char *workload = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--hardware") == 0)
+            hardware = true;
+        else if (std::strcmp(argv[i], "--frames") == 0 && i+1 < argc)
+            frames = qMax(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--filter") == 0 && i+1 < argc)
+            filter = argv[++i];
+        else if (std::strcmp(argv[i], "--json") == 0 && i+1 < argc)
+            json = argv[++i];
+        else if (std::strcmp(argv[i], "--emit") == 0 && i+1 < argc)
+            workload = argv[++i];
+        else
+        {
+            std::fprintf(stderr, "usage: frame_bench [--hardware] [--frames N] [--filter name] [--emit spec] [--json file]\n");
+            return 2;
+        }
+    }
+
+    RippleEmitter::Config config;
+    if (workload && !RippleEmitter::parse(workload, config))
+    {
+        std::fprintf(stderr, "frame_bench: unknown workload %s\n", workload);
+        return 2;
+    }
+
+    if (!hardware)
+        qputenv("LIBGL_ALWAYS_SOFTWARE", "1");
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QGuiApplication app(argc, argv);
+
+    QOffscreenSurface surface;
+    surface.create();
+
+    QOpenGLContext context;
+    if (!context.create() || !context.makeCurrent(&surface))
+    {
+        std::fprintf(stderr, "frame_bench: no OpenGL context\n");
+        return 1;
+    }
+
+    QOpenGLFramebufferObject fbo(VIEW_SIZE, VIEW_SIZE, QOpenGLFramebufferObject::CombinedDepthStencil);
+    fbo.bind();
+
+    QOpenGLFunctions *f = context.functions();
+    f->glViewport(0, 0, VIEW_SIZE, VIEW_SIZE);
+    f->glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    f->glEnable(GL_DEPTH_TEST);
+    f->glEnable(GL_CULL_FACE);
+
+    QOpenGLShaderProgram program;
+    if (!program.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/vshader.glsl") ||
+        !program.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/fshader.glsl") ||
+        !program.link())
+    {
+        std::fprintf(stderr, "frame_bench: could not build the shaders\n");
+        return 1;
+    }
+
+    QOpenGLTexture texture(QImage(":/textures/water_water_0056_01.jpg"));
+    texture.setWrapMode(QOpenGLTexture::Repeat);
+
+    QByteArray renderer((const char *) f->glGetString(GL_RENDERER));
+    std::printf("%s, %dx%d, %d frames after %d warm-up\n", renderer.constData(), VIEW_SIZE, VIEW_SIZE, frames, WARMUP_FRAMES);
+    std::printf("%-14s %10s %10s %10s %10s %10s %9s %9s %9s %9s\n", "scenario", "update ms", "upload ms", "draw ms", "finish ms", "gpu ms", "vs/vertex", "p50 ms", "p95 ms", "p99 ms");
+
+    std::vector<Result> results;
+    for (const Scenario& scenario : scenarios)
+    {
+        if (filter && !std::strstr(scenario.name, filter))
+            continue;
+
+        Result result;
+        if (!run(scenario, workload ? workload : scenario.workload, program, texture, frames, result))
+        {
+            std::printf("%-14s not supported by this context\n", scenario.name);
+            continue;
+        }
+
+        std::printf("%-14s %10.3f %10.3f %10.3f %10.3f %10.3f %9.3f %9.3f %9.3f %9.3f\n", result.name,
+                    result.update, result.upload, result.draw, result.finish, result.gpu, result.invocations, result.p50, result.p95, result.p99);
+        if (result.dropped > 0)
+            std::printf("%-14s %ld ripples dropped at the pool limit of %d, the workload exceeds the pool\n", "", result.dropped, scenario.pool);
+        std::fflush(stdout);
+        results.push_back(result);
+    }
+
+    fbo.release();
+    context.doneCurrent();
+
+    if (json && !writeJson(json, renderer.constData(), frames, results))
+    {
+        std::fprintf(stderr, "frame_bench: could not write %s\n", json);
+        return 1;
+    }
+    return 0;
+}
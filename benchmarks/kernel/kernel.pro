@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# CPU ripple kernel benchmark, no GPU or Qt needed
+#
+#-------------------------------------------------
+
+CONFIG   += console c++11
+CONFIG   -= qt app_bundle
+
+TARGET = kernel_bench
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES +=\
+    main.cpp \
+    ../../RippleField.cpp \
+    ../../RippleGeometry.cpp
+
+HEADERS  += \
+    ../../RippleField.h \
+    ../../RippleGeometry.h \
+    ../../RippleTable.h
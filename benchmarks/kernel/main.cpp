@@ -0,0 +1,336 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+#include "RippleField.h"
+#include "RippleGeometry.h"
+
+#define AREA_SIZE               512.f       // pixels the grid covers, as one surface chunk
+#define MIN_TIME_MS             200         // time each case runs for at least
+#define POOL_SIZE               4096        // largest live ripple count
+
+static const int gridSizes[] = { 32, 64, 128, 256, 512 };
+static const int rippleCounts[] = { 1, 16, 256, 4096 };
+static const int meshSizes[] = { 32, 64, 128, 255 };
+static const int cacheSizes[] = { 16, 32 };
+
+struct Vector2D
+{
+    float x;
+    float y;
+};
+
+struct Vector3D
+{
+    float x;
+    float y;
+    float z;
+};
+
+// One timed case; the pool cases time single insertions or retirements
+struct Result
+{
+    std::string name;
+    int grid;
+    int ripples;
+    long iterations;
+    double ns;                  // mean time per update, insertion or retirement
+    double vertices;            // grid vertices evaluated per second
+    double evaluations;         // ripple-vertex evaluations per second
+};
+
+// Post-transform cache behaviour of one index layout
+struct CacheResult
+{
+    int mesh;
+    const char *layout;
+    int cache;
+    double acmr;                // vertex shader runs per triangle
+    double atvr;                // vertex shader runs per vertex
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double minTime = MIN_TIME_MS * 1e6;   // ns
+
+static double elapsed(Clock::time_point start)
+{
+    return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+static void fill(RippleField& field, int count, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> position(-AREA_SIZE/2, AREA_SIZE/2);
+    while (field.count() < count)
+        field.addRipple(position(rng), position(rng));
+}
+
+// RippleEffect::update on the CPU path: advance, then evaluate every inner
+// vertex into the float layout of one distortion mode. Retired ripples are
+// replaced outside the timed part, so the live count stays put.
+static Result runUpdate(int grid, int ripples, bool vertices)
+{
+    RippleField field(AREA_SIZE, AREA_SIZE, grid, grid, POOL_SIZE);
+    std::mt19937 rng(1);
+
+    int count = (grid+1)*(grid+1);
+    std::vector<Vector3D> positions(count), positionsCopy(count);
+    std::vector<Vector2D> texCoords(count), texCoordsCopy(count);
+    for (int y = 0; y <= grid; y++)
+    {
+        for (int x = 0; x <= grid; x++)
+        {
+            int i = y*(grid+1)+x;
+            positionsCopy[i] = positions[i] = Vector3D{ x*AREA_SIZE/grid - AREA_SIZE/2, (grid-y)*AREA_SIZE/grid - AREA_SIZE/2, 0.f };
+            texCoordsCopy[i] = texCoords[i] = Vector2D{ (float) x/grid, (float) (grid-y)/grid };
+        }
+    }
+
+    auto update = [&]() {
+        field.advance(1);
+        if (vertices)
+        {
+            field.evaluate(AREA_SIZE, AREA_SIZE, [&](int offset, float ox, float oy) {
+                positions[offset].x = positionsCopy[offset].x + ox;
+                positions[offset].y = positionsCopy[offset].y + oy;
+            });
+        }
+        else
+        {
+            field.evaluate(1, 1, [&](int offset, float ox, float oy) {
+                texCoords[offset].x = texCoordsCopy[offset].x + ox;
+                texCoords[offset].y = texCoordsCopy[offset].y + oy;
+            });
+        }
+    };
+
+    fill(field, ripples, rng);
+    update();
+
+    Result result = { vertices ? "update/vertices" : "update/texcoords", grid, ripples, 0, 0, 0, 0 };
+    double total = 0;
+    while (total < minTime)
+    {
+        fill(field, ripples, rng);
+        Clock::time_point start = Clock::now();
+        update();
+        total += elapsed(start);
+        result.iterations++;
+    }
+
+    // Only inner vertices move, the border stays at rest
+    double inner = (double) (grid-1)*(grid-1);
+    result.ns = total / result.iterations;
+    result.vertices = inner / result.ns * 1e9;
+    result.evaluations = inner * ripples / result.ns * 1e9;
+    return result;
+}
+
+// addRipple into an empty pool, and into a full one that drops its oldest
+static Result runInsert(int ripples, bool full)
+{
+    RippleField field(AREA_SIZE, AREA_SIZE, GRID_SIZE_X, GRID_SIZE_Y, ripples);
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(-AREA_SIZE/2, AREA_SIZE/2);
+
+    Result result = { full ? "insert/full" : "insert/empty", GRID_SIZE_X, ripples, 0, 0, 0, 0 };
+    double total = 0;
+    while (total < minTime)
+    {
+        field.clear();
+        if (full)
+            fill(field, ripples, rng);
+
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < ripples; i++)
+            field.addRipple(position(rng), position(rng));
+        total += elapsed(start);
+        result.iterations++;
+    }
+
+    result.ns = total / result.iterations / ripples;
+    return result;
+}
+
+// The advance that retires every ripple of the pool at once
+static Result runRetire(int ripples)
+{
+    RippleField field(AREA_SIZE, AREA_SIZE, GRID_SIZE_X, GRID_SIZE_Y, ripples);
+    std::mt19937 rng(1);
+
+    Result result = { "retire", GRID_SIZE_X, ripples, 0, 0, 0, 0 };
+    double total = 0;
+    while (total < minTime)
+    {
+        field.clear();
+        fill(field, ripples, rng);
+        field.advance(RIPPLE_LENGTH * 2);
+
+        Clock::time_point start = Clock::now();
+        field.advance(1);
+        total += elapsed(start);
+        result.iterations++;
+    }
+
+    result.ns = total / result.iterations / ripples;
+    return result;
+}
+
+// Vertex shader runs of one index layout through a FIFO post-transform
+// cache, as most GPUs without an optimized index order behave
+static CacheResult runIndices(int mesh, bool triangles, int cache)
+{
+    RippleGeometry::Indices indices = RippleGeometry::indices(mesh, mesh, triangles);
+
+    std::deque<unsigned short> fifo;
+    long misses = 0;
+    for (unsigned short index : *indices)
+    {
+        bool hit = false;
+        for (unsigned short entry : fifo)
+        {
+            if (entry == index)
+            {
+                hit = true;
+                break;
+            }
+        }
+        if (hit)
+            continue;
+
+        misses++;
+        fifo.push_back(index);
+        if ((int) fifo.size() > cache)
+            fifo.pop_front();
+    }
+
+    // Degenerate joins of the strip layout draw nothing
+    double drawn = 2.0 * mesh * mesh;
+    double vertices = (double) (mesh+1)*(mesh+1);
+    return CacheResult{ mesh, triangles ? "triangles" : "strip", cache, misses / drawn, misses / vertices };
+}
+
+static bool writeJson(const char *fileName, const std::vector<Result>& results, const std::vector<CacheResult>& caches)
+{
+    FILE *file = std::fopen(fileName, "w");
+    if (!file)
+        return false;
+
+    std::fprintf(file, "{\n  \"benchmark\": \"kernel\",\n  \"min_time_ms\": %.0f,\n  \"results\": [\n", minTime / 1e6);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result& r = results[i];
+        std::fprintf(file, "    { \"name\": \"%s\", \"grid\": %d, \"ripples\": %d, \"iterations\": %ld, \"ns\": %.1f, "
+                           "\"vertices_per_sec\": %.0f, \"evaluations_per_sec\": %.0f }%s\n",
+                     r.name.c_str(), r.grid, r.ripples, r.iterations, r.ns, r.vertices, r.evaluations,
+                     i + 1 < results.size() ? "," : "");
+    }
+
+    std::fprintf(file, "  ],\n  \"indices\": [\n");
+    for (size_t i = 0; i < caches.size(); i++)
+    {
+        const CacheResult& c = caches[i];
+        std::fprintf(file, "    { \"mesh\": %d, \"layout\": \"%s\", \"cache\": %d, \"acmr\": %.3f, \"atvr\": %.3f }%s\n",
+                     c.mesh, c.layout, c.cache, c.acmr, c.atvr, i + 1 < caches.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    return std::fclose(file) == 0;
+}
+
+static void print(const Result& r)
+{
+    if (r.vertices > 0)
+        std::printf("%-18s %5d %7d %10.0f %12.3f %14.3f\n", r.name.c_str(), r.grid, r.ripples, r.ns, r.vertices / 1e6, r.evaluations / 1e6);
+    else
+        std::printf("%-18s %5s %7d %10.1f\n", r.name.c_str(), "", r.ripples, r.ns);
+    std::fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *json = nullptr;
+    const char *filter = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!std::strcmp(argv[i], "--json") && i + 1 < argc)
+            json = argv[++i];
+        else if (!std::strcmp(argv[i], "--filter") && i + 1 < argc)
+            filter = argv[++i];
+        else if (!std::strcmp(argv[i], "--min-ms") && i + 1 < argc)
+            minTime = std::atof(argv[++i]) * 1e6;
+        else
+        {
+            std::fprintf(stderr, "usage: kernel_bench [--json file] [--filter name] [--min-ms ms]\n");
+            return 2;
+        }
+    }
+
+    auto wanted = [&](const char *name) {
+        return !filter || std::strstr(name, filter);
+    };
+
+    std::vector<Result> results;
+    std::printf("%-18s %5s %7s %10s %12s %14s\n", "case", "grid", "ripples", "ns", "Mvertices/s", "Mevaluations/s");
+
+    const bool modes[] = { true, false };
+    for (bool vertices : modes)
+    {
+        if (!wanted(vertices ? "update/vertices" : "update/texcoords"))
+            continue;
+
+        for (int grid : gridSizes)
+        {
+            for (int ripples : rippleCounts)
+            {
+                results.push_back(runUpdate(grid, ripples, vertices));
+                print(results.back());
+            }
+        }
+    }
+
+    for (int ripples : rippleCounts)
+    {
+        std::vector<Result> pool;
+        if (wanted("insert/empty"))
+            pool.push_back(runInsert(ripples, false));
+        if (wanted("insert/full"))
+            pool.push_back(runInsert(ripples, true));
+        if (wanted("retire"))
+            pool.push_back(runRetire(ripples));
+
+        for (const Result& result : pool)
+        {
+            print(result);
+            results.push_back(result);
+        }
+    }
+
+    std::vector<CacheResult> caches;
+    if (wanted("indices"))
+    {
+        std::printf("\n%-10s %5s %6s %8s %8s\n", "layout", "mesh", "cache", "ACMR", "ATVR");
+        for (int mesh : meshSizes)
+        {
+            for (int cache : cacheSizes)
+            {
+                for (int triangles = 0; triangles < 2; triangles++)
+                {
+                    caches.push_back(runIndices(mesh, triangles, cache));
+                    const CacheResult& c = caches.back();
+                    std::printf("%-10s %5d %6d %8.3f %8.3f\n", c.layout, c.mesh, c.cache, c.acmr, c.atvr);
+                }
+            }
+        }
+    }
+
+    if (json && !writeJson(json, results, caches))
+    {
+        std::fprintf(stderr, "kernel_bench: could not write %s\n", json);
+        return 1;
+    }
+    return 0;
+}
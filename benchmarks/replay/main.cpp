@@ -0,0 +1,158 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "RippleField.h"
+#include "RippleLayout.h"
+#include "RippleLog.h"
+#include "RippleEmitter.h"
+
+#define FNV_OFFSET              1469598103934665603ull
+#define FNV_PRIME               1099511628211ull
+#define EMIT_SIZE               512         // surface of generated workloads, in pixels
+#define EMIT_FRAMES             600
+
+// Hash of every displacement the replay produced, bit for bit
+static uint64_t hashFloat(uint64_t hash, float value)
+{
+    unsigned char bytes[sizeof(float)];
+    std::memcpy(bytes, &value, sizeof(value));
+    for (unsigned char byte : bytes)
+        hash = (hash ^ byte) * FNV_PRIME;
+    return hash;
+}
+
+// replay_bench <log> [--grid N] [--expect hash]
+// replay_bench --emit spec [--frames N] [--save log] [--grid N] [--expect hash]
+// Feeds a ripple log, or a workload generated by RippleEmitter, through
+// the simulation core at full speed, one update per recorded frame, until
+// the last ripple has retired. The surface is cut into chunks by the
+// RippleLayout RippleSurface uses, each on a grid of N cells. Prints the
+// time taken and a hash of all displacements, chunk by chunk; with
+// --expect, fails when the hash differs, so a log doubles as a regression
+// check of the kernel. --save writes the generated workload as a log the
+// app can replay.
+int main(int argc, char *argv[])
+{
+    const char *fileName = nullptr;
+    const char *expect = nullptr;
+    const char *spec = nullptr;
+    const char *save = nullptr;
+    int grid = GRID_SIZE_X;
+    int frames = EMIT_FRAMES;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--grid") == 0 && i+1 < argc)
+            grid = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--expect") == 0 && i+1 < argc)
+            expect = argv[++i];
+        else if (std::strcmp(argv[i], "--emit") == 0 && i+1 < argc)
+            spec = argv[++i];
+        else if (std::strcmp(argv[i], "--frames") == 0 && i+1 < argc)
+            frames = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--save") == 0 && i+1 < argc)
+            save = argv[++i];
+        else
+            fileName = argv[i];
+    }
+
+    RippleLog log;
+    RippleEmitter::Config config;
+    bool valid = grid >= 1 && (spec ? RippleEmitter::parse(spec, config) : fileName && log.load(fileName));
+    if (!valid || (spec && save && !log.create(save, EMIT_SIZE, EMIT_SIZE)))
+    {
+        std::fprintf(stderr, "usage: replay_bench <log> [--grid N] [--expect hash]\n"
+                             "       replay_bench --emit spec [--frames N] [--save log] [--grid N] [--expect hash]\n");
+        return 2;
+    }
+
+    // Generated workloads become the same events a recording holds
+    std::vector<RippleLog::Event> generated;
+    if (spec)
+    {
+        RippleEmitter emitter(config, EMIT_SIZE, EMIT_SIZE);
+        for (int frame = 0; frame < frames; frame++)
+        {
+            for (const RippleEmitter::Drop& drop : emitter.next())
+            {
+                RippleLog::Event event = { (unsigned) frame, 0, drop.x, drop.y, drop.step, 0, 1 };
+                generated.push_back(event);
+                log.append(event);
+            }
+        }
+        log.close();
+    }
+
+    // The chunks the app would simulate for this surface
+    RippleLayout layout(spec ? EMIT_SIZE : log.width(), spec ? EMIT_SIZE : log.height());
+    std::vector<std::unique_ptr<RippleField>> chunks;
+    for (int i = 0; i < layout.count(); i++)
+    {
+        RippleLayout::Chunk place = layout.chunk(i);
+        chunks.emplace_back(new RippleField(place.width, place.height, grid, grid));
+        chunks.back()->setOrigin(place.x, place.y);
+        chunks.back()->setPinnedEdges(place.pinned);
+    }
+
+    // Chunks a ripple can reach before it retires get their own copy
+    auto addRipple = [&](float x, float y, int step) {
+        for (int i = 0; i < layout.count(); i++)
+        {
+            if (layout.reaches(i, x, y))
+                chunks[i]->addRipple(x, y, step);
+        }
+    };
+    auto live = [&]() {
+        int count = 0;
+        for (const auto& chunk : chunks)
+            count += chunk->count();
+        return count;
+    };
+
+    const std::vector<RippleLog::Event>& events = spec ? generated : log.events();
+
+    uint64_t hash = FNV_OFFSET;
+    double evaluations = 0;
+    unsigned frame = 0;
+    size_t next = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while (next < events.size() || live() > 0)
+    {
+        for (; next < events.size() && events[next].frame <= frame; next++)
+            addRipple(events[next].x, events[next].y, events[next].step);
+
+        for (const auto& chunk : chunks)
+        {
+            chunk->advance(1);
+            chunk->evaluate(1, 1, [&](int, float ox, float oy) {
+                hash = hashFloat(hashFloat(hash, ox), oy);
+            });
+            evaluations += (double) chunk->evaluatedCount() * chunk->count();
+        }
+        frame++;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    char digest[17];
+    std::snprintf(digest, sizeof(digest), "%016" PRIx64, hash);
+    long dropped = 0;
+    for (const auto& chunk : chunks)
+        dropped += chunk->dropped();
+
+    std::printf("%d ripples, %u updates of %d chunks on %dx%d grids in %.1f ms, %.1f M evaluations/s\n",
+                (int) events.size(), frame, layout.count(), grid, grid, ms, ms > 0 ? evaluations / ms / 1e3 : 0.0);
+    std::printf("hash %s\n", digest);
+    if (dropped > 0)
+        std::printf("%ld ripples dropped at the pool limit of %d\n", dropped, chunks.front()->capacity());
+
+    if (expect && std::strcmp(expect, digest) != 0)
+    {
+        std::fprintf(stderr, "replay_bench: hash %s, expected %s\n", digest, expect);
+        return 1;
+    }
+    return 0;
+}
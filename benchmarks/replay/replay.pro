@@ -0,0 +1,30 @@
+#-------------------------------------------------
+#
+# Ripple log replay through the simulation core,
+# timed and hashed as a regression check
+#
+#-------------------------------------------------
+
+CONFIG   += console c++11
+CONFIG   -= qt app_bundle
+
+TARGET = replay_bench
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES +=\
+    main.cpp \
+    ../../RippleField.cpp \
+    ../../RippleGeometry.cpp \
+    ../../RippleLog.cpp \
+    ../../RippleEmitter.cpp \
+    ../../RippleLayout.cpp
+
+HEADERS  += \
+    ../../RippleField.h \
+    ../../RippleGeometry.h \
+    ../../RippleLog.h \
+    ../../RippleEmitter.h \
+    ../../RippleLayout.h \
+    ../../RippleTable.h
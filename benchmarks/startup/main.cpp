@@ -0,0 +1,219 @@
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLShaderProgram>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QMatrix4x4>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "RippleSurface.h"
+#include "RippleGeometry.h"
+#include "StartupGraph.h"
+#include "TextureLoader.h"
+
+#define VIEW_SIZE               512
+#define MESH_LEVELS             3           // as GLWidget's QUALITY_MESH_LEVELS
+#define WARM_RUNS               3
+#define FIRST_IMAGE             ":/textures/water_water_0056_01.jpg"
+
+// One start in a fresh process: context, first image, shaders, meshes and
+// the first frame, the way GLWidget::initializeGL and the first paintGL do
+// them, either one step after the other or as the start-up task graph. The
+// first frame waits for the image, so its decode is part of the time.
+// Prints the shader build time and the time to first frame, in ms.
+static int runOnce(int argc, char *argv[], bool parallel, QElapsedTimer& clock)
+{
+    QGuiApplication app(argc, argv);
+
+    QOffscreenSurface surface;
+    surface.create();
+
+    QOpenGLContext context;
+    if (!context.create() || !context.makeCurrent(&surface))
+    {
+        std::fprintf(stderr, "startup_bench: no OpenGL context\n");
+        return 1;
+    }
+
+    QOpenGLFramebufferObject fbo(VIEW_SIZE, VIEW_SIZE, QOpenGLFramebufferObject::CombinedDepthStencil);
+    fbo.bind();
+
+    QOpenGLShaderProgram program;
+    TextureLoader loader;
+    QFuture<TextureLoader::Data> image;
+    RippleSurface *meshes[MESH_LEVELS] = {};
+    double shaderMs = 0;
+    bool built = true;
+
+    auto decode = [&]() {
+        image = loader.decode(FIRST_IMAGE);
+    };
+    auto tables = [](int level) {
+        RippleGeometry::prepare(qMax(4, GRID_SIZE_X >> level), qMax(4, GRID_SIZE_Y >> level));
+    };
+    auto shaders = [&]() {
+        QElapsedTimer shaderClock;
+        shaderClock.start();
+        built = program.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/vshader.glsl") &&
+                program.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/fshader.glsl") &&
+                program.link();
+        shaderMs = shaderClock.nsecsElapsed() / 1e6;
+    };
+    auto build = [&]() {
+        for (int i = 0; i < MESH_LEVELS; i++)
+        {
+            meshes[i] = new RippleSurface(&program, VIEW_SIZE, VIEW_SIZE);
+            meshes[i]->setMeshSize(qMax(4, GRID_SIZE_X >> i), qMax(4, GRID_SIZE_Y >> i));
+        }
+    };
+
+    if (parallel)
+    {
+        StartupGraph graph;
+        graph.add("textures", StartupGraph::eThreadGL, decode);
+        std::vector<int> ready;
+        for (int i = 0; i < MESH_LEVELS; i++)
+            ready.push_back(graph.add(QString("tables %1").arg(i), StartupGraph::eThreadWorker, [=]() { tables(i); }));
+        ready.push_back(graph.add("shaders", StartupGraph::eThreadGL, shaders));
+        graph.add("meshes", StartupGraph::eThreadGL, build, ready);
+        graph.run();
+        graph.timeline();
+    }
+    else
+    {
+        decode();
+        image.waitForFinished();
+        shaders();
+        for (int i = 0; i < MESH_LEVELS; i++)
+            tables(i);
+        build();
+    }
+
+    if (!built)
+    {
+        std::fprintf(stderr, "startup_bench: could not build the shaders\n");
+        return 1;
+    }
+
+    QOpenGLFunctions *f = context.functions();
+    f->glViewport(0, 0, VIEW_SIZE, VIEW_SIZE);
+    f->glEnable(GL_DEPTH_TEST);
+    f->glEnable(GL_CULL_FACE);
+    f->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    QMatrix4x4 projection;
+    projection.ortho(0, VIEW_SIZE, 0, VIEW_SIZE, -1, 1000);
+    QMatrix4x4 matrix;
+    matrix.translate(VIEW_SIZE/2, VIEW_SIZE/2, 0);
+
+    QOpenGLTexture *texture = loader.upload(image.result());
+    if (!texture)
+    {
+        std::fprintf(stderr, "startup_bench: could not load %s\n", FIRST_IMAGE);
+        return 1;
+    }
+
+    meshes[0]->update();
+    program.bind();
+    texture->bind();
+    program.setUniformValue("mvp_matrix", projection * matrix);
+    program.setUniformValue("texture", 0);
+    program.setUniformValue("tiled", false);
+    meshes[0]->draw();
+    f->glFinish();
+
+    std::printf("%.2f %.2f\n", shaderMs, clock.nsecsElapsed() / 1e6);
+
+    for (RippleSurface *mesh : meshes)
+        delete mesh;
+    delete texture;
+    fbo.release();
+    context.doneCurrent();
+    return 0;
+}
+
+static bool launch(const QString& program, const char *mode, const QProcessEnvironment& env, bool timeline,
+                   double *shaderMs, double *frameMs)
+{
+    QProcess process;
+    process.setProcessEnvironment(env);
+    if (timeline)
+        process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    process.start(program, QStringList() << "--run" << mode);
+    if (!process.waitForFinished(-1) || process.exitCode() != 0)
+        return false;
+
+    return std::sscanf(process.readAllStandardOutput().constData(), "%lf %lf", shaderMs, frameMs) == 2;
+}
+
+// startup_bench [--timeline] [--max-ms N]
+// Fails when the task graph's warm time to first frame exceeds N ms.
+int main(int argc, char *argv[])
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    // Inherited by every run, which then needs no display
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    if (argc > 2 && std::strcmp(argv[1], "--run") == 0)
+        return runOnce(argc, argv, std::strcmp(argv[2], "graph") == 0, clock);
+
+    bool timeline = false;
+    double maxMs = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--timeline") == 0)
+            timeline = true;
+        else if (std::strcmp(argv[i], "--max-ms") == 0 && i+1 < argc)
+            maxMs = std::atof(argv[++i]);
+    }
+
+    QCoreApplication app(argc, argv);
+
+    std::printf("%-8s %-9s %12s %16s\n", "startup", "cache", "shaders ms", "first frame ms");
+    const char *modes[] = { "serial", "graph" };
+    double graphMs = 0;
+    for (const char *mode : modes)
+    {
+        // Qt keeps program binaries and the compressed image cache under
+        // the generic cache location; an empty XDG_CACHE_HOME makes the
+        // first run cold and the others warm
+        QTemporaryDir cache;
+        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+        env.insert("XDG_CACHE_HOME", cache.path());
+
+        double warmShader = 0, warmFrame = 0;
+        for (int run = 0; run <= WARM_RUNS; run++)
+        {
+            double shaderMs, frameMs;
+            if (!launch(app.applicationFilePath(), mode, env, timeline, &shaderMs, &frameMs))
+            {
+                std::fprintf(stderr, "startup_bench: %s run %d failed\n", mode, run);
+                return 1;
+            }
+            std::printf("%-8s %-9s %12.2f %16.2f\n", mode, run == 0 ? "cold" : "warm", shaderMs, frameMs);
+
+            if (run > 0)
+            {
+                warmShader += shaderMs / WARM_RUNS;
+                warmFrame += frameMs / WARM_RUNS;
+            }
+        }
+        std::printf("%-8s %-9s %12.2f %16.2f\n", mode, "warm mean", warmShader, warmFrame);
+        graphMs = warmFrame;
+    }
+
+    if (maxMs > 0 && graphMs > maxMs)
+    {
+        std::fprintf(stderr, "startup_bench: first frame after %.2f ms, limit %.2f ms\n", graphMs, maxMs);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+#-------------------------------------------------
+#
+# Time to first frame, serial and as a task graph, with a cold and a
+# warm shader and image cache
+#
+#-------------------------------------------------
+
+QT       += core gui opengl concurrent
+
+CONFIG   += console c++11
+CONFIG   -= app_bundle
+
+TARGET = startup_bench
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES +=\
+    main.cpp \
+    ../../RippleEffect.cpp \
+    ../../RippleSplat.cpp \
+    ../../RippleCompute.cpp \
+    ../../RippleQuadTree.cpp \
+    ../../RippleField.cpp \
+    ../../RippleGeometry.cpp \
+    ../../RippleSurface.cpp \
+    ../../RippleLayout.cpp \
+    ../../StartupGraph.cpp \
+    ../../TextureCodec.cpp \
+    ../../TextureCache.cpp \
+    ../../TextureLoader.cpp
+
+HEADERS  += \
+    ../../RippleEffect.h \
+    ../../RippleSplat.h \
+    ../../RippleCompute.h \
+    ../../RippleQuadTree.h \
+    ../../RippleField.h \
+    ../../RippleGeometry.h \
+    ../../RippleSurface.h \
+    ../../RippleLayout.h \
+    ../../StartupGraph.h \
+    ../../TextureCodec.h \
+    ../../TextureCache.h \
+    ../../TextureLoader.h \
+    ../../RippleTable.h
+
+RESOURCES += \
+    ../../Resources.qrc
@@ -0,0 +1,139 @@
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+#include <QImage>
+#include <QElapsedTimer>
+#include <QMatrix4x4>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include "RippleSurface.h"
+
+#define VIEW_SIZE               512         // visible area, in pixels
+#define AREA_FACTOR             10          // surface area over the visible area
+#define FRAMES                  600
+#define RAIN_INTERVAL           4           // frames between two ripples
+
+struct Result
+{
+    double update;              // mean CPU time of RippleSurface::update, in ms
+    double draw;                // mean time of RippleSurface::draw until glFinish, in ms
+    double visible;             // mean chunks simulated per frame
+    int chunks;
+};
+
+static Result run(QOpenGLShaderProgram& program, QOpenGLTexture& texture, float side, bool culling)
+{
+    QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
+
+    RippleSurface surface(&program, side, side);
+    surface.setCulling(culling);
+
+    // Both runs see the same rain and the same camera path
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(-side/2, side/2);
+
+    QMatrix4x4 projection;
+    projection.ortho(0, VIEW_SIZE, 0, VIEW_SIZE, -1, 1000);
+
+    Result result = { 0, 0, 0, surface.chunkCount() };
+    QElapsedTimer clock;
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        if (frame % RAIN_INTERVAL == 0)
+        {
+            float x = position(rng);
+            float y = position(rng);
+            surface.addRipple(x, y);
+        }
+
+        // Pan once around a circle that keeps the view on the surface
+        float angle = frame * 6.2831853f / FRAMES;
+        float radius = (side - VIEW_SIZE) / 2;
+        float px = std::cos(angle) * radius;
+        float py = std::sin(angle) * radius;
+        surface.setViewport(QRectF(px - VIEW_SIZE/2, py - VIEW_SIZE/2, VIEW_SIZE, VIEW_SIZE));
+
+        clock.start();
+        surface.update();
+        result.update += clock.nsecsElapsed() / 1e6;
+        result.visible += surface.visibleCount();
+
+        clock.start();
+        f->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        program.bind();
+        texture.bind();
+
+        QMatrix4x4 matrix;
+        matrix.translate(VIEW_SIZE/2, VIEW_SIZE/2, 0);
+        matrix.translate(-px, -py, 0);
+        program.setUniformValue("mvp_matrix", projection * matrix);
+        program.setUniformValue("texture", 0);
+
+        surface.draw();
+        f->glFinish();
+        result.draw += clock.nsecsElapsed() / 1e6;
+    }
+
+    result.update /= FRAMES;
+    result.draw /= FRAMES;
+    result.visible /= FRAMES;
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+
+    QOffscreenSurface surface;
+    surface.create();
+
+    QOpenGLContext context;
+    if (!context.create() || !context.makeCurrent(&surface))
+    {
+        std::fprintf(stderr, "surface_bench: no OpenGL context\n");
+        return 1;
+    }
+
+    // Render into a framebuffer the size of the widget's view
+    QOpenGLFramebufferObject fbo(VIEW_SIZE, VIEW_SIZE, QOpenGLFramebufferObject::CombinedDepthStencil);
+    fbo.bind();
+
+    QOpenGLFunctions *f = context.functions();
+    f->glViewport(0, 0, VIEW_SIZE, VIEW_SIZE);
+    f->glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    f->glEnable(GL_DEPTH_TEST);
+    f->glEnable(GL_CULL_FACE);
+
+    QOpenGLShaderProgram program;
+    if (!program.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/vshader.glsl") ||
+        !program.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/fshader.glsl") ||
+        !program.link())
+    {
+        std::fprintf(stderr, "surface_bench: could not build the shaders\n");
+        return 1;
+    }
+
+    // Rows top to bottom, the fragment shader flips the texture coordinates
+    QOpenGLTexture texture(QImage(":/textures/water_water_0056_01.jpg"));
+    texture.setWrapMode(QOpenGLTexture::Repeat);
+
+    float side = VIEW_SIZE * std::sqrt((float) AREA_FACTOR);
+    std::printf("surface %.0fx%.0f, %dx the %dx%d view, %d frames\n", side, side, AREA_FACTOR, VIEW_SIZE, VIEW_SIZE, FRAMES);
+    std::printf("%-8s %10s %10s %16s\n", "culling", "update ms", "draw ms", "visible chunks");
+
+    const bool modes[] = { false, true };
+    for (bool culling : modes)
+    {
+        Result result = run(program, texture, side, culling);
+        std::printf("%-8s %10.3f %10.3f %9.1f of %3d\n", culling ? "on" : "off", result.update, result.draw, result.visible, result.chunks);
+    }
+
+    fbo.release();
+    context.doneCurrent();
+    return 0;
+}
@@ -0,0 +1,40 @@
+#-------------------------------------------------
+#
+# Chunked surface benchmark, 10x the visible area
+#
+#-------------------------------------------------
+
+QT       += core gui opengl
+
+CONFIG   += console c++11
+CONFIG   -= app_bundle
+
+TARGET = surface_bench
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES +=\
+    main.cpp \
+    ../../RippleEffect.cpp \
+    ../../RippleSplat.cpp \
+    ../../RippleCompute.cpp \
+    ../../RippleQuadTree.cpp \
+    ../../RippleField.cpp \
+    ../../RippleGeometry.cpp \
+    ../../RippleSurface.cpp \
+    ../../RippleLayout.cpp
+
+HEADERS  += \
+    ../../RippleEffect.h \
+    ../../RippleSplat.h \
+    ../../RippleCompute.h \
+    ../../RippleQuadTree.h \
+    ../../RippleField.h \
+    ../../RippleGeometry.h \
+    ../../RippleSurface.h \
+    ../../RippleLayout.h \
+    ../../RippleTable.h
+
+RESOURCES += \
+    ../../Resources.qrc
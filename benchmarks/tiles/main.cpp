@@ -0,0 +1,272 @@
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLShaderProgram>
+#include <QImage>
+#include <QImageReader>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QMatrix4x4>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "RippleSurface.h"
+#include "TiledTexture.h"
+
+#define VIEW_SIZE               512
+#define POSTER_SIZE             6144        // generated poster, too large for the default budget
+#define CHECKER_SIZE            8           // fine enough that the low resolution copy blurs it away
+#define TILE_BUDGET_MB          32
+#define FRAMES                  600
+#define READY_TIMEOUT_MS        10000       // for the low resolution copy
+#define SETTLE_TIMEOUT_MS       10000       // for the tiles under the still view
+#define FADE_FRAMES             30          // past TiledTexture's fade-in
+#define TEXCOORD_MARGIN         0.02f       // around the view, as GLWidget requests
+#define ERROR_MAX               16.0        // mean channel error of the still view
+
+// Image pixels hold their position in red and green and a fine checker in
+// blue, so a tile in the wrong place or the low resolution copy in place of
+// a tile both show as a large error
+static bool writePoster(const QString& fileName)
+{
+    QImage image(POSTER_SIZE, POSTER_SIZE, QImage::Format_RGB32);
+    for (int y = 0; y < POSTER_SIZE; y++)
+    {
+        QRgb *line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < POSTER_SIZE; x++)
+            line[x] = qRgb(x * 255 / POSTER_SIZE, y * 255 / POSTER_SIZE, (x / CHECKER_SIZE + y / CHECKER_SIZE) % 2 ? 230 : 25);
+    }
+    return image.save(fileName, "JPG", 95);
+}
+
+// The view in image texture coordinates, bottom to top, as GLWidget::textureRect
+static QRectF textureRect(const QRectF& view, const QSize& size)
+{
+    float w = size.width();
+    float h = size.height();
+    return QRectF((view.left() + w/2) / w - TEXCOORD_MARGIN, (view.top() + h/2) / h - TEXCOORD_MARGIN,
+                  view.width() / w + 2*TEXCOORD_MARGIN, view.height() / h + 2*TEXCOORD_MARGIN);
+}
+
+static void drawFrame(QOpenGLShaderProgram& program, TiledTexture& tiled, RippleSurface& surface, const QPointF& pan)
+{
+    QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
+    f->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    QMatrix4x4 projection;
+    projection.ortho(0, VIEW_SIZE, 0, VIEW_SIZE, -1, 1000);
+    QMatrix4x4 matrix;
+    matrix.translate(VIEW_SIZE/2, VIEW_SIZE/2, 0);
+    matrix.translate(-pan.x(), -pan.y(), 0);
+
+    program.bind();
+    tiled.bind(&program);
+    program.setUniformValue("mvp_matrix", projection * matrix);
+    program.setUniformValue("texture", 0);
+    surface.setViewport(QRectF(pan.x() - VIEW_SIZE/2, pan.y() - VIEW_SIZE/2, VIEW_SIZE, VIEW_SIZE));
+    surface.draw();
+    f->glFinish();
+}
+
+// Mean channel difference between the view and the image decoded straight
+// from the file, one surface pixel per image pixel
+static double viewError(QOpenGLFramebufferObject& fbo, const QString& fileName, const QSize& size, const QPointF& pan)
+{
+    int left = qRound(pan.x() - VIEW_SIZE/2 + size.width()/2.f);
+    int top = qRound(size.height()/2.f - pan.y() - VIEW_SIZE/2);
+    QImageReader reader(fileName);
+    reader.setClipRect(QRect(left, top, VIEW_SIZE, VIEW_SIZE));
+    QImage source = reader.read().convertToFormat(QImage::Format_RGB32);
+    QImage view = fbo.toImage().convertToFormat(QImage::Format_RGB32);
+    if (source.size() != view.size())
+        return 255;
+
+    double sum = 0;
+    for (int y = 0; y < VIEW_SIZE; y++)
+    {
+        const QRgb *a = reinterpret_cast<const QRgb*>(source.constScanLine(y));
+        const QRgb *b = reinterpret_cast<const QRgb*>(view.constScanLine(y));
+        for (int x = 0; x < VIEW_SIZE; x++)
+            sum += std::abs(qRed(a[x]) - qRed(b[x])) + std::abs(qGreen(a[x]) - qGreen(b[x])) + std::abs(qBlue(a[x]) - qBlue(b[x]));
+    }
+    return sum / (3.0 * VIEW_SIZE * VIEW_SIZE);
+}
+
+// tile_bench [poster] [--budget MB]
+// Streams a poster through TiledTexture the way TextureManager does for
+// images past the texture size limit or the tile budget: a view of
+// VIEW_SIZE pixels pans once around the image at one image pixel per
+// screen pixel, requesting the tiles under it every frame. Without a
+// poster it writes a POSTER_SIZE one. Prints the time until the low
+// resolution copy shows, the per-frame update time, and how many frames
+// still waited on tiles. Then holds the view still until every tile under
+// it has faded in, and fails when it differs from the image decoded
+// directly by more than ERROR_MAX per channel on average.
+int main(int argc, char *argv[])
+{
+    QElapsedTimer startClock;
+    startClock.start();
+
+    // Runs without a display
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QGuiApplication app(argc, argv);
+
+    QString fileName;
+    qint64 budget = (qint64) TILE_BUDGET_MB << 20;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--budget") == 0 && i+1 < argc)
+        {
+            budget = (qint64) std::atoi(argv[++i]) << 20;
+        }
+        else if (argv[i][0] == '-' || !fileName.isEmpty())
+        {
+            std::fprintf(stderr, "usage: tile_bench [poster] [--budget MB]\n");
+            return 2;
+        }
+        else
+        {
+            fileName = QString::fromLocal8Bit(argv[i]);
+        }
+    }
+    if (budget <= 0)
+    {
+        std::fprintf(stderr, "usage: tile_bench [poster] [--budget MB]\n");
+        return 2;
+    }
+
+    QTemporaryDir dir;
+    if (fileName.isEmpty())
+    {
+        fileName = dir.filePath("poster.jpg");
+        if (!writePoster(fileName))
+        {
+            std::fprintf(stderr, "tile_bench: could not write %s\n", qPrintable(fileName));
+            return 1;
+        }
+    }
+
+    QOffscreenSurface offscreen;
+    offscreen.create();
+
+    QOpenGLContext context;
+    if (!context.create() || !context.makeCurrent(&offscreen))
+    {
+        std::fprintf(stderr, "tile_bench: no OpenGL context\n");
+        return 1;
+    }
+
+    QOpenGLFramebufferObject fbo(VIEW_SIZE, VIEW_SIZE, QOpenGLFramebufferObject::CombinedDepthStencil);
+    fbo.bind();
+
+    QOpenGLFunctions *f = context.functions();
+    f->glViewport(0, 0, VIEW_SIZE, VIEW_SIZE);
+    f->glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    f->glEnable(GL_DEPTH_TEST);
+    f->glEnable(GL_CULL_FACE);
+
+    QOpenGLShaderProgram program;
+    if (!program.addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/vshader.glsl") ||
+        !program.addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/fshader.glsl") ||
+        !program.link())
+    {
+        std::fprintf(stderr, "tile_bench: could not build the shaders\n");
+        return 1;
+    }
+
+    QSize size = QImageReader(fileName).size();
+    if (size.width() < VIEW_SIZE || size.height() < VIEW_SIZE)
+    {
+        std::fprintf(stderr, "tile_bench: %s is smaller than the %dx%d view\n", qPrintable(fileName), VIEW_SIZE, VIEW_SIZE);
+        return 1;
+    }
+    if (!TiledTexture::needsTiles(fileName, budget))
+        std::printf("%s fits the texture size limit and the budget, the app would upload it whole\n", qPrintable(fileName));
+
+    // The surface covers the image one pixel to one, like GLWidget's at zoom 1
+    RippleSurface surface(&program, size.width(), size.height());
+    TiledTexture tiled(fileName, budget);
+    if (!tiled.isValid())
+        return 1;
+    std::printf("poster %dx%d, %.1f MB of video memory for a %d MB budget, %d frames\n",
+                size.width(), size.height(), tiled.memoryUsage() / 1048576.0, (int) (budget >> 20), FRAMES);
+
+    // Until the low resolution copy is up, nothing but the placeholder shows
+    QElapsedTimer clock;
+    clock.start();
+    while (!tiled.isReady() && clock.elapsed() < READY_TIMEOUT_MS)
+    {
+        tiled.update();
+        QThread::msleep(1);
+    }
+    if (!tiled.isReady())
+    {
+        std::fprintf(stderr, "tile_bench: the low resolution copy never arrived\n");
+        return 1;
+    }
+    double readyMs = clock.nsecsElapsed() / 1e6;
+
+    // Pan once around an ellipse that keeps the view on the image
+    double updateMs = 0;
+    double updateMax = 0;
+    int waiting = 0;
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        float angle = frame * 6.2831853f / FRAMES;
+        QPointF pan(std::cos(angle) * (size.width() - VIEW_SIZE) / 2, std::sin(angle) * (size.height() - VIEW_SIZE) / 2);
+        QRectF view(pan.x() - VIEW_SIZE/2, pan.y() - VIEW_SIZE/2, VIEW_SIZE, VIEW_SIZE);
+
+        clock.start();
+        tiled.request(textureRect(view, size));
+        tiled.update();
+        double ms = clock.nsecsElapsed() / 1e6;
+        updateMs += ms / FRAMES;
+        updateMax = qMax(updateMax, ms);
+        waiting += tiled.pendingCount() > 0;
+
+        drawFrame(program, tiled, surface, pan);
+    }
+
+    // Hold still off center until the tiles under the view are in and faded.
+    // Whole pixels, so screen pixels sample image texel centers.
+    QPointF pan(qRound(size.width() / 5.f), qRound(-size.height() / 7.f));
+    QRectF view(pan.x() - VIEW_SIZE/2, pan.y() - VIEW_SIZE/2, VIEW_SIZE, VIEW_SIZE);
+    int settle = 0;
+    int still = 0;
+    clock.start();
+    for (; still < FADE_FRAMES && clock.elapsed() < SETTLE_TIMEOUT_MS; settle++)
+    {
+        tiled.request(textureRect(view, size));
+        tiled.update();
+        still = tiled.pendingCount() > 0 ? 0 : still + 1;
+        QThread::msleep(1);
+    }
+    drawFrame(program, tiled, surface, pan);
+    double error = viewError(fbo, fileName, size, pan);
+
+    std::printf("%-22s %10.2f\n", "low resolution ms", readyMs);
+    std::printf("%-22s %10.3f\n", "update ms mean", updateMs);
+    std::printf("%-22s %10.3f\n", "update ms max", updateMax);
+    std::printf("%-22s %6d of %d\n", "frames waiting", waiting, FRAMES);
+    std::printf("%-22s %10d\n", "tiles resident", tiled.residentCount());
+    std::printf("%-22s %10d\n", "settle frames", settle);
+    std::printf("%-22s %10.2f\n", "still view error", error);
+    std::printf("%-22s %10.2f\n", "total ms", startClock.nsecsElapsed() / 1e6);
+
+    fbo.release();
+    context.doneCurrent();
+
+    if (still < FADE_FRAMES || error > ERROR_MAX)
+    {
+        std::fprintf(stderr, "tile_bench: the still view %s, mean error %.2f, limit %.2f\n",
+                     still < FADE_FRAMES ? "never settled" : "shows the wrong pixels", error, ERROR_MAX);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,43 @@
+#-------------------------------------------------
+#
+# Poster streaming through the tiled virtual texture,
+# timed and compared against the decoded image
+#
+#-------------------------------------------------
+
+QT       += core gui opengl concurrent
+
+CONFIG   += console c++11
+CONFIG   -= app_bundle
+
+TARGET = tile_bench
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES +=\
+    main.cpp \
+    ../../RippleEffect.cpp \
+    ../../RippleSplat.cpp \
+    ../../RippleCompute.cpp \
+    ../../RippleQuadTree.cpp \
+    ../../RippleField.cpp \
+    ../../RippleGeometry.cpp \
+    ../../RippleSurface.cpp \
+    ../../RippleLayout.cpp \
+    ../../TiledTexture.cpp
+
+HEADERS  += \
+    ../../RippleEffect.h \
+    ../../RippleSplat.h \
+    ../../RippleCompute.h \
+    ../../RippleQuadTree.h \
+    ../../RippleField.h \
+    ../../RippleGeometry.h \
+    ../../RippleSurface.h \
+    ../../RippleLayout.h \
+    ../../TiledTexture.h \
+    ../../RippleTable.h
+
+RESOURCES += \
+    ../../Resources.qrc
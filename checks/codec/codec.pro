@@ -0,0 +1,22 @@
+#-------------------------------------------------
+#
+# Block compression round trip, no display or GPU needed
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+CONFIG   += console c++11
+CONFIG   -= app_bundle
+
+TARGET = codec_check
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES +=\
+    main.cpp \
+    ../../TextureCodec.cpp
+
+HEADERS  += \
+    ../../TextureCodec.h
@@ -0,0 +1,263 @@
+#include <QImage>
+#include <QColor>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "TextureCodec.h"
+
+// Worst channel error a flat block may show: 5 bits of red and blue lose
+// up to 7, ETC's smallest modifier adds 2 more
+#define FLAT_ERROR_MAX          9
+#define GRADIENT_PSNR_MIN       28.0        // dB, smooth content
+#define PATTERN_PSNR_MIN        20.0        // dB, two colours per block or half
+#define NOISE_PSNR_MIN          10.0        // dB, no spatial coherence at all
+
+// ETC1 intensity modifiers, as the specification lists them
+static const int etcModifiers[8][4] = {
+    { 2, 8, -2, -8 }, { 5, 17, -5, -17 }, { 9, 29, -9, -29 }, { 13, 42, -13, -42 },
+    { 18, 60, -18, -60 }, { 24, 80, -24, -80 }, { 33, 106, -33, -106 }, { 47, 183, -47, -183 }
+};
+
+static int clamp255(int v)
+{
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+// Reference decoders, written from the format specifications rather than
+// from the encoder, so a layout mistake in either shows as a mismatch.
+// Each writes the 4x4 block at (bx, by) into 'image', clipped to its size.
+static void decodeBC1(const quint8 *in, QImage& image, int bx, int by)
+{
+    int c0 = in[0] | in[1] << 8;
+    int c1 = in[2] | in[3] << 8;
+    quint32 indices = in[4] | in[5] << 8 | in[6] << 16 | (quint32) in[7] << 24;
+
+    int palette[4][3];
+    int ends[2] = { c0, c1 };
+    for (int e = 0; e < 2; e++)
+    {
+        int r = (ends[e] >> 11) & 31, g = (ends[e] >> 5) & 63, b = ends[e] & 31;
+        palette[e][0] = (r << 3) | (r >> 2);
+        palette[e][1] = (g << 2) | (g >> 4);
+        palette[e][2] = (b << 3) | (b >> 2);
+    }
+    for (int c = 0; c < 3; c++)
+    {
+        if (c0 > c1)
+        {
+            palette[2][c] = (2*palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2*palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+        int x = bx + i % 4, y = by + i / 4;
+        if (x < image.width() && y < image.height())
+        {
+            const int *rgb = palette[(indices >> (2*i)) & 3];
+            image.setPixel(x, y, qRgb(rgb[0], rgb[1], rgb[2]));
+        }
+    }
+}
+
+static void decodeETC1(const quint8 *in, QImage& image, int bx, int by)
+{
+    quint32 high = (quint32) in[0] << 24 | in[1] << 16 | in[2] << 8 | in[3];
+    quint32 low = (quint32) in[4] << 24 | in[5] << 16 | in[6] << 8 | in[7];
+    bool diff = high & 2;
+    bool flip = high & 1;
+    int tables[2] = { (int) (high >> 5) & 7, (int) (high >> 2) & 7 };
+
+    int base[2][3];
+    for (int c = 0; c < 3; c++)
+    {
+        int byte = (high >> (24 - 8*c)) & 0xff;
+        if (diff)
+        {
+            int first = byte >> 3;
+            int delta = byte & 7;
+            int second = first + (delta >= 4 ? delta - 8 : delta);
+            base[0][c] = (first << 3) | (first >> 2);
+            base[1][c] = (second << 3) | (second >> 2);
+        }
+        else
+        {
+            base[0][c] = (byte >> 4) * 17;
+            base[1][c] = (byte & 15) * 17;
+        }
+    }
+
+    for (int y = 0; y < 4; y++)
+    {
+        for (int x = 0; x < 4; x++)
+        {
+            int half = flip ? y / 2 : x / 2;
+            int i = x*4 + y;
+            int index = ((low >> (16 + i)) & 1) << 1 | ((low >> i) & 1);
+            int modifier = etcModifiers[tables[half]][index];
+            if (bx + x < image.width() && by + y < image.height())
+                image.setPixel(bx + x, by + y, qRgb(clamp255(base[half][0] + modifier), clamp255(base[half][1] + modifier),
+                                                    clamp255(base[half][2] + modifier)));
+        }
+    }
+}
+
+static QImage decode(const QByteArray& data, int w, int h, QOpenGLTexture::TextureFormat format)
+{
+    QImage image(w, h, QImage::Format_RGB32);
+    const quint8 *in = reinterpret_cast<const quint8*>(data.constData());
+    for (int by = 0; by < h; by += 4)
+    {
+        for (int bx = 0; bx < w; bx += 4)
+        {
+            if (format == QOpenGLTexture::RGB_DXT1)
+                decodeBC1(in, image, bx, by);
+            else
+                decodeETC1(in, image, bx, by);
+            in += 8;
+        }
+    }
+    return image;
+}
+
+// Largest channel difference and PSNR over the colour channels
+static void compare(const QImage& source, const QImage& decoded, int *maxError, double *psnr)
+{
+    double squares = 0;
+    *maxError = 0;
+    for (int y = 0; y < source.height(); y++)
+    {
+        for (int x = 0; x < source.width(); x++)
+        {
+            QColor a = source.pixelColor(x, y);
+            QColor b = decoded.pixelColor(x, y);
+            int d[3] = { a.red() - b.red(), a.green() - b.green(), a.blue() - b.blue() };
+            for (int c = 0; c < 3; c++)
+            {
+                *maxError = qMax(*maxError, std::abs(d[c]));
+                squares += d[c] * d[c];
+            }
+        }
+    }
+    double mse = squares / (3.0 * source.width() * source.height());
+    *psnr = mse > 0 ? 10 * std::log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+// Test images, RGBA8888 as TextureLoader hands them to the codec
+static QImage flat(int w, int h, QRgb colour)
+{
+    QImage image(w, h, QImage::Format_RGBA8888);
+    image.fill(QColor::fromRgb(colour));
+    return image;
+}
+
+static QImage gradient(int w, int h)
+{
+    QImage image(w, h, QImage::Format_RGBA8888);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            image.setPixelColor(x, y, QColor(x * 255 / qMax(1, w-1), y * 255 / qMax(1, h-1), (x + y) * 255 / qMax(1, w+h-2)));
+    return image;
+}
+
+// Two colours down alternate columns, so a block decoded transposed
+// shows it at once
+static QImage stripes(int w, int h)
+{
+    QImage image(w, h, QImage::Format_RGBA8888);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            image.setPixelColor(x, y, x % 2 ? QColor(200, 220, 240) : QColor(30, 50, 70));
+    return image;
+}
+
+// Flat left halves, high contrast right halves, so each half of an ETC
+// block needs a different modifier table
+static QImage halves(int w, int h)
+{
+    QImage image(w, h, QImage::Format_RGBA8888);
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            image.setPixelColor(x, y, x % 4 < 2 ? QColor(128, 128, 128) : (y % 2 ? QColor(220, 220, 220) : QColor(40, 40, 40)));
+    return image;
+}
+
+static QImage noise(int w, int h)
+{
+    QImage image(w, h, QImage::Format_RGBA8888);
+    unsigned seed = 1;
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            image.setPixelColor(x, y, QColor((seed >> 8) & 255, (seed >> 16) & 255, (seed >> 24) & 255));
+        }
+    }
+    return image;
+}
+
+// codec_check
+// Encodes test images with TextureCodec in both block formats, decodes
+// them with the reference decoders above and fails when flat colours move
+// more than the formats' quantization allows or smooth and noisy images
+// fall below their PSNR floor. Odd sizes cover the repeated edge pixels.
+// Needs Qt's image classes, but no display or GPU.
+int main()
+{
+    struct Case
+    {
+        const char *name;
+        QImage image;
+        bool flat;
+        double psnrMin;
+    };
+
+    const Case cases[] = {
+        { "black",       flat(8, 8, qRgb(0, 0, 0)),        true,  0 },
+        { "white",       flat(8, 8, qRgb(255, 255, 255)),  true,  0 },
+        { "water",       flat(8, 8, qRgb(40, 110, 160)),   true,  0 },
+        { "odd flat",    flat(7, 5, qRgb(200, 60, 20)),    true,  0 },
+        { "gradient",    gradient(64, 64),                 false, GRADIENT_PSNR_MIN },
+        { "odd gradient", gradient(30, 17),                false, GRADIENT_PSNR_MIN },
+        { "stripes",     stripes(16, 16),                  false, PATTERN_PSNR_MIN },
+        { "halves",      halves(16, 16),                   false, PATTERN_PSNR_MIN },
+        { "noise",       noise(32, 32),                    false, NOISE_PSNR_MIN }
+    };
+    const QOpenGLTexture::TextureFormat formats[] = { QOpenGLTexture::RGB_DXT1, QOpenGLTexture::RGB8_ETC2 };
+    const char *formatNames[] = { "BC1", "ETC1" };
+
+    int failed = 0;
+    std::printf("%-13s %-5s %10s %9s\n", "image", "codec", "max error", "psnr dB");
+    for (const Case& test : cases)
+    {
+        for (int f = 0; f < 2; f++)
+        {
+            int w = test.image.width(), h = test.image.height();
+            QByteArray data = TextureCodec::encode(test.image, formats[f]);
+            bool sized = data.size() == TextureCodec::levelSize(w, h);
+
+            int maxError = 0;
+            double psnr = 0;
+            if (sized)
+                compare(test.image, decode(data, w, h, formats[f]), &maxError, &psnr);
+
+            bool ok = sized && (test.flat ? maxError <= FLAT_ERROR_MAX : psnr >= test.psnrMin);
+            std::printf("%-13s %-5s %10d %9.2f%s\n", test.name, formatNames[f], maxError, psnr, ok ? "" : "  FAIL");
+            failed += !ok;
+        }
+    }
+
+    if (failed > 0)
+    {
+        std::fprintf(stderr, "%d images decoded outside their bounds\n", failed);
+        return 1;
+    }
+    return 0;
+}
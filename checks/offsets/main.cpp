@@ -0,0 +1,145 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "RippleField.h"
+
+#define AREA_SIZE               ((float) SURFACE_CHUNK_SIZE)    // pixels one effect covers at most
+#define MAX_ERROR_PX            1.f
+#define CASE_FRAMES             120         // frames each case is compared over
+#define STACK_COUNT             16          // ripples on one spot, peaks well past a single ripple's
+
+// One comparison of the float and compact vertex formats
+struct Case
+{
+    const char *name;
+    int grid;
+    int ripples;
+    bool stacked;               // all at the surface center, started together
+};
+
+static const Case cases[] =
+{
+    { "single",      32,  1,                false },
+    { "scattered",   32,  16,               false },
+    { "scattered",   128, 16,               false },
+    { "dense",       32,  256,              false },
+    { "dense",       128, 256,              false },
+    { "stacked",     32,  STACK_COUNT,      true  },
+    { "stacked",     128, STACK_COUNT,      true  },
+    { "full pool",   32,  RIPPLE_POOL_SIZE, true  }
+};
+
+struct Result
+{
+    long vertices;
+    long clamped;               // past +/-RIPPLE_OFFSET_RANGE
+    float maxError;             // pixels
+    float maxOffset;            // pixels, the largest float offset
+    long failures;
+};
+
+// Displacements of both formats for every frame of one case: float in
+// pixels as the vertices backend keeps them, compact in texture units
+// packed and unpacked as the shader sees them, then scaled to pixels
+static Result run(const Case& test)
+{
+    std::mt19937 random(test.grid * 1000 + test.ripples);
+    std::uniform_real_distribution<float> position(0, AREA_SIZE);
+    std::uniform_int_distribution<int> start(0, CASE_FRAMES / 2);
+
+    RippleField field(AREA_SIZE, AREA_SIZE, test.grid, test.grid);
+    std::vector<int> starts(test.ripples);
+    std::vector<float> xs(test.ripples);
+    std::vector<float> ys(test.ripples);
+    for (int i = 0; i < test.ripples; i++)
+    {
+        starts[i] = test.stacked ? 0 : start(random);
+        xs[i] = test.stacked ? AREA_SIZE / 2 : position(random);
+        ys[i] = test.stacked ? AREA_SIZE / 2 : position(random);
+    }
+
+    int size = (test.grid + 1) * (test.grid + 1);
+    std::vector<float> floats(2 * size);
+    std::vector<short> packed(2 * size);
+    std::vector<float> units(2 * size);
+    Result result = { 0, 0, 0, 0, 0 };
+
+    for (int frame = 0; frame < CASE_FRAMES; frame++)
+    {
+        for (int i = 0; i < test.ripples; i++)
+            if (starts[i] == frame)
+                field.addRipple(xs[i], ys[i]);
+        field.advance(1);
+
+        field.evaluate(AREA_SIZE, AREA_SIZE, [&](int offset, float ox, float oy) {
+            floats[2*offset] = ox;
+            floats[2*offset+1] = oy;
+        });
+        field.evaluate(1, 1, [&](int offset, float ox, float oy) {
+            units[2*offset] = ox;
+            units[2*offset+1] = oy;
+            packed[2*offset] = packOffsetValue(ox);
+            packed[2*offset+1] = packOffsetValue(oy);
+        });
+
+        for (int y = 1; y < test.grid; y++)
+        {
+            for (int x = 1; x < test.grid; x++)
+            {
+                int offset = y*(test.grid+1)+x;
+                result.vertices++;
+                bool clamped = false;
+                float error = 0;
+                for (int c = 2*offset; c < 2*offset+2; c++)
+                {
+                    float compact = unpackOffsetValue(packed[c]) * AREA_SIZE;
+                    error = std::fmax(error, std::fabs(compact - floats[c]));
+                    clamped |= std::fabs(units[c]) > RIPPLE_OFFSET_RANGE;
+                    result.maxOffset = std::fmax(result.maxOffset, std::fabs(floats[c]));
+                }
+                result.clamped += clamped;
+                result.maxError = std::fmax(result.maxError, error);
+                if (clamped || error > MAX_ERROR_PX)
+                    result.failures++;
+            }
+        }
+    }
+    return result;
+}
+
+// offsets_check
+// Runs RippleField into the float and the compact vertex format and fails
+// when a compact offset lands more than a pixel from the float one, on an
+// effect of the largest chunk size, or clamps at +/-RIPPLE_OFFSET_RANGE.
+// A full pool stacked on one spot sums close to the range.
+int main()
+{
+    long failures = 0;
+
+    // The range holds as long as no ripple adds more than RIPPLE_AMP_MAX
+    for (int i = 0; i < RIPPLE_LENGTH; i++)
+    {
+        if (std::fabs(g_ripple_amp[i].amplitude) > RIPPLE_AMP_MAX)
+        {
+            std::fprintf(stderr, "amplitude %d is %f, past RIPPLE_AMP_MAX\n", i, g_ripple_amp[i].amplitude);
+            return 1;
+        }
+    }
+
+    std::printf("%-10s %5s %8s %10s %9s %13s %14s\n", "case", "grid", "ripples", "vertices", "clamped", "max error px", "max offset px");
+    for (const Case& test : cases)
+    {
+        Result result = run(test);
+        std::printf("%-10s %5d %8d %10ld %9ld %13.4f %14.2f%s\n", test.name, test.grid, test.ripples, result.vertices,
+                    result.clamped, result.maxError, result.maxOffset, result.failures ? "  FAIL" : "");
+        failures += result.failures;
+    }
+
+    if (failures > 0)
+    {
+        std::fprintf(stderr, "%ld offsets clamped or off by more than %.0f px\n", failures, MAX_ERROR_PX);
+        return 1;
+    }
+    return 0;
+}
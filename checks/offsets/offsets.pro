@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# Compact offset precision check, no GPU or Qt needed
+#
+#-------------------------------------------------
+
+CONFIG   += console c++11
+CONFIG   -= qt app_bundle
+
+TARGET = offsets_check
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES +=\
+    main.cpp \
+    ../../RippleField.cpp \
+    ../../RippleGeometry.cpp
+
+HEADERS  += \
+    ../../RippleField.h \
+    ../../RippleGeometry.h \
+    ../../RippleTable.h
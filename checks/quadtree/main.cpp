@@ -0,0 +1,154 @@
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "RippleQuadTree.h"
+#include "RippleTable.h"
+
+#define RANDOM_CASES            200
+#define RANDOM_ANNULI_MAX       12
+
+// One tree to build and check
+struct Case
+{
+    const char *name;
+    int coarse;
+    int fine;
+    std::vector<RippleQuadTree::Annulus> annuli;    // in finest cells
+};
+
+// Leaves that share an edge are at most one level apart
+static int checkBalance(const RippleQuadTree& tree)
+{
+    int failures = 0;
+    int n = tree.size();
+    for (int y = 0; y < n; y++)
+    {
+        for (int x = 0; x < n; x++)
+        {
+            int depth = tree.depthAt(x, y);
+            int neighbours[] = { tree.depthAt(x+1, y), tree.depthAt(x, y+1) };
+            for (int neighbour : neighbours)
+                if (neighbour >= 0 && std::abs(neighbour - depth) > 1)
+                    failures++;
+        }
+    }
+    return failures;
+}
+
+// The triangles tile the square without cracks: all wind the same way as
+// the uniform mesh, clockwise with rows running down, their areas add up
+// to the square, and every edge inside it is shared by exactly two
+// triangles running it in opposite directions. A T-junction leaves the
+// long edge and the two short ones unmatched.
+static int checkStitching(const RippleQuadTree& tree)
+{
+    const std::vector<RippleQuadTree::Point>& points = tree.vertices();
+    const std::vector<unsigned short>& indices = tree.indices();
+    int n = tree.size();
+    int failures = 0;
+
+    long long area = 0;
+    std::map<std::pair<int, int>, int> edges;     // directed edge, times used
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const RippleQuadTree::Point &a = points[indices[i]];
+        const RippleQuadTree::Point &b = points[indices[i+1]];
+        const RippleQuadTree::Point &c = points[indices[i+2]];
+        long long twice = (long long) (b.y - a.y) * (c.x - a.x) - (long long) (b.x - a.x) * (c.y - a.y);
+        if (twice <= 0)
+            failures++;
+        area += twice;
+
+        for (int k = 0; k < 3; k++)
+            edges[std::make_pair((int) indices[i+k], (int) indices[i+(k+1)%3])]++;
+    }
+    if (area != 2LL * n * n)
+        failures++;
+
+    for (const auto& edge : edges)
+    {
+        const RippleQuadTree::Point &a = points[edge.first.first];
+        const RippleQuadTree::Point &b = points[edge.first.second];
+        bool border = (a.x == b.x && (a.x == 0 || a.x == n)) || (a.y == b.y && (a.y == 0 || a.y == n));
+        auto reverse = edges.find(std::make_pair(edge.first.second, edge.first.first));
+        int opposite = reverse == edges.end() ? 0 : reverse->second;
+        if (edge.second != 1 || opposite != (border ? 0 : 1))
+            failures++;
+    }
+    return failures;
+}
+
+static std::vector<Case> buildCases()
+{
+    int n = 1 << QUADTREE_DEPTH_MAX;
+    float h = n / 2.f;
+    std::vector<Case> cases = {
+        { "calm",        QUADTREE_DEPTH_COARSE, QUADTREE_DEPTH_MAX, {} },
+        { "center",      QUADTREE_DEPTH_COARSE, QUADTREE_DEPTH_MAX, { { h, h, 10, 14 } } },
+        { "corner",      QUADTREE_DEPTH_COARSE, QUADTREE_DEPTH_MAX, { { 0, 0, 30, 33 } } },
+        { "outside",     QUADTREE_DEPTH_COARSE, QUADTREE_DEPTH_MAX, { { -40, h, 45, 50 } } },
+        { "thin ring",   0,                     QUADTREE_DEPTH_MAX, { { h, h, 50, 50.5f } } },
+        { "overlapping", QUADTREE_DEPTH_COARSE, QUADTREE_DEPTH_MAX, { { h - 20, h, 5, 25 }, { h + 20, h, 5, 25 } } },
+        { "flat",        3,                     3,                  { { h, h, 10, 14 } } }
+    };
+
+    // Fixed seed, so a failure reproduces
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position(-n / 4.f, n * 1.25f);
+    std::uniform_real_distribution<float> radius(0, (float) n);
+    std::uniform_real_distribution<float> width(0.5f, 12);
+    std::uniform_int_distribution<int> annuli(1, RANDOM_ANNULI_MAX);
+    std::uniform_int_distribution<int> coarse(0, QUADTREE_DEPTH_COARSE + 1);
+    for (int i = 0; i < RANDOM_CASES; i++)
+    {
+        Case test = { "random", coarse(random), QUADTREE_DEPTH_MAX, {} };
+        for (int k = annuli(random); k > 0; k--)
+        {
+            float inner = radius(random);
+            test.annuli.push_back(RippleQuadTree::Annulus{ position(random), position(random), inner, inner + width(random) });
+        }
+        cases.push_back(test);
+    }
+    return cases;
+}
+
+// quadtree_check
+// Builds RippleQuadTree over fixed and random ripple sets and fails when
+// neighbouring leaves are more than one level apart or the triangulation
+// has a crack, an overlap or a flipped triangle.
+int main()
+{
+    int failed = 0;
+    int random = 0;
+    RippleQuadTree tree;
+    for (const Case& test : buildCases())
+    {
+        tree.setDepth(test.coarse, test.fine);
+        tree.build(test.annuli);
+
+        int unbalanced = checkBalance(tree);
+        int cracks = checkStitching(tree);
+        bool quiet = std::string(test.name) == "random";
+        if (!quiet || unbalanced || cracks)
+        {
+            std::printf("%-12s depth %d-%d, %2d annuli: %5d leaves, %5d triangles, %d unbalanced, %d bad edges%s\n",
+                        test.name, test.coarse, test.fine, (int) test.annuli.size(), tree.leafCount(),
+                        (int) tree.indices().size() / 3, unbalanced, cracks, unbalanced || cracks ? "  FAIL" : "");
+        }
+        random += quiet;
+        if (unbalanced || cracks)
+            failed++;
+    }
+    std::printf("%d random trees checked\n", random);
+
+    if (failed > 0)
+    {
+        std::fprintf(stderr, "%d trees unbalanced or cracked\n", failed);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,21 @@
+#-------------------------------------------------
+#
+# Adaptive mesh balance and stitching check, no GPU or Qt needed
+#
+#-------------------------------------------------
+
+CONFIG   += console c++11
+CONFIG   -= qt app_bundle
+
+TARGET = quadtree_check
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES +=\
+    main.cpp \
+    ../../RippleQuadTree.cpp
+
+HEADERS  += \
+    ../../RippleQuadTree.h \
+    ../../RippleTable.h
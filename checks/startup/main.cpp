@@ -0,0 +1,189 @@
+#include <QCoreApplication>
+#include <QSemaphore>
+#include <QMutex>
+#include <QThread>
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "StartupGraph.h"
+
+#define RANDOM_GRAPHS           100
+#define RANDOM_TASKS            40
+#define OVERLAP_TIMEOUT_MS      5000        // a GL task waits this long for a worker task to start
+
+// What each task saw when it ran, in the order of one shared counter
+struct Trace
+{
+    std::vector<int> begin;     // -1 while not run
+    std::vector<int> end;
+    std::vector<int> runs;
+    std::vector<QThread*> threads;
+    std::atomic<int> clock;
+    QMutex mutex;
+
+    explicit Trace(int count) : begin(count, -1), end(count, -1), runs(count, 0), threads(count, nullptr), clock(0) { }
+
+    std::function<void()> task(int index)
+    {
+        return [this, index]() {
+            int stamp = clock++;
+            QMutexLocker lock(&mutex);
+            begin[index] = stamp;
+            runs[index]++;
+            threads[index] = QThread::currentThread();
+            lock.unlock();
+            end[index] = clock++;
+        };
+    }
+};
+
+struct Spec
+{
+    StartupGraph::Thread thread;
+    std::vector<int> after;
+};
+
+// Every task ran once, after all it follows had ended; GL tasks ran on
+// the calling thread, worker tasks off it
+static int checkOrder(const std::vector<Spec>& specs, const Trace& trace)
+{
+    int failures = 0;
+    for (size_t i = 0; i < specs.size(); i++)
+    {
+        if (trace.runs[i] != 1)
+            failures++;
+        for (int before : specs[i].after)
+            if (trace.end[before] < 0 || trace.begin[i] < trace.end[before])
+                failures++;
+        bool onCaller = trace.threads[i] == QThread::currentThread();
+        if (onCaller != (specs[i].thread == StartupGraph::eThreadGL))
+            failures++;
+    }
+
+    // Ready GL tasks run first added first: a GL task never starts before
+    // an earlier GL task that was already free to run
+    for (size_t i = 0; i < specs.size(); i++)
+    {
+        for (size_t j = 0; j < i; j++)
+        {
+            if (specs[i].thread != StartupGraph::eThreadGL || specs[j].thread != StartupGraph::eThreadGL || !specs[j].after.empty())
+                continue;
+            if (trace.begin[i] < trace.begin[j])
+                failures++;
+        }
+    }
+    return failures;
+}
+
+static int runGraph(const std::vector<Spec>& specs)
+{
+    Trace trace((int) specs.size());
+    StartupGraph graph;
+    for (size_t i = 0; i < specs.size(); i++)
+        graph.add(QString("task %1").arg((int) i), specs[i].thread, trace.task((int) i), specs[i].after);
+    graph.run();
+    return checkOrder(specs, trace);
+}
+
+// The start-up graph GLWidget::initializeGL builds
+static int checkStartup()
+{
+    const StartupGraph::Thread gl = StartupGraph::eThreadGL;
+    const StartupGraph::Thread worker = StartupGraph::eThreadWorker;
+    std::vector<Spec> specs = {
+        { gl, {} },                     // textures
+        { worker, {} },                 // tables, one per mesh level
+        { worker, {} },
+        { worker, {} },
+        { gl, {} },                     // shaders
+        { gl, { 1, 2, 3, 4 } },         // meshes
+        { gl, {} }                      // queries
+    };
+    return runGraph(specs);
+}
+
+// A GL task that only finishes once a worker task has started: worker
+// tasks must be handed out before the calling thread runs GL work
+static int checkOverlap()
+{
+    QSemaphore started;
+    bool overlapped = false;
+    StartupGraph graph;
+    graph.add("worker", StartupGraph::eThreadWorker, [&]() { started.release(); });
+    graph.add("gl", StartupGraph::eThreadGL, [&]() { overlapped = started.tryAcquire(1, OVERLAP_TIMEOUT_MS); });
+    graph.run();
+    return overlapped ? 0 : 1;
+}
+
+// Tasks that wait on each other end the run instead of hanging it, and
+// neither of them runs
+static int checkCycle()
+{
+    Trace trace(3);
+    StartupGraph graph;
+    graph.add("free", StartupGraph::eThreadGL, trace.task(0));
+    graph.add("first", StartupGraph::eThreadGL, trace.task(1), { 2 });
+    graph.add("second", StartupGraph::eThreadWorker, trace.task(2), { 1 });
+    graph.run();
+    return trace.runs[0] == 1 && trace.runs[1] == 0 && trace.runs[2] == 0 ? 0 : 1;
+}
+
+// Random graphs, each task following some of the ones added before it
+static int checkRandom()
+{
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> kind(0, 1);
+    std::uniform_int_distribution<int> fanIn(0, 3);
+    int failures = 0;
+    for (int graph = 0; graph < RANDOM_GRAPHS; graph++)
+    {
+        std::vector<Spec> specs;
+        for (int i = 0; i < RANDOM_TASKS; i++)
+        {
+            Spec spec = { kind(random) ? StartupGraph::eThreadGL : StartupGraph::eThreadWorker, {} };
+            for (int k = i > 0 ? fanIn(random) : 0; k > 0; k--)
+                spec.after.push_back(std::uniform_int_distribution<int>(0, i-1)(random));
+            specs.push_back(spec);
+        }
+        failures += runGraph(specs) > 0;
+    }
+    return failures;
+}
+
+// startup_check
+// Runs StartupGraph over the start-up graph, random graphs and a cycle and
+// fails when a task runs before one it follows, runs twice or on the wrong
+// thread, when worker tasks do not overlap GL work, or when a cycle hangs.
+// Needs Qt's core and concurrent modules, but no display or GPU.
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    struct Check
+    {
+        const char *name;
+        int (*run)();
+    };
+    const Check checks[] = {
+        { "startup",  checkStartup },
+        { "overlap",  checkOverlap },
+        { "cycle",    checkCycle },
+        { "random",   checkRandom }
+    };
+
+    int failed = 0;
+    for (const Check& check : checks)
+    {
+        int failures = check.run();
+        std::printf("%-8s %s\n", check.name, failures ? "FAIL" : "ok");
+        failed += failures > 0;
+    }
+
+    if (failed > 0)
+    {
+        std::fprintf(stderr, "%d start-up graph checks failed\n", failed);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# Start-up task graph ordering, no display or GPU needed
+#
+#-------------------------------------------------
+
+QT       += core concurrent
+QT       -= gui
+
+CONFIG   += console c++11
+CONFIG   -= app_bundle
+
+TARGET = startup_check
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES +=\
+    main.cpp \
+    ../../StartupGraph.cpp
+
+HEADERS  += \
+    ../../StartupGraph.h
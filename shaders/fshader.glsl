@@ -6,11 +6,45 @@ precision mediump float;
 
 uniform sampler2D texture;
 
+// Tiled images: texture holds the tile cache, page_table maps each image
+// tile to its cache slot, fallback is the whole image at a lower mip
+uniform bool tiled;
+uniform sampler2D page_table;
+uniform sampler2D fallback;
+uniform vec2 tile_count;
+uniform vec2 tile_scale;
+uniform vec2 atlas_slot;
+uniform vec2 atlas_border;
+uniform vec2 atlas_tile;
+
 varying vec2 v_texcoord;
 
+vec4 sampleTiled(vec2 texcoord)
+{
+    // Repeat like the plain texture
+    vec2 image = fract(texcoord);
+    vec4 low = texture2D(fallback, image);
+
+    vec2 tile = image * tile_scale;
+    vec2 index = min(floor(tile), tile_count - 1.0);
+    vec4 entry = texture2D(page_table, (index + 0.5) / tile_count);
+    if (entry.a < 0.5)
+        return low;
+
+    vec2 slot = floor(entry.xy * 255.0 + 0.5);
+    vec2 uv = slot * atlas_slot + atlas_border + (tile - index) * atlas_tile;
+    return mix(low, texture2D(texture, uv), entry.z);
+}
+
 void main()
 {
+    // Images are uploaded with rows top to bottom, texture coordinates
+    // run bottom to top
+    vec2 texcoord = vec2(v_texcoord.x, 1.0 - v_texcoord.y);
+
     // Set fragment color from texture
-    gl_FragColor = texture2D(texture, v_texcoord);
+    if (tiled)
+        gl_FragColor = sampleTiled(texcoord);
+    else
+        gl_FragColor = texture2D(texture, texcoord);
 }
-
@@ -0,0 +1,15 @@
+#ifdef GL_ES
+// Set default precision to medium
+precision mediump int;
+precision mediump float;
+#endif
+
+uniform sampler2D image;
+
+varying vec2 v_texcoord;
+
+void main()
+{
+    // Premultiplied alpha, blended with ONE, ONE_MINUS_SRC_ALPHA
+    gl_FragColor = texture2D(image, v_texcoord);
+}
@@ -0,0 +1,19 @@
+#ifdef GL_ES
+// Set default precision to medium
+precision mediump int;
+precision mediump float;
+#endif
+
+// Overlay rectangle in clip space: left, bottom, width, height
+uniform vec4 rect;
+
+attribute vec2 a_corner;
+
+varying vec2 v_texcoord;
+
+void main()
+{
+    // Image rows run top down
+    v_texcoord = vec2(a_corner.x, 1.0 - a_corner.y);
+    gl_Position = vec4(rect.xy + a_corner * rect.zw, 0.0, 1.0);
+}
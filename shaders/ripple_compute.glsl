@@ -0,0 +1,81 @@
+// The version line, precision and OUTPUT_* define are prepended at load time
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+struct RippleVector
+{
+    float dx;
+    float dy;
+    int r;
+};
+
+// x, y in grid vertices, wavefront distance, envelope
+layout(std430, binding = 0) readonly buffer Ripples { vec4 ripples[]; };
+layout(std430, binding = 1) readonly buffer Vectors { RippleVector vectors[]; };
+layout(std430, binding = 2) readonly buffer Amps { float amps[]; };
+
+#if defined(OUTPUT_POSITIONS)
+layout(std430, binding = 3) writeonly buffer Output { float data[]; };
+#elif defined(OUTPUT_TEXCOORDS)
+layout(std430, binding = 3) writeonly buffer Output { vec2 data[]; };
+#else
+layout(std430, binding = 3) writeonly buffer Output { uint data[]; };
+#endif
+
+uniform ivec2 grid_size;
+uniform ivec2 first_vertex;     // pinned edges stay at rest
+uniform ivec2 last_vertex;
+uniform int ripple_count;
+uniform int ripple_length;
+uniform vec2 image_origin;
+uniform vec2 image_size;
+uniform vec2 reference_size;
+uniform float cell_length;
+uniform float offset_range;
+
+void main()
+{
+    ivec2 v = ivec2(gl_GlobalInvocationID.xy) + first_vertex;
+    if (v.x > last_vertex.x || v.y > last_vertex.y)
+        return;
+
+    vec2 offset = vec2(0.0);
+    for (int i = 0; i < ripple_count; i++)
+    {
+        vec4 ripple = ripples[i];
+        ivec2 m = v - ivec2(ripple.xy);
+        ivec2 a = abs(m);
+
+        // Ripples of neighbouring chunks may lie beyond the table
+        RippleVector vector;
+        if (a.x <= grid_size.x && a.y <= grid_size.y)
+        {
+            vector = vectors[a.y*(grid_size.x+1)+a.x];
+        }
+        else
+        {
+            vec2 f = vec2(a) * reference_size / vec2(grid_size);
+            vector.dx = f.x / length(f);
+            vector.dy = f.y / length(f);
+            vector.r = int(length(f) * cell_length);
+        }
+        int r = clamp(int(ripple.z) - vector.r, 0, ripple_length-1);
+
+        vec2 dir = vec2(m.x < 0 ? -vector.dx : vector.dx, m.y < 0 ? -vector.dy : vector.dy);
+        offset += dir * amps[r] * ripple.w;
+    }
+
+    int idx = v.y*(grid_size.x+1)+v.x;
+    vec2 texcoord = vec2(v.x, grid_size.y-v.y) / vec2(grid_size);
+
+#if defined(OUTPUT_POSITIONS)
+    vec2 position = image_origin + (texcoord - 0.5) * image_size + offset * image_size;
+    data[idx*3] = position.x;
+    data[idx*3+1] = position.y;
+    data[idx*3+2] = 0.0;
+#elif defined(OUTPUT_TEXCOORDS)
+    data[idx] = texcoord + offset;
+#else
+    data[idx] = packSnorm2x16(offset / offset_range);
+#endif
+}
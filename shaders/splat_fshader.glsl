@@ -0,0 +1,30 @@
+#ifdef GL_ES
+// Set default precision to high, grid offsets must stay exact
+precision highp int;
+precision highp float;
+#endif
+
+uniform sampler2D amplitude;
+uniform vec2 cell_scale;
+uniform float cell_length;
+uniform float ripple_length;
+
+varying vec2 v_cell;
+varying float v_delta;
+varying float v_amp;
+
+void main()
+{
+    // Same lookup as the CPU kernel: whole grid offsets, truncated distance
+    vec2 f = floor(v_cell + 0.5) * cell_scale;
+    float d = length(f);
+    float r = v_delta - floor(d * cell_length);
+
+    // Ahead of the wavefront or fully decayed behind it
+    if (r < 0.0 || r > ripple_length - 1.0)
+        discard;
+
+    float amp = texture2D(amplitude, vec2((r + 0.5) / ripple_length, 0.5)).r * v_amp;
+    vec2 dir = d > 0.0 ? f / d : vec2(0.0);
+    gl_FragColor = vec4(dir * amp, 0.0, 0.0);
+}
@@ -0,0 +1,29 @@
+#ifdef GL_ES
+// Set default precision to high, grid offsets must stay exact
+precision highp int;
+precision highp float;
+#endif
+
+uniform vec2 field_size;
+uniform vec2 cell_scale;
+uniform float cell_length;
+
+attribute vec2 a_corner;
+attribute vec4 a_ripple;
+
+varying vec2 v_cell;
+varying float v_delta;
+varying float v_amp;
+
+void main()
+{
+    // Cover the disc the wavefront has reached, one cell of margin
+    vec2 radius = a_ripple.z / (cell_length * cell_scale) + 1.0;
+    v_cell = a_corner * radius;
+    v_delta = a_ripple.z;
+    v_amp = a_ripple.w;
+
+    // Grid vertex i sits on the center of texel i
+    vec2 vertex = a_ripple.xy + v_cell;
+    gl_Position = vec4((vertex + 0.5) / (field_size + 1.0) * 2.0 - 1.0, 0.0, 1.0);
+}
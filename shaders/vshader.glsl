@@ -6,17 +6,54 @@ precision mediump float;
 
 uniform mat4 mvp_matrix;
 
+// Compact vertex format: texcoords are stored as normalized shorts and the
+// ripple displacement arrives as a separate normalized offset
+uniform vec2 texcoord_scale;
+uniform vec2 texcoord_bias;
+uniform float offset_range;
+uniform vec2 position_offset_scale;
+uniform vec2 texcoord_offset_scale;
+
+// Part of the image a chunk of a larger surface shows
+uniform vec4 texture_rect;
+
+// Keyframed simulation: blend from the previous result to the current one
+uniform float frame_blend;
+
+// Texture backend: displacement sampled from the simulation grid, which
+// may be coarser or finer than the mesh
+uniform bool field_enabled;
+uniform vec2 field_size;
+uniform sampler2D displacement;
+uniform sampler2D displacement_prev;
+
 attribute vec4 a_position;
 attribute vec2 a_texcoord;
+attribute vec2 a_offset;
+attribute vec2 a_offset_prev;
 
 varying vec2 v_texcoord;
 
 void main()
 {
+    vec2 texcoord = a_texcoord * texcoord_scale + texcoord_bias;
+    vec2 offset = mix(a_offset_prev, a_offset, frame_blend) * offset_range;
+
+    if (field_enabled)
+    {
+        // Grid rows run top to bottom, texel centers sit on grid vertices
+        vec2 cell = vec2(texcoord.x, 1.0 - texcoord.y) * field_size;
+        vec2 uv = (cell + 0.5) / (field_size + 1.0);
+        vec2 field = texture2DLod(displacement, uv, 0.0).rg;
+        if (frame_blend < 1.0)
+            field = mix(texture2DLod(displacement_prev, uv, 0.0).rg, field, frame_blend);
+        offset += field;
+    }
+
     // Calculate vertex position in screen space
-    gl_Position = mvp_matrix * a_position;
+    gl_Position = mvp_matrix * (a_position + vec4(offset * position_offset_scale, 0.0, 0.0));
 
     // Pass texture coordinate to fragment shader
     // Value will be automatically interpolated to fragments inside polygon faces
-    v_texcoord = a_texcoord;
+    v_texcoord = texture_rect.xy + (texcoord + offset * texcoord_offset_scale) * texture_rect.zw;
 }